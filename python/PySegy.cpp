@@ -9,9 +9,13 @@
 ** @Description :
 *********************************************************************/
 
+#include "multi.h"
 #include "segy.h"
+#include "stream.h"
+#include "writer.h"
 #include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 #include <utility>
 
 namespace py = pybind11;
@@ -19,12 +23,17 @@ namespace py = pybind11;
 class Pysegy : public segy::SegyIO {
 public:
   using segy::SegyIO::create;
+  using segy::SegyIO::dead_mask;
   using segy::SegyIO::read;
+  using segy::SegyIO::read_as;
   using segy::SegyIO::read_cross_slice;
   using segy::SegyIO::read_inline_slice;
   using segy::SegyIO::read_time_slice;
   using segy::SegyIO::read_trace;
+  using segy::SegyIO::read_with_stats;
   using segy::SegyIO::SegyIO;
+  using segy::SegyIO::fill;
+  using segy::SegyIO::write;
 
   py::array_t<float> read(int startZ, int endZ, int startY, int endY,
                           int startX, int endX);
@@ -33,8 +42,43 @@ public:
   py::array_t<float> read_cross_slice(int iY);
   py::array_t<float> read_time_slice(int iX);
   py::array_t<float> read_trace(int iZ, int iY);
+  py::array_t<float> read_line2d(int startY, int endY);
+  py::array_t<uint8_t> dead_mask();
+  py::tuple read_with_stats(int startZ, int endZ, int startY, int endY,
+                            int startX, int endX,
+                            const std::vector<double> &percentiles);
+  py::tuple read_with_stats(const std::vector<double> &percentiles);
+  py::tuple read_as(int startZ, int endZ, int startY, int endY, int startX,
+                    int endX, segy::DType dtype, bool per_inline);
+  py::tuple read_as(segy::DType dtype, bool per_inline);
 
   void create(const std::string &segy_out_name, const py::array_t<float> &src);
+
+  py::dict geometry();
+  py::array_t<double> coord_to_line(const py::array_t<double> &xy);
+  py::array_t<double> line_to_coord(const py::array_t<double> &lines);
+  py::array_t<int> nearest_trace(const py::array_t<double> &xy);
+
+  py::dict zone_map(int window);
+  py::array_t<int> traces_exceeding(float threshold, int startX, int endX);
+  py::tuple read_arbitrary_line(const py::array_t<double> &points, bool world,
+                                segy::Interpolation interp, double step,
+                                int startX, int endX);
+  py::array_t<float> read_oblique(const std::array<double, 3> &origin,
+                                  const std::array<double, 3> &u,
+                                  const std::array<double, 3> &v,
+                                  const std::array<double, 3> &w,
+                                  const std::array<int, 3> &shape);
+  py::array_t<float> read_horizons(
+      const py::array_t<float, py::array::c_style | py::array::forcecast>
+          &horizons,
+      segy::HorizonAttr attr, int window);
+
+  void write(
+      const py::array_t<float, py::array::c_style | py::array::forcecast> &src,
+      int startZ, int startY, int startX);
+  void fill(float value, int startZ, int endZ, int startY, int endY,
+            int startX, int endX);
 };
 
 // Be careful the order of the dimensions
@@ -69,6 +113,91 @@ py::array_t<float> Pysegy::read() {
   read(ptr);
   return out;
 }
+static py::dict stats_dict(const segy::SampleStats &stats,
+                           const std::vector<double> &percentiles) {
+  py::dict out;
+  out["count"] = stats.count();
+  out["min"] = stats.min();
+  out["max"] = stats.max();
+  out["mean"] = stats.mean();
+  out["std"] = stats.std();
+  py::array_t<float> values(percentiles.size());
+  auto w = values.mutable_unchecked<1>();
+  for (size_t i = 0; i < percentiles.size(); i++) {
+    w(i) = stats.percentile(percentiles[i]);
+  }
+  out["percentiles"] = values;
+  return out;
+}
+
+// (data, stats), the statistics are accumulated while decoding
+py::tuple Pysegy::read_with_stats(int startZ, int endZ, int startY, int endY,
+                                  int startX, int endX,
+                                  const std::vector<double> &percentiles) {
+  if (startX >= endX || startY >= endY || startZ >= endZ) {
+    throw std::runtime_error("Index 'end' must large than 'start'");
+  }
+  if (startX < 0 || endX > shape(0) || startY < 0 || endY > shape(1) ||
+      startZ < 0 || endZ > shape(2)) {
+    throw std::runtime_error("Index out of range");
+  }
+  py::array_t<float> out({endZ - startZ, endY - startY, endX - startX});
+  auto buff = out.request();
+  segy::SampleStats stats =
+      read_with_stats(static_cast<float *>(buff.ptr), startX, endX, startY,
+                      endY, startZ, endZ);
+  return py::make_tuple(out, stats_dict(stats, percentiles));
+}
+
+py::tuple Pysegy::read_with_stats(const std::vector<double> &percentiles) {
+  py::array_t<float> out({shape(2), shape(1), shape(0)});
+  auto buff = out.request();
+  segy::SampleStats stats = read_with_stats(static_cast<float *>(buff.ptr));
+  return py::make_tuple(out, stats_dict(stats, percentiles));
+}
+
+// numpy has no bfloat16, its bits are returned as uint16
+static py::dtype numpy_dtype(segy::DType dtype) {
+  switch (dtype) {
+  case segy::DType::Float16:
+    return py::dtype("float16");
+  case segy::DType::BFloat16:
+    return py::dtype("uint16");
+  case segy::DType::Int16:
+    return py::dtype("int16");
+  case segy::DType::Int8:
+    return py::dtype("int8");
+  default:
+    return py::dtype("float32");
+  }
+}
+
+// (data, scales), value = data * scale
+py::tuple Pysegy::read_as(int startZ, int endZ, int startY, int endY,
+                          int startX, int endX, segy::DType dtype,
+                          bool per_inline) {
+  if (startX >= endX || startY >= endY || startZ >= endZ) {
+    throw std::runtime_error("Index 'end' must large than 'start'");
+  }
+  if (startX < 0 || endX > shape(0) || startY < 0 || endY > shape(1) ||
+      startZ < 0 || endZ > shape(2)) {
+    throw std::runtime_error("Index out of range");
+  }
+  py::array out(numpy_dtype(dtype), {endZ - startZ, endY - startY,
+                                     endX - startX});
+  auto buff = out.request();
+  std::vector<float> scales = read_as(buff.ptr, dtype, per_inline, startX,
+                                      endX, startY, endY, startZ, endZ);
+  return py::make_tuple(out, py::array_t<float>(scales.size(), scales.data()));
+}
+
+py::tuple Pysegy::read_as(segy::DType dtype, bool per_inline) {
+  py::array out(numpy_dtype(dtype), {shape(2), shape(1), shape(0)});
+  auto buff = out.request();
+  std::vector<float> scales = read_as(buff.ptr, dtype, per_inline);
+  return py::make_tuple(out, py::array_t<float>(scales.size(), scales.data()));
+}
+
 py::array_t<float> Pysegy::read_inline_slice(int iZ) {
   py::array_t<float> out({shape(1), shape(0)});
   auto buff = out.request();
@@ -99,6 +228,23 @@ py::array_t<float> Pysegy::read_trace(int iZ, int iY) {
   return out;
 }
 
+// for 2D lines and single inline files,
+// the output shape is (n-trace, n-time)
+py::array_t<float> Pysegy::read_line2d(int startY, int endY) {
+  if (shape(2) != 1) {
+    throw std::runtime_error("'read_line2d()' function only used for 2D lines "
+                             "or single inline files");
+  }
+  if (startY >= endY || startY < 0 || endY > shape(1)) {
+    throw std::runtime_error("Index out of range");
+  }
+  py::array_t<float> out({endY - startY, shape(0)});
+  auto buff = out.request();
+  float *ptr = static_cast<float *>(buff.ptr);
+  read(ptr, 0, shape(0), startY, endY, 0, 1);
+  return out;
+}
+
 void Pysegy::create(const std::string &segy_out_name,
                     const py::array_t<float> &src) {
   auto buff = src.request();
@@ -112,6 +258,203 @@ void Pysegy::create(const std::string &segy_out_name,
   create(segy_out_name, ptr);
 }
 
+py::dict Pysegy::geometry() {
+  segy::Geometry g = segy::SegyIO::geometry();
+  py::dict out;
+  out["valid"] = g.valid;
+  out["origin_X"] = g.origin_X;
+  out["origin_Y"] = g.origin_Y;
+  out["inline_bin"] = g.inline_bin;
+  out["crossline_bin"] = g.crossline_bin;
+  out["azimuth"] = g.azimuth;
+  out["scalar"] = g.scalar;
+  out["rms_error"] = g.rms_error;
+  out["coef"] = py::make_tuple(g.coef[0], g.coef[1], g.coef[2], g.coef[3],
+                               g.coef[4], g.coef[5]);
+  return out;
+}
+
+// xy: shape is (N, 2), each row is (X, Y)
+// return: shape is (N, 2), each row is (inline, crossline) (fractional)
+py::array_t<double> Pysegy::coord_to_line(const py::array_t<double> &xy) {
+  auto r = xy.unchecked<2>();
+  if (r.shape(1) != 2) {
+    throw std::runtime_error("Input must be a (N, 2) array.");
+  }
+  py::array_t<double> out({r.shape(0), py::ssize_t(2)});
+  auto w = out.mutable_unchecked<2>();
+  for (py::ssize_t i = 0; i < r.shape(0); i++) {
+    segy::SegyIO::coord_to_line(r(i, 0), r(i, 1), w(i, 0), w(i, 1));
+  }
+  return out;
+}
+
+// lines: shape is (N, 2), each row is (inline, crossline)
+// return: shape is (N, 2), each row is (X, Y)
+py::array_t<double> Pysegy::line_to_coord(const py::array_t<double> &lines) {
+  auto r = lines.unchecked<2>();
+  if (r.shape(1) != 2) {
+    throw std::runtime_error("Input must be a (N, 2) array.");
+  }
+  py::array_t<double> out({r.shape(0), py::ssize_t(2)});
+  auto w = out.mutable_unchecked<2>();
+  for (py::ssize_t i = 0; i < r.shape(0); i++) {
+    segy::SegyIO::line_to_coord(r(i, 0), r(i, 1), w(i, 0), w(i, 1));
+  }
+  return out;
+}
+
+// xy: shape is (N, 2), each row is (X, Y)
+// return: shape is (N, 2), (inline, crossline) of the nearest trace
+py::array_t<int> Pysegy::nearest_trace(const py::array_t<double> &xy) {
+  auto r = xy.unchecked<2>();
+  if (r.shape(1) != 2) {
+    throw std::runtime_error("Input must be a (N, 2) array.");
+  }
+  py::array_t<int> out({r.shape(0), py::ssize_t(2)});
+  auto w = out.mutable_unchecked<2>();
+  for (py::ssize_t i = 0; i < r.shape(0); i++) {
+    segy::TraceInfo info =
+        trace_info(segy::SegyIO::nearest_trace(r(i, 0), r(i, 1)));
+    w(i, 0) = info.inline_num;
+    w(i, 1) = info.crossline_num;
+  }
+  return out;
+}
+
+// min, max and rms are (n-trace, n-window) arrays
+py::dict Pysegy::zone_map(int window) {
+  buildZoneMap(window);
+  const segy::ZoneMap &map = segy::SegyIO::zone_map();
+  std::vector<py::ssize_t> shape = {map.trace_count, map.nwindows};
+  py::dict out;
+  out["window"] = map.window;
+  out["min"] = py::array_t<float>(shape, map.min.data());
+  out["max"] = py::array_t<float>(shape, map.max.data());
+  out["rms"] = py::array_t<float>(shape, map.rms.data());
+  return out;
+}
+
+// return: shape is (N, 2), (inline, crossline) of the traces,
+// endX < 0 is the end of the traces
+py::array_t<int> Pysegy::traces_exceeding(float threshold, int startX,
+                                          int endX) {
+  std::vector<int64_t> traces = segy::SegyIO::traces_exceeding(
+      threshold, startX, endX < 0 ? shape(0) : endX);
+  py::array_t<int> out({static_cast<py::ssize_t>(traces.size()),
+                        py::ssize_t(2)});
+  auto w = out.mutable_unchecked<2>();
+  for (size_t i = 0; i < traces.size(); i++) {
+    segy::TraceInfo info = trace_info(traces[i]);
+    w(i, 0) = info.inline_num;
+    w(i, 1) = info.crossline_num;
+  }
+  return out;
+}
+
+// points: shape is (N, 2), (inline, crossline) or (X, Y) if world
+// return: (data, path), data is (n-trace, n-time), path is (n-trace, 2),
+// the (inline, crossline) of each trace
+py::tuple Pysegy::read_arbitrary_line(const py::array_t<double> &points,
+                                      bool world, segy::Interpolation interp,
+                                      double step, int startX, int endX) {
+  auto r = points.unchecked<2>();
+  if (r.shape(1) != 2) {
+    throw std::runtime_error("Input must be a (N, 2) array.");
+  }
+  std::vector<double> xy(r.shape(0) * 2);
+  for (py::ssize_t i = 0; i < r.shape(0); i++) {
+    xy[2 * i] = r(i, 0);
+    xy[2 * i + 1] = r(i, 1);
+  }
+  std::vector<double> path = arbitrary_path(
+      xy.data(), static_cast<int>(r.shape(0)), world, step);
+  py::ssize_t npath = path.size() / 2;
+  endX = endX < 0 ? shape(0) : endX;
+  py::array_t<float> out({npath, py::ssize_t(endX - startX)});
+  auto buff = out.request();
+  segy::SegyIO::read_arbitrary_line(static_cast<float *>(buff.ptr),
+                                    path.data(), npath, interp, startX, endX);
+  py::array_t<double> lines({npath, py::ssize_t(2)});
+  std::copy(path.begin(), path.end(), lines.mutable_data());
+  return py::make_tuple(out, lines);
+}
+
+// origin, u, v, w: (inline, crossline, time), return: shape is `shape`
+py::array_t<float> Pysegy::read_oblique(const std::array<double, 3> &origin,
+                                        const std::array<double, 3> &u,
+                                        const std::array<double, 3> &v,
+                                        const std::array<double, 3> &w,
+                                        const std::array<int, 3> &shape) {
+  segy::ObliqueGrid grid;
+  for (int d = 0; d < 3; d++) {
+    grid.origin[d] = origin[d];
+    grid.u[d] = u[d];
+    grid.v[d] = v[d];
+    grid.w[d] = w[d];
+  }
+  grid.nu = shape[0];
+  grid.nv = shape[1];
+  grid.nw = shape[2];
+  if (grid.nu < 1 || grid.nv < 1 || grid.nw < 1) {
+    throw std::runtime_error("The grid must have at least one point");
+  }
+  py::array_t<float> out({grid.nu, grid.nv, grid.nw});
+  auto buff = out.request();
+  segy::SegyIO::read_oblique(static_cast<float *>(buff.ptr), grid);
+  return out;
+}
+
+// horizons: shape is (n-inline, n-crossline) or (N, n-inline, n-crossline),
+// the times (ms) or depths. return: the same shape
+py::array_t<float> Pysegy::read_horizons(
+    const py::array_t<float, py::array::c_style | py::array::forcecast>
+        &horizons,
+    segy::HorizonAttr attr, int window) {
+  auto buff = horizons.request();
+  if (buff.ndim != 2 && buff.ndim != 3) {
+    throw std::runtime_error("Input must be a 2D or 3D array.");
+  }
+  if (buff.shape[buff.ndim - 2] != shape(2) ||
+      buff.shape[buff.ndim - 1] != shape(1)) {
+    throw std::runtime_error(
+        "The horizons must be (n-inline, n-crossline) arrays.");
+  }
+  int nhorizon = buff.ndim == 3 ? static_cast<int>(buff.shape[0]) : 1;
+  py::array_t<float> out(buff.shape);
+  if (nhorizon > 0) {
+    segy::SegyIO::read_horizons(out.mutable_data(),
+                                static_cast<const float *>(buff.ptr),
+                                nhorizon, attr, window);
+  }
+  return out;
+}
+
+// src: shape is (n-inline, n-crossline, n-time), written in place from
+// (startZ, startY, startX)
+void Pysegy::write(
+    const py::array_t<float, py::array::c_style | py::array::forcecast> &src,
+    int startZ, int startY, int startX) {
+  if (src.ndim() != 3) {
+    throw std::runtime_error("Input must be a 3D array.");
+  }
+  segy::SegyIO::write(src.data(), startX, startX + src.shape(2), startY,
+                      startY + src.shape(1), startZ, startZ + src.shape(0));
+}
+
+void Pysegy::fill(float value, int startZ, int endZ, int startY, int endY,
+                  int startX, int endX) {
+  segy::SegyIO::fill(value, startX, endX, startY, endY, startZ, endZ);
+}
+
+// shape is (n-inline, n-crossline), 0: live, 1: dead, 2: missing
+py::array_t<uint8_t> Pysegy::dead_mask() {
+  py::array_t<uint8_t> out({shape(2), shape(1)});
+  auto buff = out.request();
+  dead_mask(static_cast<uint8_t *>(buff.ptr));
+  return out;
+}
+
 void create_by_sharing_header(const std::string &segy_name,
                               const std::string &header_segy,
                               const py::array_t<float> &src, int iline = 189,
@@ -128,6 +471,32 @@ void create_by_sharing_header(const std::string &segy_name,
                                  r.shape(1), r.shape(0), iline, xline);
 }
 
+// srcs: the arrays of the outputs, all with the shape of the header segy
+void create_by_sharing_header_batch(
+    const std::vector<std::string> &segy_names, const std::string &header_segy,
+    const std::vector<py::array_t<float, py::array::c_style |
+                                             py::array::forcecast>> &srcs,
+    int iline, int xline, int threads) {
+  if (srcs.empty()) {
+    throw std::runtime_error("At least one array is needed.");
+  }
+  std::vector<const float *> ptrs;
+  for (const auto &src : srcs) {
+    if (src.ndim() != 3) {
+      throw std::runtime_error("Input data must be a 3D data.");
+    }
+    for (int d = 0; d < 3; d++) {
+      if (src.shape(d) != srcs[0].shape(d)) {
+        throw std::runtime_error("The arrays must have the same shape.");
+      }
+    }
+    ptrs.push_back(src.data());
+  }
+  segy::create_by_sharing_header(
+      segy_names, header_segy, ptrs, srcs[0].shape(2), srcs[0].shape(1),
+      srcs[0].shape(0), iline, xline, threads);
+}
+
 py::array_t<float> fromfile_ignore_header(const std::string &segy_name,
                                           int sizeZ, int sizeY, int sizeX,
                                           int format = 5) {
@@ -138,6 +507,15 @@ py::array_t<float> fromfile_ignore_header(const std::string &segy_name,
   return out;
 }
 
+py::array_t<float> fromfile_binary(const std::string &binary_name, int sizeZ,
+                                   int sizeY, int sizeX) {
+  py::array_t<float> out({sizeZ, sizeY, sizeX});
+  auto buff = out.request();
+  float *ptr = static_cast<float *>(buff.ptr);
+  segy::read_binary(binary_name, ptr, sizeX, sizeY, sizeZ);
+  return out;
+}
+
 py::array_t<float> fromfile(const std::string &segy_name, int iline = 189,
                             int xline = 193) {
   Pysegy segy_data(segy_name);
@@ -149,6 +527,15 @@ py::array_t<float> fromfile(const std::string &segy_name, int iline = 189,
   return out;
 }
 
+py::array_t<float> fromfile_2d(const std::string &segy_name, int keyloc = 21) {
+  Pysegy segy_data(segy_name);
+  segy_data.setLine2D(keyloc);
+  segy_data.scan();
+  py::array_t<float> out = segy_data.read_line2d(0, segy_data.shape(1));
+
+  return out;
+}
+
 std::pair<py::array_t<float>, py::array_t<int>>
 collect(const std::string &segy_in, int iline = 189, int xline = 193,
         int xfield = 73, int yfield = 77) {
@@ -158,12 +545,14 @@ collect(const std::string &segy_in, int iline = 189, int xline = 193,
   segy.setXLocation(xfield);
   segy.setYLocation(yfield);
 
-  auto data =
-      py::array_t<float>({static_cast<int>(segy.trace_count()), segy.shape(0)});
+  auto data = py::array_t<float>(
+      {static_cast<py::ssize_t>(segy.trace_count()),
+       static_cast<py::ssize_t>(segy.shape(0))});
   auto buff = data.request();
   float *ptr = static_cast<float *>(buff.ptr);
 
-  auto header = py::array_t<int>({static_cast<int>(segy.trace_count()), 4});
+  auto header = py::array_t<int>(
+      {static_cast<py::ssize_t>(segy.trace_count()), py::ssize_t(4)});
   auto buffh = header.request();
   int *ptrh = static_cast<int *>(buffh.ptr);
 
@@ -173,12 +562,144 @@ collect(const std::string &segy_in, int iline = 189, int xline = 193,
   return out;
 }
 
+// (inline, crosslines, traces) of the next inline, None at the end
+py::object stream_next_line(segy::SegyStream &stream) {
+  segy::StreamLine line;
+  if (!stream.next_line(line)) {
+    return py::none();
+  }
+  py::ssize_t ntrace = line.crosslines.size();
+  py::array_t<int32_t> crosslines(ntrace, line.crosslines.data());
+  py::array_t<float> data({ntrace, static_cast<py::ssize_t>(
+                                       stream.get_metaInfo().sizeX)},
+                          line.data.data());
+  return py::make_tuple(line.inline_num, crosslines, data);
+}
+
+py::tuple stream_shape(segy::SegyStream &stream) {
+  segy::MetaInfo meta = stream.get_metaInfo();
+  return py::make_tuple(meta.sizeZ, meta.sizeY, meta.sizeX);
+}
+
+// shape is (N, n-inline, n-crossline, n-time), or channels last
+py::array_t<float> multi_read(segy::MultiSegy &multi, int startZ, int endZ,
+                              int startY, int endY, int startX, int endX,
+                              bool channels_last) {
+  std::vector<py::ssize_t> shape = {endZ - startZ, endY - startY,
+                                    endX - startX};
+  shape.insert(channels_last ? shape.end() : shape.begin(), multi.count());
+  py::array_t<float> out(shape);
+  multi.read(out.mutable_data(), startX, endX, startY, endY, startZ, endZ,
+             channels_last);
+  return out;
+}
+
+py::array_t<float> multi_read_all(segy::MultiSegy &multi, bool channels_last) {
+  return multi_read(multi, 0, multi.shape(2), 0, multi.shape(1), 0,
+                    multi.shape(0), channels_last);
+}
+
+// starts: shape is (P, 3), (iZ, iY, iX) of each patch
+// return: shape is (P, N, sizeZ, sizeY, sizeX), or channels last
+py::array_t<float> multi_read_patches(
+    segy::MultiSegy &multi,
+    const py::array_t<int, py::array::c_style | py::array::forcecast> &starts,
+    const std::array<int, 3> &size, bool channels_last) {
+  auto buff = starts.request();
+  if (buff.ndim != 2 || buff.shape[1] != 3) {
+    throw std::runtime_error("Input must be a (P, 3) array.");
+  }
+  py::ssize_t npatch = buff.shape[0];
+  std::vector<py::ssize_t> shape = {size[0], size[1], size[2]};
+  shape.insert(channels_last ? shape.end() : shape.begin(), multi.count());
+  shape.insert(shape.begin(), npatch);
+  py::array_t<float> out(shape);
+  multi.read_patches(out.mutable_data(), static_cast<const int *>(buff.ptr),
+                     static_cast<int>(npatch), size[2], size[1], size[0],
+                     channels_last);
+  return out;
+}
+
+py::tuple multi_shape(segy::MultiSegy &multi) {
+  return py::make_tuple(multi.count(), multi.shape(2), multi.shape(1),
+                        multi.shape(0));
+}
+
+// src: shape is (n-inline, n-crossline, n-time), the inlines from startZ.
+// Other threads run while the block is encoded and written.
+void writer_write_lines(
+    segy::SegyWriter &writer,
+    const py::array_t<float, py::array::c_style | py::array::forcecast> &src,
+    int startZ) {
+  if (src.ndim() != 3 || src.shape(1) != writer.shape(1) ||
+      src.shape(2) != writer.shape(0)) {
+    throw std::runtime_error(
+        "Input must be a (n-inline, n-crossline, n-time) array.");
+  }
+  const float *ptr = src.data();
+  int count = static_cast<int>(src.shape(0));
+  py::gil_scoped_release release;
+  writer.write_lines(ptr, startZ, count);
+}
+
 template <typename... Args>
 using overload_cast_ = pybind11::detail::overload_cast_impl<Args...>;
 
 PYBIND11_MODULE(cigsegy, m) {
+  py::enum_<segy::WriteMode>(m, "WriteMode")
+      .value("MMap", segy::WriteMode::MMap)
+      .value("Stream", segy::WriteMode::Stream)
+      .value("Pipeline", segy::WriteMode::Pipeline);
+
+  py::enum_<segy::Backend>(m, "Backend")
+      .value("MMap", segy::Backend::MMap)
+      .value("PRead", segy::Backend::PRead)
+      .value("IOUring", segy::Backend::IOUring)
+      .value("Zstd", segy::Backend::Zstd);
+
+  py::enum_<segy::Scaling>(m, "Scaling")
+      .value("Off", segy::Scaling::Off)
+      .value("Global", segy::Scaling::Global)
+      .value("Inline", segy::Scaling::Inline)
+      .value("TraceRMS", segy::Scaling::TraceRMS)
+      .value("AGC", segy::Scaling::AGC);
+
+  py::enum_<segy::Interpolation>(m, "Interpolation")
+      .value("Nearest", segy::Interpolation::Nearest)
+      .value("Bilinear", segy::Interpolation::Bilinear);
+
+  py::enum_<segy::HorizonAttr>(m, "HorizonAttr")
+      .value("Amplitude", segy::HorizonAttr::Amplitude)
+      .value("Mean", segy::HorizonAttr::Mean)
+      .value("RMS", segy::HorizonAttr::RMS)
+      .value("Max", segy::HorizonAttr::Max);
+
+  py::enum_<segy::DType>(m, "DType")
+      .value("Float32", segy::DType::Float32)
+      .value("Float16", segy::DType::Float16)
+      .value("BFloat16", segy::DType::BFloat16)
+      .value("Int16", segy::DType::Int16)
+      .value("Int8", segy::DType::Int8);
+
+  py::class_<segy::Transform>(m, "Transform")
+      .def(py::init<>())
+      .def_readwrite("clip_percentile", &segy::Transform::clip_percentile)
+      .def_readwrite("clip", &segy::Transform::clip)
+      .def_readwrite("scaling", &segy::Transform::scaling)
+      .def_readwrite("scale", &segy::Transform::scale)
+      .def_readwrite("agc_window", &segy::Transform::agc_window);
+
+  py::enum_<segy::AccessHint>(m, "AccessHint")
+      .value("Auto", segy::AccessHint::Auto)
+      .value("Normal", segy::AccessHint::Normal)
+      .value("Sequential", segy::AccessHint::Sequential)
+      .value("Stream", segy::AccessHint::Stream)
+      .value("Random", segy::AccessHint::Random);
+
   py::class_<Pysegy>(m, "Pysegy")
       .def(py::init<std::string>())
+      .def(py::init<std::string, segy::Backend>(), py::arg("segy_name"),
+           py::arg("backend"))
       .def(py::init<int, int, int>())
       .def(py::init<std::string, int, int, int>())
       .def("setInlineLocation", &Pysegy::setInlineLocation, py::arg("iline"))
@@ -187,6 +708,26 @@ PYBIND11_MODULE(cigsegy, m) {
       .def("setXLocation", &Pysegy::setXLocation, py::arg("xfield"))
       .def("setYLocation", &Pysegy::setYLocation, py::arg("yfield"))
       .def("setFillNoValue", &Pysegy::setFillNoValue, py::arg("fills"))
+      .def("setLine2D", &Pysegy::setLine2D, py::arg("keyloc") = 21)
+      .def("setVariableLength", &Pysegy::setVariableLength,
+           py::arg("variable"))
+      .def("setWriteMode", &Pysegy::setWriteMode, py::arg("mode"))
+      .def("setThreads", &Pysegy::setThreads, py::arg("threads"))
+      .def("setMemoryBudget", &Pysegy::setMemoryBudget, py::arg("bytes"))
+      .def("setDirectIO", &Pysegy::setDirectIO, py::arg("direct"))
+      .def("setSparse", &Pysegy::setSparse, py::arg("sparse"))
+      .def("sparse_bytes", &Pysegy::sparse_bytes)
+      .def("setTransform", &Pysegy::setTransform, py::arg("transform"))
+      .def("transform", &Pysegy::transform)
+      .def("setResample", &Pysegy::setResample, py::arg("interval"))
+      .def("sample_interval", &Pysegy::sample_interval)
+      .def("setAccessHint", &Pysegy::setAccessHint, py::arg("hint"))
+      .def("setVerbose", &Pysegy::setVerbose, py::arg("verbose"))
+      .def("setDetectDead", &Pysegy::setDetectDead, py::arg("detect"))
+      .def("dead_count", &Pysegy::dead_count)
+      .def("dead_mask", overload_cast_<>()(&Pysegy::dead_mask),
+           "state of each trace, 0: live, 1: dead, 2: missing")
+      .def("backend", &Pysegy::backend)
       .def("scan", &Pysegy::scan)
       .def("tofile", &Pysegy::tofile, py::arg("binary_out_name"))
       .def("read", overload_cast_<>()(&Pysegy::read), "read hole volume")
@@ -195,6 +736,30 @@ PYBIND11_MODULE(cigsegy, m) {
            "read with index", py::arg("startZ"), py::arg("endZ"),
            py::arg("startY"), py::arg("endY"), py::arg("startX"),
            py::arg("endX"))
+      .def("read_with_stats",
+           overload_cast_<const std::vector<double> &>()(
+               &Pysegy::read_with_stats),
+           "read hole volume and the statistics of the samples",
+           py::arg("percentiles") = std::vector<double>{1, 50, 99})
+      .def("read_with_stats",
+           overload_cast_<int, int, int, int, int, int,
+                          const std::vector<double> &>()(
+               &Pysegy::read_with_stats),
+           "read with index and the statistics of the samples",
+           py::arg("startZ"), py::arg("endZ"), py::arg("startY"),
+           py::arg("endY"), py::arg("startX"), py::arg("endX"),
+           py::arg("percentiles") = std::vector<double>{1, 50, 99})
+      .def("read_as",
+           overload_cast_<segy::DType, bool>()(&Pysegy::read_as),
+           "read hole volume as dtype, and the scales of the quantized types",
+           py::arg("dtype"), py::arg("per_inline") = false)
+      .def("read_as",
+           overload_cast_<int, int, int, int, int, int, segy::DType, bool>()(
+               &Pysegy::read_as),
+           "read with index as dtype, and the scales of the quantized types",
+           py::arg("startZ"), py::arg("endZ"), py::arg("startY"),
+           py::arg("endY"), py::arg("startX"), py::arg("endX"),
+           py::arg("dtype"), py::arg("per_inline") = false)
       .def("read_inline_slice",
            overload_cast_<int>()(&Pysegy::read_inline_slice),
            "read inline slice", py::arg("iZ"))
@@ -204,6 +769,47 @@ PYBIND11_MODULE(cigsegy, m) {
            "read time slice", py::arg("iX"))
       .def("read_trace", overload_cast_<int, int>()(&Pysegy::read_trace),
            "read trace", py::arg("iZ"), py::arg("iY"))
+      .def("read_line2d", &Pysegy::read_line2d, "read traces of a 2D line",
+           py::arg("startY"), py::arg("endY"))
+      .def("geometry", &Pysegy::geometry, "fitted survey geometry")
+      .def("coord_to_line", &Pysegy::coord_to_line,
+           "convert (X, Y) to (inline, crossline)", py::arg("xy"))
+      .def("line_to_coord", &Pysegy::line_to_coord,
+           "convert (inline, crossline) to (X, Y)", py::arg("lines"))
+      .def("nearest_trace", &Pysegy::nearest_trace,
+           "(inline, crossline) of the nearest trace of (X, Y)", py::arg("xy"))
+      .def("buildCoordIndex", &Pysegy::buildCoordIndex)
+      .def("zone_map", &Pysegy::zone_map,
+           "min, max and rms of each window of each trace",
+           py::arg("window") = 0)
+      .def("traces_exceeding", &Pysegy::traces_exceeding,
+           "(inline, crossline) of the traces whose max abs exceeds threshold",
+           py::arg("threshold"), py::arg("startX") = 0, py::arg("endX") = -1)
+      .def("clip_estimate", &Pysegy::clip_estimate,
+           "percentile of the peak amplitudes of the windows",
+           py::arg("percentile") = 99)
+      .def("read_arbitrary_line", &Pysegy::read_arbitrary_line,
+           "the section along a polyline", py::arg("points"),
+           py::arg("world") = false,
+           py::arg("interp") = segy::Interpolation::Bilinear,
+           py::arg("step") = 1.0, py::arg("startX") = 0, py::arg("endX") = -1)
+      .def("read_oblique", &Pysegy::read_oblique,
+           "the volume interpolated on a grid at any orientation",
+           py::arg("origin"), py::arg("u"), py::arg("v"), py::arg("w"),
+           py::arg("shape"))
+      .def("read_horizons", &Pysegy::read_horizons,
+           "the attribute maps along horizons", py::arg("horizons"),
+           py::arg("attr") = segy::HorizonAttr::Amplitude,
+           py::arg("window") = 0)
+      .def("write", &Pysegy::write,
+           "update the samples of the file in place", py::arg("src"),
+           py::arg("startZ") = 0, py::arg("startY") = 0, py::arg("startX") = 0)
+      .def("fill", &Pysegy::fill, "set the samples of the file in place",
+           py::arg("value"), py::arg("startZ"), py::arg("endZ"),
+           py::arg("startY"), py::arg("endY"), py::arg("startX"),
+           py::arg("endX"))
+      .def("shape", &Pysegy::shape, py::arg("dimension"))
+      .def("trace_count", &Pysegy::trace_count)
       .def("setSampleInterval", &Pysegy::setSampleInterval, py::arg("dt"))
       .def("setDataFormatCode", &Pysegy::setDataFormatCode, py::arg("format"))
       .def("setStartTime", &Pysegy::setStartTime, py::arg("start_time"))
@@ -224,12 +830,75 @@ PYBIND11_MODULE(cigsegy, m) {
            py::arg("sizeZ"))
       .def("close_file", &Pysegy::close_file);
 
+  py::class_<segy::SegyStream>(m, "SegyStream")
+      .def(py::init<std::string>(), py::arg("segy_name"))
+      .def(py::init<int>(), py::arg("fd"))
+      .def("setInlineLocation", &segy::SegyStream::setInlineLocation,
+           py::arg("iline"))
+      .def("setCrosslineLocation", &segy::SegyStream::setCrosslineLocation,
+           py::arg("xline"))
+      .def("setFillNoValue", &segy::SegyStream::setFillNoValue,
+           py::arg("fills"))
+      .def("setCrosslineRange", &segy::SegyStream::setCrosslineRange,
+           py::arg("min_xline"), py::arg("max_xline"))
+      .def("textual_header", &segy::SegyStream::textual_header)
+      .def("next_line", &stream_next_line)
+      .def("tofile", &segy::SegyStream::tofile, py::arg("binary_out_name"))
+      .def("shape", &stream_shape);
+
+  py::class_<segy::MultiSegy>(m, "MultiSegy")
+      .def(py::init<std::vector<std::string>, segy::Backend>(),
+           py::arg("segy_names"), py::arg("backend") = segy::Backend::MMap)
+      .def("setInlineLocation", &segy::MultiSegy::setInlineLocation,
+           py::arg("iline"))
+      .def("setCrosslineLocation", &segy::MultiSegy::setCrosslineLocation,
+           py::arg("xline"))
+      .def("setFillNoValue", &segy::MultiSegy::setFillNoValue,
+           py::arg("fills"))
+      .def("setResample", &segy::MultiSegy::setResample, py::arg("interval"))
+      .def("setThreads", &segy::MultiSegy::setThreads, py::arg("threads"))
+      .def("scan", &segy::MultiSegy::scan)
+      .def("shape", &multi_shape)
+      .def("read", &multi_read_all, py::arg("channels_last") = false)
+      .def("read", &multi_read, py::arg("startZ"), py::arg("endZ"),
+           py::arg("startY"), py::arg("endY"), py::arg("startX"),
+           py::arg("endX"), py::arg("channels_last") = false)
+      .def("read_patches", &multi_read_patches, py::arg("starts"),
+           py::arg("size"), py::arg("channels_last") = false);
+
+  py::class_<segy::SegyWriter>(m, "SegyWriter")
+      .def(py::init<int, int, int>(), py::arg("sizeX"), py::arg("sizeY"),
+           py::arg("sizeZ"))
+      .def("setSampleInterval", &segy::SegyWriter::setSampleInterval,
+           py::arg("dt"))
+      .def("setDataFormatCode", &segy::SegyWriter::setDataFormatCode,
+           py::arg("format"))
+      .def("setStartTime", &segy::SegyWriter::setStartTime,
+           py::arg("start_time"))
+      .def("setXInterval", &segy::SegyWriter::setXInterval, py::arg("dx"))
+      .def("setYInterval", &segy::SegyWriter::setYInterval, py::arg("dy"))
+      .def("setMinInline", &segy::SegyWriter::setMinInline,
+           py::arg("minInline"))
+      .def("setMinCrossline", &segy::SegyWriter::setMinCrossline,
+           py::arg("minXline"))
+      .def("open", &segy::SegyWriter::open, py::arg("segy_out_name"))
+      .def("write_lines", &writer_write_lines, py::arg("src"),
+           py::arg("startZ"))
+      .def("lines_written", &segy::SegyWriter::lines_written)
+      .def("close", &segy::SegyWriter::close);
+
   m.def("fromfile_ignore_header", &fromfile_ignore_header,
         "read by ignoring header and specify shape", py::arg("segy_name"),
         py::arg("sizeZ"), py::arg("sizeY"), py::arg("sizeX"),
         py::arg("format") = 5);
+  m.def("fromfile_binary", &fromfile_binary,
+        "read a binary file, the holes of a sparse file are skipped",
+        py::arg("binary_name"), py::arg("sizeZ"), py::arg("sizeY"),
+        py::arg("sizeX"));
   m.def("fromfile", &fromfile, "read from a file", py::arg("segy_name"),
         py::arg("iline") = 189, py::arg("xline") = 193);
+  m.def("fromfile_2d", &fromfile_2d, "read a 2D line from a file",
+        py::arg("segy_name"), py::arg("keyloc") = 21);
   m.def("tofile_ignore_header", &segy::tofile_ignore_header,
         "convert to binary file by ignoring header and specify shape",
         py::arg("segy_name"), py::arg("out_name"), py::arg("sizeX"),
@@ -243,4 +912,9 @@ PYBIND11_MODULE(cigsegy, m) {
         "create a segy file using a existed segy header", py::arg("segy_name"),
         py::arg("header_segy"), py::arg("src"), py::arg("iline") = 189,
         py::arg("xline") = 193);
+  m.def("create_by_sharing_header", &create_by_sharing_header_batch,
+        "create several segy files using a existed segy header",
+        py::arg("segy_names"), py::arg("header_segy"), py::arg("srcs"),
+        py::arg("iline") = 189, py::arg("xline") = 193,
+        py::arg("threads") = 0);
 }
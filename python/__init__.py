@@ -1,17 +1,37 @@
-from .cigsegy import (Pysegy, fromfile, fromfile_ignore_header, tofile,
-                      tofile_ignore_header, collect, create_by_sharing_header)
-from .tools import (create, textual_header, metaInfo)
+from .cigsegy import (Pysegy, SegyStream, MultiSegy, SegyWriter, WriteMode,
+                      AccessHint, Backend, Scaling, Transform, DType,
+                      Interpolation, HorizonAttr, fromfile,
+                      fromfile_ignore_header, fromfile_2d, fromfile_binary,
+                      tofile, tofile_ignore_header, collect,
+                      create_by_sharing_header)
+from .tools import (create, textual_header, metaInfo, iter_line_2d,
+                    iter_stream)
 
 
 __all__ = [
     "Pysegy", 
+    "SegyStream", 
+    "MultiSegy",
+    "SegyWriter",
+    "WriteMode", 
+    "AccessHint", 
+    "Backend", 
+    "Scaling",
+    "Transform",
+    "DType",
+    "Interpolation",
+    "HorizonAttr",
     "fromfile", 
     "fromfile_ignore_header", 
+    "fromfile_2d", 
+    "fromfile_binary",
     "tofile",
     "tofile_ignore_header", 
     "create", 
     "collect", 
     "textual_header", 
     "metaInfo",
+    "iter_line_2d",
+    "iter_stream",
     "create_by_sharing_header"
 ]
\ No newline at end of file
@@ -6,11 +6,163 @@ import numpy
 _Shape = typing.Tuple[int, ...]
 
 __all__ = [
-    "Pysegy", "fromfile", "fromfile_ignore_header", "tofile",
+    "Pysegy", "SegyStream", "MultiSegy", "SegyWriter", "WriteMode", "AccessHint", "Backend", "Scaling", "Transform", "DType", "Interpolation", "HorizonAttr", "fromfile", "fromfile_ignore_header", "fromfile_2d", "fromfile_binary", "tofile",
     "tofile_ignore_header", "collect"
 ]
 
 
+class WriteMode():
+    """
+    how `Pysegy.tofile` and `Pysegy.create` write the output file
+
+    Members:
+    - MMap: write through a shared memory map of the output (default)
+    - Stream: pwrite from two aligned buffers on a background thread,
+      usually faster for large files on local disks
+    - Pipeline: `tofile` only, reading, decoding (on many threads) and 
+      writing overlap, see `Pysegy.setThreads`. `create` writes as Stream.
+    """
+    MMap: typing.ClassVar[WriteMode]
+    Stream: typing.ClassVar[WriteMode]
+    Pipeline: typing.ClassVar[WriteMode]
+
+
+class AccessHint():
+    """
+    how the segy file will be accessed, it is given to the kernel (madvise)
+
+    Members:
+    - Auto: chosen by each read call (default), Random for time slices and
+      small patches, Sequential for larger reads, Stream for reads larger
+      than 1 GB
+    - Normal: default readahead of the kernel
+    - Sequential: sequential readahead, and prefetch of the next lines
+    - Stream: as Sequential, and drop the lines already read from the page
+      cache, so a full conversion doesn't evict the whole page cache
+    - Random: no readahead
+    """
+    Auto: typing.ClassVar[AccessHint]
+    Normal: typing.ClassVar[AccessHint]
+    Sequential: typing.ClassVar[AccessHint]
+    Stream: typing.ClassVar[AccessHint]
+    Random: typing.ClassVar[AccessHint]
+
+
+class Scaling():
+    """
+    the scaling of `Transform`
+
+    Members:
+    - Off: no scaling (default)
+    - Global: divided by the RMS of the volume, or multiplied by 
+      `Transform.scale` when it's not 0
+    - Inline: divided by the RMS of its inline
+    - TraceRMS: divided by the RMS of the samples read of the trace
+    - AGC: automatic gain control, divided by the RMS of a window of 
+      `Transform.agc_window` samples centered on each sample
+    """
+    Off: typing.ClassVar[Scaling]
+    Global: typing.ClassVar[Scaling]
+    Inline: typing.ClassVar[Scaling]
+    TraceRMS: typing.ClassVar[Scaling]
+    AGC: typing.ClassVar[Scaling]
+
+
+class DType():
+    """
+    the sample type of `Pysegy.read_as`
+
+    Members:
+    - Float32: as `read`
+    - Float16: IEEE half precision (numpy.float16)
+    - BFloat16: the upper 16 bits of the float32 samples, rounded to nearest
+      even. numpy has no bfloat16, the bits are returned as numpy.uint16,
+      `(data.astype(numpy.uint32) << 16).view(numpy.float32)` restores them
+    - Int16: quantized, value = data * scale (numpy.int16)
+    - Int8: quantized, value = data * scale (numpy.int8)
+    """
+    Float32: typing.ClassVar[DType]
+    Float16: typing.ClassVar[DType]
+    BFloat16: typing.ClassVar[DType]
+    Int16: typing.ClassVar[DType]
+    Int8: typing.ClassVar[DType]
+
+
+class Interpolation():
+    """
+    how `Pysegy.read_arbitrary_line` makes a trace between the bins
+
+    Members:
+    - Nearest: the nearest trace
+    - Bilinear: of the 4 traces around it, the missing and dead ones are 
+      left out
+    """
+    Nearest: typing.ClassVar[Interpolation]
+    Bilinear: typing.ClassVar[Interpolation]
+
+
+class HorizonAttr():
+    """
+    how `Pysegy.read_horizons` reduces the samples around a horizon
+
+    Members:
+    - Amplitude: linear interpolation at the horizon, the window is unused
+    - Mean: the mean of the window
+    - RMS: the RMS of the window
+    - Max: the largest sample of the window
+    """
+    Amplitude: typing.ClassVar[HorizonAttr]
+    Mean: typing.ClassVar[HorizonAttr]
+    RMS: typing.ClassVar[HorizonAttr]
+    Max: typing.ClassVar[HorizonAttr]
+
+
+class Transform():
+    """
+    what the reads (and `tofile`) do with the decoded samples, in the same 
+    pass as decoding. The samples are clipped first, then scaled. The clip 
+    percentile and the RMS of the volume and of the inlines come from the 
+    zone map (`Pysegy.zone_map`), so every read of the file, e.g., all 
+    patches of a training set, uses the same values. The fill values are 
+    kept as they are.
+
+    Attributes:
+    - clip_percentile: > 0, clip to +/- `Pysegy.clip_estimate(percentile)`
+    - clip: > 0, clip to [-clip, clip], if clip_percentile is 0
+    - scaling: a `Scaling`
+    - scale: the multiplier of Scaling.Global, 0 for 1 / RMS
+    - agc_window: the window length (samples) of Scaling.AGC
+    """
+    clip_percentile: float
+    clip: float
+    scaling: Scaling
+    scale: float
+    agc_window: int
+
+    def __init__(self) -> None:
+        ...
+
+
+class Backend():
+    """
+    where the trace data is read from, the headers are read from the 
+    memory map unless the file is compressed
+
+    Members:
+    - MMap: the shared memory map of the file (default)
+    - PRead: one large pread for each request, e.g., one inline
+    - IOUring: many asynchronous reads in flight with io_uring (Linux),
+      falls back to PRead when io_uring is unavailable
+    - Zstd: the decompressed frames of a zstd file with many frames, chosen 
+      automatically, only the frames of each read are decompressed. It is 
+      reported by `backend()`, requesting it for another file raises.
+    """
+    MMap: typing.ClassVar[Backend]
+    PRead: typing.ClassVar[Backend]
+    IOUring: typing.ClassVar[Backend]
+    Zstd: typing.ClassVar[Backend]
+
+
 class Pysegy():
 
     @typing.overload
@@ -22,6 +174,18 @@ class Pysegy():
         - segy_name: the input segy format file
         """
 
+    @typing.overload
+    def __init__(self, segy_name: str, backend: Backend) -> None:
+        """
+        Reading mode, the trace data is read by `backend`. PRead and 
+        IOUring are usually faster than MMap on network file systems 
+        (NFS, Lustre), use the tool `SEGYBench` to compare them.
+
+        Parameters:
+        - segy_name: the input segy format file
+        - backend: Backend.MMap, Backend.PRead or Backend.IOUring
+        """
+
     @typing.overload
     def __init__(self, sizeX: int, sizeY: int, sizeZ: int) -> None:
         """
@@ -83,6 +247,75 @@ class Pysegy():
         Return: numpy.ndarray
         """
 
+    @typing.overload
+    def read_with_stats(
+        self,
+        percentiles: typing.List[float] = [1, 50, 99]
+    ) -> typing.Tuple[numpy.ndarray[numpy.float32], dict]:
+        """
+        read whole volume, and its statistics accumulated while decoding, 
+        instead of more passes of numpy over the data. The fill values of 
+        the missing and dead traces are not counted.
+
+        Return: (data, stats), stats is a dict of 'count', 'min', 'max', 
+        'mean', 'std' (as numpy.std) and 'percentiles' (an array of the 
+        values at `percentiles`, approximated by a histogram whose bins are 
+        narrower than 1% of their values)
+        """
+
+    @typing.overload
+    def read_with_stats(
+        self,
+        startZ: int,
+        endZ: int,
+        startY: int,
+        endY: int,
+        startX: int,
+        endX: int,
+        percentiles: typing.List[float] = [1, 50, 99]
+    ) -> typing.Tuple[numpy.ndarray[numpy.float32], dict]:
+        """
+        as `read(startZ, endZ, startY, endY, startX, endX)`, and the 
+        statistics of the volume read
+        """
+
+    @typing.overload
+    def read_as(self,
+                dtype: DType,
+                per_inline: bool = False
+                ) -> typing.Tuple[numpy.ndarray, numpy.ndarray[numpy.float32]]:
+        """
+        read whole volume as `dtype`, converted while decoding, one inline 
+        at a time, so the float32 volume is never allocated.
+
+        The quantized types (Int16, Int8) store round(sample / scale), 
+        saturated, NaN is stored as 0. The scale of the volume is its peak 
+        from the zone map (`zone_map`, after the clip and the 
+        Scaling.Global of `setTransform`) over 127 or 32767. With 
+        `per_inline`, each inline has the scale of its own peak, it's 
+        needed for the other scalings.
+
+        Return: (data, scales), value = data * scales[0] for the volume, or
+        data[i] * scales[i] per inline. scales is empty for the float types.
+        """
+
+    @typing.overload
+    def read_as(self,
+                startZ: int,
+                endZ: int,
+                startY: int,
+                endY: int,
+                startX: int,
+                endX: int,
+                dtype: DType,
+                per_inline: bool = False
+                ) -> typing.Tuple[numpy.ndarray, numpy.ndarray[numpy.float32]]:
+        """
+        as `read(startZ, endZ, startY, endY, startX, endX)`, stored as 
+        `dtype`, see `read_as(dtype)`. The scale of the volume is the one of
+        the whole file, so all patches share it.
+        """
+
     def read_cross_slice(self, iY: int) -> numpy.ndarray[numpy.float32]:
         """
         read a crossline slice with index
@@ -103,6 +336,204 @@ class Pysegy():
         read a trace with index
         """
 
+    def read_line2d(self, startY: int,
+                    endY: int) -> numpy.ndarray[numpy.float32]:
+        """
+        read traces [startY:endY] of a 2D line or a single inline file,
+        the shape is (endY - startY, n-time). Use it to read a very long
+        line in chunks.
+        """
+
+    def shape(self, dimension: int) -> int:
+        """
+        the size of a dimension, 0 for n-time, 1 for n-crossline 
+        (n-trace for 2D lines), 2 for n-inline
+        """
+
+    def trace_count(self) -> int:
+        """
+        the number of traces in the file
+        """
+
+    def geometry(self) -> dict:
+        """
+        the affine survey geometry fitted from the trace headers 
+        (coordinates are multiplied by the coordinate scalar, bytes 71-72).
+        keys: valid, origin_X, origin_Y (coordinates of the first inline 
+        and crossline), inline_bin, crossline_bin, azimuth (degrees, 
+        clockwise from +Y, of the increasing crossline direction), 
+        scalar, rms_error and coef, i.e., 
+        X = coef[0] + coef[1] * iZ + coef[2] * iY, 
+        Y = coef[3] + coef[4] * iZ + coef[5] * iY
+        """
+
+    def coord_to_line(
+            self,
+            xy: numpy.ndarray[numpy.float64]) -> numpy.ndarray[numpy.float64]:
+        """
+        convert world coordinates to (fractional) line numbers.
+
+        Parameters:
+        - xy: shape is (N, 2), each row is (X, Y)
+
+        Return: shape is (N, 2), each row is (inline, crossline)
+        """
+
+    def line_to_coord(
+            self, lines: numpy.ndarray[numpy.float64]
+    ) -> numpy.ndarray[numpy.float64]:
+        """
+        convert line numbers to world coordinates.
+
+        Parameters:
+        - lines: shape is (N, 2), each row is (inline, crossline)
+
+        Return: shape is (N, 2), each row is (X, Y)
+        """
+
+    def nearest_trace(
+            self,
+            xy: numpy.ndarray[numpy.float64]) -> numpy.ndarray[numpy.int32]:
+        """
+        find the nearest existing trace of each world coordinate, it also 
+        works for irregular surveys. The first call builds a spatial index 
+        by reading all trace headers once.
+
+        Parameters:
+        - xy: shape is (N, 2), each row is (X, Y)
+
+        Return: shape is (N, 2), (inline, crossline) of the nearest traces
+        """
+
+    def buildCoordIndex(self) -> None:
+        """
+        build the spatial index of the trace coordinates used by 
+        `nearest_trace`, by reading all trace headers once.
+        """
+
+    def zone_map(self, window: int = 0) -> dict:
+        """
+        min, max and rms amplitude of each window of `window` samples of 
+        each trace (0: one window per trace). It's loaded from 
+        `<segy_name>.zmap` when that file matches the segy file, otherwise 
+        built in one parallel pass over the traces (`setThreads`) and saved 
+        there. Dead traces (`setDetectDead`) have zeros.
+
+        Return: a dict with 'window', and 'min', 'max', 'rms' arrays whose 
+        shape is (n-trace, n-window)
+        """
+
+    def traces_exceeding(self,
+                         threshold: float,
+                         startX: int = 0,
+                         endX: int = -1) -> numpy.ndarray[numpy.int32]:
+        """
+        the traces whose max abs amplitude exceeds `threshold` in the windows 
+        of the zone map overlapping samples [startX, endX), without reading 
+        the data. The zone map is built by the first call if needed.
+
+        Return: shape is (N, 2), (inline, crossline) of the traces
+        """
+
+    def clip_estimate(self, percentile: float = 99) -> float:
+        """
+        the `percentile` (0-100) of the peak amplitudes of the windows of 
+        the zone map, a clip value for display without reading the data
+        """
+
+    def read_arbitrary_line(
+        self,
+        points: numpy.ndarray,
+        world: bool = False,
+        interp: Interpolation = Interpolation.Bilinear,
+        step: float = 1.0,
+        startX: int = 0,
+        endX: int = -1
+    ) -> typing.Tuple[numpy.ndarray[numpy.float32], numpy.ndarray]:
+        """
+        the vertical section (fence) along the polyline through `points`, 
+        a (N, 2) array of (inline, crossline), or (X, Y) if `world`. Each 
+        segment is sampled every `step` bins from its first point, so the 
+        points themselves (e.g., the wells) are traces of the section. The 
+        traces are read once each in the order of the file, without 
+        progress bars, the positions without any trace are filled.
+
+        Return: (data, path), data is (n-trace, endX - startX), path is 
+        (n-trace, 2), the (inline, crossline) of each trace
+        """
+
+    def read_oblique(
+        self,
+        origin: typing.Sequence[float],
+        u: typing.Sequence[float],
+        v: typing.Sequence[float],
+        w: typing.Sequence[float],
+        shape: typing.Sequence[int]
+    ) -> numpy.ndarray[numpy.float32]:
+        """
+        the volume interpolated (trilinear) on a grid at any orientation, 
+        the point (i, j, k) is at origin + i * u + j * v + k * w, all in 
+        (inline, crossline, time sample index). Only the traces around the 
+        grid are read, once each, the points out of the volume are filled. 
+        The fast case has the last axis w along time, (0, 0, dt).
+
+        e.g., a box of 64 x 64 x 200 rotated by `a` around a well at 
+        (il, xl), from the time sample t0:
+
+        >>> u = (np.cos(a), np.sin(a), 0)
+        >>> v = (-np.sin(a), np.cos(a), 0)
+        >>> origin = (il - 31.5 * (u[0] + v[0]), xl - 31.5 * (u[1] + v[1]), t0)
+        >>> box = segy.read_oblique(origin, u, v, (0, 0, 1), (64, 64, 200))
+
+        Return: shape is `shape`
+        """
+
+    def read_horizons(
+        self,
+        horizons: numpy.ndarray,
+        attr: HorizonAttr = HorizonAttr.Amplitude,
+        window: int = 0
+    ) -> numpy.ndarray[numpy.float32]:
+        """
+        the attribute maps along horizons, `horizons` is a (n-inline, 
+        n-crossline) array, or (N, n-inline, n-crossline) for N horizons, of 
+        times in ms, or depths in the unit of the file (NaN where absent). 
+        They are converted to samples with the start time and 
+        `sample_interval()`, the resampled one if `setResample` is used. The 
+        window is the samples within +/- `window` samples of the nearest 
+        one. Only the samples around the horizons are read, once for all of 
+        them.
+
+        Return: the same shape as `horizons`, filled where there is no trace 
+        or horizon
+        """
+
+    def write(self,
+              src: numpy.ndarray,
+              startZ: int = 0,
+              startY: int = 0,
+              startX: int = 0) -> None:
+        """
+        update the samples of the file in place, `src` is a (n-inline, 
+        n-crossline, n-time) array written from (startZ, startY, startX), 
+        e.g., an edited patch or a read-modify-write of some inlines. The 
+        samples are encoded into the traces found by `scan()`, the headers 
+        are not changed. The missing traces are skipped, the values are 
+        written as given (without the transform). The edit is synced to the 
+        disk before it returns.
+
+        >>> d = Pysegy('f3.segy')
+        >>> x = d.read(100, 120, 0, d.shape(1), 0, d.shape(0))
+        >>> d.write(x * 2, 100)
+        """
+
+    def fill(self, value: float, startZ: int, endZ: int, startY: int,
+             endY: int, startX: int, endX: int) -> None:
+        """
+        set the samples of the file in place, e.g., `fill(0, ...)` mutes a 
+        zone. See `write()`.
+        """
+
     def scan(self) -> None:
         """
         scan the whole segy file
@@ -129,12 +560,136 @@ class Pysegy():
         can be any float number or np.nan
         """
 
+    def setVariableLength(self, variable: bool) -> None:
+        """
+        read the segy file as variable length traces (for reading segy),
+        i.e., each trace has its own number of samples (bytes 115-116).
+        The trace offsets are indexed once, and shorter traces are filled
+        with the fill value. It is enabled automatically for SEG-Y rev 2
+        files whose fixed length trace flag is 0.
+        """
+
+    def setWriteMode(self, mode: WriteMode) -> None:
+        """
+        set how `tofile` and `create` write the output file, 
+        WriteMode.MMap (default), WriteMode.Stream or WriteMode.Pipeline
+        """
+
+    def setThreads(self, threads: int) -> None:
+        """
+        number of decode threads of WriteMode.Pipeline, 0 (default) is one 
+        per core
+        """
+
+    def setMemoryBudget(self, bytes: int) -> None:
+        """
+        memory of the inline blocks in flight of WriteMode.Pipeline, 
+        default is 512 MB
+        """
+
+    def setDirectIO(self, direct: bool) -> None:
+        """
+        write the output of WriteMode.Pipeline with O_DIRECT, bypassing the 
+        page cache, default is False
+        """
+
+    def setSparse(self, sparse: bool) -> None:
+        """
+        `tofile` leaves the pages of zeros (e.g., the missing traces with 
+        the fill value 0) as holes of a sparse file, which take no disk 
+        space. Read it by `fromfile_binary` to skip the holes. The memory 
+        map mode writes as WriteMode.Pipeline.
+        """
+
+    def sparse_bytes(self) -> int:
+        """
+        bytes left as holes by the last `tofile`
+        """
+
+    def setTransform(self, transform: Transform) -> None:
+        """
+        clip and scale the samples while decoding them, e.g., 
+        ```
+        t = cigsegy.Transform()
+        t.clip_percentile = 99
+        t.scaling = cigsegy.Scaling.Inline
+        segy.setTransform(t)
+        ```
+        """
+
+    def transform(self) -> Transform:
+        """
+        the transform of the reads
+        """
+
+    def setResample(self, interval: int) -> None:
+        """
+        resample the traces to `interval` (us) while decoding them, e.g., 
+        4000 for 4 ms data from a 1 ms survey, or a smaller interval to 
+        upsample. A polyphase windowed sinc filter is used, with an 
+        anti-alias cutoff at 90% of the new Nyquist frequency when 
+        downsampling. It applies to all reads and `tofile`, `shape()[0]` 
+        and `sample_interval()` become the ones of the resampled traces, 
+        and the resampled lines are read on `setThreads` threads. 0 for 
+        the interval of the file.
+        """
+
+    def sample_interval(self) -> int:
+        """
+        the sample interval (us) of the reads
+        """
+
+    def setAccessHint(self, hint: AccessHint) -> None:
+        """
+        override the access hint chosen by each read call (for reading segy),
+        default is AccessHint.Auto
+        """
+
+    def setVerbose(self, verbose: bool) -> None:
+        """
+        show the progress bar and the time of read, tofile and create,
+        default is True
+        """
+
+    def setDetectDead(self, detect: bool) -> None:
+        """
+        `scan` also finds the dead traces, i.e., marked as dead by the trace 
+        identification code (bytes 29-30) or with all samples zero. The 
+        reads fill them with the fill value without decoding them. It costs 
+        a pass over all samples, default is False
+        """
+
+    def dead_count(self) -> int:
+        """
+        number of dead traces found by `scan` (need `setDetectDead(True)`)
+        """
+
+    def dead_mask(self) -> numpy.ndarray[numpy.uint8]:
+        """
+        the state of each trace, shape is (n-inline, n-crossline), 
+        0: live, 1: dead, 2: missing. Use it to mask the volume, e.g., 
+        `np.ma.masked_array(d, np.broadcast_to(mask[..., None] > 0, d.shape))`
+        """
+
+    def backend(self) -> Backend:
+        """
+        the storage backend in use (io_uring may fall back to pread)
+        """
+
     def setInlineLocation(self, iline: int) -> None:
         """ 
         set the crossline field of trace headers (for reading segy)
         recommend: 189, 5, 9, default is 189.
         """
 
+    def setLine2D(self, keyloc: int = 21) -> None:
+        """
+        read the file as a 2D line (for reading segy), the traces are 
+        indexed by the key in `keyloc`, 21 for CDP, 1 or 5 for trace 
+        sequence number. Scanning a 2D line only visits the first 
+        and the last trace.
+        """
+
     def setXLocation(self, xfield: int) -> None:
         """
         set the x field of trace headers (for reading segy)
@@ -212,6 +767,250 @@ class Pysegy():
     pass
 
 
+class SegyStream():
+    """
+    Read a segy file sequentially, e.g., from a pipe or stdin, nothing is 
+    mapped and no seek is needed. The traces must be sorted by inline, the 
+    data is emitted one inline at a time. gzip and zstd compressed input is 
+    decompressed on the fly.
+    """
+
+    @typing.overload
+    def __init__(self, segy_name: str) -> None:
+        """
+        Parameters:
+        - segy_name: the input segy file, "-" for stdin
+        """
+
+    @typing.overload
+    def __init__(self, fd: int) -> None:
+        """
+        Parameters:
+        - fd: a file descriptor (e.g., a pipe), it isn't closed
+        """
+
+    def setInlineLocation(self, iline: int) -> None:
+        """ 
+        set the inline field of trace headers, default is 189
+        """
+
+    def setCrosslineLocation(self, xline: int) -> None:
+        """
+        set the crossline field of trace headers, default is 193
+        """
+
+    def setFillNoValue(self, fills: float) -> None:
+        """ 
+        set a value for filling the missing traces of `tofile`
+        """
+
+    def setCrosslineRange(self, min_xline: int, max_xline: int) -> None:
+        """
+        the crossline range of the output of `tofile`, the traces out of 
+        it are dropped. Otherwise it is taken from the traces, and the written lines are rearranged in 
+        place when a later inline extends it.
+        """
+
+    def textual_header(self) -> str:
+        """
+        the 3200 bytes textual header
+        """
+
+    def next_line(self) -> typing.Optional[typing.Tuple[int, numpy.ndarray, numpy.ndarray]]:
+        """
+        read the next inline, returns (inline, crosslines, traces), 
+        crosslines has shape (n-trace, ) and traces has shape 
+        (n-trace, n-time). Returns None at the end of the stream.
+        """
+
+    def tofile(self, binary_out_name: str) -> None:
+        """
+        write the rest of the stream as a binary file with shape 
+        (n-inline, n-crossline, n-time) like `Pysegy.tofile`, the missing 
+        traces and inlines are filled.
+        """
+
+    def shape(self) -> typing.Tuple[int, int, int]:
+        """
+        (n-inline, n-crossline, n-time) of the inlines read so far, 
+        n-crossline is known after `tofile`
+        """
+
+
+
+class MultiSegy():
+    """
+    Several segy files of the same geometry, e.g., the attributes of one 
+    survey, read as the channels of one array. Only the first file is 
+    scanned, the others share its index after a check of their sizes and 
+    of the first and last trace of each inline. The files are read in 
+    parallel, one thread for each.
+    """
+
+    def __init__(self,
+                 segy_names: typing.List[str],
+                 backend: Backend = Backend.MMap) -> None:
+        """
+        Parameters:
+        - segy_names: the N segy files, the channels in this order
+        - backend: how the trace data of each file is read
+        """
+
+    def setInlineLocation(self, iline: int) -> None:
+        """ 
+        set the inline field of trace headers, default is 189
+        """
+
+    def setCrosslineLocation(self, xline: int) -> None:
+        """
+        set the crossline field of trace headers, default is 193
+        """
+
+    def setFillNoValue(self, fills: float) -> None:
+        """ 
+        set a value for filling the missing traces
+        """
+
+    def setResample(self, interval: int) -> None:
+        """
+        resample the traces of all the files to `interval` (us), see 
+        `Pysegy.setResample`
+        """
+
+    def setThreads(self, threads: int) -> None:
+        """
+        the number of files read at the same time, 0 for one per core
+        """
+
+    def scan(self) -> None:
+        """
+        scan the first file, the others share its index
+        """
+
+    def shape(self) -> typing.Tuple[int, int, int, int]:
+        """
+        (N, n-inline, n-crossline, n-time)
+        """
+
+    @typing.overload
+    def read(self, channels_last: bool = False) -> numpy.ndarray[numpy.float32]:
+        """
+        read all the files
+
+        Return: shape is (N, n-inline, n-crossline, n-time), or 
+        (n-inline, n-crossline, n-time, N) if `channels_last`
+        """
+
+    @typing.overload
+    def read(self,
+             startZ: int,
+             endZ: int,
+             startY: int,
+             endY: int,
+             startX: int,
+             endX: int,
+             channels_last: bool = False) -> numpy.ndarray[numpy.float32]:
+        """
+        read the same subvolume of all the files
+
+        Return: shape is (N, endZ - startZ, endY - startY, endX - startX), 
+        or channels last
+        """
+
+    def read_patches(self,
+                     starts: numpy.ndarray,
+                     size: typing.Sequence[int],
+                     channels_last: bool = False) -> numpy.ndarray[numpy.float32]:
+        """
+        read the same patches of all the files, `starts` is a (P, 3) array 
+        of the (inline, crossline, time) indices of the patches, `size` is 
+        (sizeZ, sizeY, sizeX)
+
+        Return: shape is (P, N, sizeZ, sizeY, sizeX), or 
+        (P, sizeZ, sizeY, sizeX, N) if `channels_last`
+        """
+
+
+class SegyWriter():
+    """
+    Create a segy file one block of inlines at a time, e.g., the output of 
+    an inference patch by patch, without the whole volume in memory. The 
+    blocks can be written in any order and from several threads at once. 
+    The trace headers are the ones of `Pysegy.create`.
+
+    >>> w = cigsegy.SegyWriter(nt, nx, ni)
+    >>> w.setSampleInterval(2000)
+    >>> w.open('out.sgy')
+    >>> for i in range(0, ni, 16):
+    >>>     w.write_lines(predict(i, i + 16), i)
+    >>> w.close()
+    """
+
+    def __init__(self, sizeX: int, sizeY: int, sizeZ: int) -> None:
+        """
+        Parameters:
+        - sizeX: the number of samples per trace,
+        - sizeY: the number of crossline,
+        - sizeZ: the number of inline.
+        """
+
+    def setSampleInterval(self, dt: int) -> None:
+        """
+        set the sample interval (us), before `open`
+        """
+
+    def setDataFormatCode(self, format: int) -> None:
+        """
+        1 for 4 bytes IBM float, 5 for 4 bytes IEEE float (default), 
+        before `open`
+        """
+
+    def setStartTime(self, start_time: int) -> None:
+        """
+        set the start time, before `open`
+        """
+
+    def setXInterval(self, dx: float) -> None:
+        """
+        set the inline interval, before `open`
+        """
+
+    def setYInterval(self, dy: float) -> None:
+        """
+        set the crossline interval, before `open`
+        """
+
+    def setMinInline(self, minInline: int) -> None:
+        """
+        set the first inline number, before `open`
+        """
+
+    def setMinCrossline(self, minXline: int) -> None:
+        """
+        set the first crossline number, before `open`
+        """
+
+    def open(self, segy_out_name: str) -> None:
+        """
+        create the file and write its textual and binary headers
+        """
+
+    def write_lines(self, src: numpy.ndarray[numpy.float32], startZ: int) -> None:
+        """
+        write the inlines [startZ, startZ + N), `src` is (N, n-crossline, 
+        n-time). Other python threads run while it is written.
+        """
+
+    def lines_written(self) -> int:
+        """
+        the number of inlines written so far
+        """
+
+    def close(self) -> None:
+        """
+        close the file, the inlines never written are zeros
+        """
+
 def fromfile(segy_name: str,
              iline: int = 189,
              xline: int = 193) -> numpy.ndarray[numpy.float32]:
@@ -225,6 +1024,18 @@ def fromfile(segy_name: str,
     """
 
 
+def fromfile_2d(segy_name: str,
+                keyloc: int = 21) -> numpy.ndarray[numpy.float32]:
+    """
+    reading a 2D line from a segy file, the shape is (n-trace, n-time).
+
+    Parameters:
+    - segy_name: the input segy file name
+    - keyloc: the trace key field in each trace header, 21 for CDP, 
+    1 or 5 for trace sequence number
+    """
+
+
 def fromfile_ignore_header(segy_name: str,
                            sizeZ: int,
                            sizeY: int,
@@ -242,12 +1053,27 @@ def fromfile_ignore_header(segy_name: str,
     """
 
 
+def fromfile_binary(binary_name: str, sizeZ: int, sizeY: int,
+                    sizeX: int) -> numpy.ndarray[numpy.float32]:
+    """
+    read a binary file written by `tofile`, the holes of a sparse file 
+    (`Pysegy.setSparse`) are zero-filled without reading them
+
+    Parameters:
+    - binary_name: the binary file
+    - sizeZ: number of inline
+    - sizeY: number of crossline
+    - sizeX: number of samples per trace
+    """
+
+
 def tofile(segy_name: str,
            out_name: str,
            iline: int = 189,
            xline: int = 193) -> None:
     """
-    convert a segy file to a binary file
+    convert a segy file to a binary file, a gzip or zstd compressed file 
+    is decompressed on the fly in one sequential pass
 
     Parameters:
     - segy_name: the input segy file name
@@ -302,6 +1128,7 @@ def collect(
     """
 
 
+@typing.overload
 def create_by_sharing_header(segy_name: str,
                              header_segy: str,
                              src: numpy.ndarray[numpy.float32],
@@ -317,3 +1144,26 @@ def create_by_sharing_header(segy_name: str,
     - iline: int, the inline number field of header segy
     - xline: int, the crossline number field of header segy
     """
+
+
+@typing.overload
+def create_by_sharing_header(segy_names: typing.List[str],
+                             header_segy: str,
+                             srcs: typing.List[numpy.ndarray[numpy.float32]],
+                             iline: int = 189,
+                             xline: int = 193,
+                             threads: int = 0):
+    """
+    create several segy files whose headers are from an existed segy, 
+    e.g., the predicted attributes of a survey. The header segy is scanned 
+    and mapped once, the outputs are written in parallel.
+
+    Parameters:
+    - segy_names: List[str], the out segy names
+    - header_segy: str, the header segy file
+    - srcs: List[numpy.ndarray], the source data of each output, all with 
+      the same shape
+    - iline: int, the inline number field of header segy
+    - xline: int, the crossline number field of header segy
+    - threads: int, the number of threads, 0 for one per core
+    """
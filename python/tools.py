@@ -1,6 +1,6 @@
 import numpy
 from typing import Tuple
-from .cigsegy import (Pysegy, collect)
+from .cigsegy import (Pysegy, SegyStream, collect)
 
 
 def create(segy_out: str,
@@ -112,6 +112,50 @@ def read_with_step(segy_name, iline, xline, iline_step,
     return data
 
 
+def iter_line_2d(segy_name: str, chunk: int = 4096, keyloc: int = 21):
+    """
+    Iterate over a (very long) 2D line in chunks of traces, 
+    each chunk is a numpy.ndarray with shape (n-trace, n-time)
+
+    Parameters:
+        - segy_name: str, the input segy file
+        - chunk: int, number of traces in each chunk
+        - keyloc: int, the trace key field, 21 for CDP, 1 or 5 for trace sequence number
+    """
+    segy = Pysegy(segy_name)
+    # no progress bar for each chunk
+    segy.setVerbose(False)
+    segy.setLine2D(keyloc)
+    segy.scan()
+    ntrace = segy.shape(1)
+    for start in range(0, ntrace, chunk):
+        yield segy.read_line2d(start, min(start + chunk, ntrace))
+    segy.close_file()
+
+
+def iter_stream(source: str or int, iline: int = 189, xline: int = 193):
+    """
+    Iterate over the inlines of a segy file read sequentially, e.g., from
+    a pipe, yields (inline, crosslines, traces), crosslines is a 
+    numpy.ndarray with shape (n-trace, ) and traces with shape 
+    (n-trace, n-time). The traces must be sorted by inline.
+
+    Parameters:
+        - source: str or int, the file name ("-" for stdin) or a file 
+            descriptor
+        - iline: int, the inline field in trace headers
+        - xline: int, the crossline field in trace headers
+    """
+    stream = SegyStream(source)
+    stream.setInlineLocation(iline)
+    stream.setCrosslineLocation(xline)
+    while True:
+        line = stream.next_line()
+        if line is None:
+            break
+        yield line
+
+
 def textual_header(segy_name: str):
     segy = Pysegy(segy_name)
     print(segy.textual_header())
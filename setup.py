@@ -37,24 +37,48 @@ def write_version_file():
 write_version_file()
 
 
+def has_header(name, include_dirs):
+    dirs = include_dirs + ['/usr/include', '/usr/local/include']
+    if 'CONDA_PREFIX' in os.environ:
+        dirs.append(str(Path(os.environ['CONDA_PREFIX']) / 'include'))
+    return any((Path(d) / name).exists() for d in dirs)
+
+
 def get_extensions():
     # add segy
     ext_modules = []
-    sources = ['src/segy.cpp', 'python/PySegy.cpp']
+    sources = [
+        'src/segy.cpp', 'src/geometry.cpp', 'src/output.cpp',
+        'src/storage.cpp', 'src/stream.cpp', 'src/compress.cpp',
+        'src/zonemap.cpp', 'src/stats.cpp', 'src/transform.cpp',
+        'src/convert.cpp', 'src/resample.cpp', 'src/extract.cpp',
+        'src/multi.cpp', 'src/writer.cpp', 'src/update.cpp',
+        'python/PySegy.cpp'
+    ]
     include_dirs = ['src/include']
     if fmt_root:
         include_dirs.append(str(Path(fmt_root) / 'include'))
-    extra_compile_args = ["-std=c++11", "-Wall"]
-    extra_link_args = []
+    extra_compile_args = ["-std=c++11", "-Wall", "-pthread"]
+    extra_link_args = ["-pthread"]
     # extra_link_args = ['-lfmt']
     extra_compile_args += ["-O3"]
 
+    # optional, reading gzip and zstd compressed segy files
+    libraries = []
+    if has_header('zlib.h', include_dirs):
+        extra_compile_args.append('-DCIGSEGY_ZLIB')
+        libraries.append('z')
+    if has_header('zstd.h', include_dirs):
+        extra_compile_args.append('-DCIGSEGY_ZSTD')
+        libraries.append('zstd')
+
     ext_modules.append(
         Pybind11Extension(name=f'{package_name}/{package_name}',
                           sources=[str(s) for s in sources],
                           include_dirs=include_dirs,
                           extra_compile_args=extra_compile_args,
-                          extra_link_args=extra_link_args))
+                          extra_link_args=extra_link_args,
+                          libraries=libraries))
 
     return ext_modules
 
@@ -0,0 +1,465 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: compress.cpp
+** @Time: 2026/10/19 20:12:36
+** @Version: 1.0
+** @Description : read gzip and zstd compressed segy files
+*********************************************************************/
+
+#include "compress.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+#include <vector>
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#include "mio.hpp"
+
+// both are optional, see CMakeLists.txt and setup.py
+#ifdef CIGSEGY_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CIGSEGY_ZSTD
+#include <zstd.h>
+#endif
+
+namespace segy {
+
+// the magic numbers of the zstd seekable format
+const uint32_t kZstdSkippableMagic = 0x184D2A50;
+const uint32_t kZstdSeekTableMagic = 0x8F92EAB1;
+const int kZstdSeekFooterSize = 9;
+const int kZstdSkippableHeaderSize = 8;
+
+static inline uint32_t le32(const char *p) {
+  const auto *b = reinterpret_cast<const unsigned char *>(p);
+  return b[0] | (b[1] << 8) | (b[2] << 16) |
+         (static_cast<uint32_t>(b[3]) << 24);
+}
+
+Compression detect_compression(const char *data, size_t size) {
+  const auto *b = reinterpret_cast<const unsigned char *>(data);
+  if (size >= 2 && b[0] == 0x1f && b[1] == 0x8b) {
+    return Compression::Gzip;
+  }
+  if (size >= 4 && (le32(data) == 0xFD2FB528 ||
+                    (le32(data) & 0xFFFFFFF0) == kZstdSkippableMagic)) {
+    return Compression::Zstd;
+  }
+  return Compression::None;
+}
+
+Compression file_compression(const std::string &name) {
+  char magic[4];
+  int fd = open(name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return Compression::None;
+  }
+  ssize_t n = ::read(fd, magic, sizeof(magic));
+  close(fd);
+  return n > 0 ? detect_compression(magic, n) : Compression::None;
+}
+
+// the bytes read to detect the compression, then the rest of `source`
+class PrefixSource : public ByteSource {
+public:
+  PrefixSource(const std::string &prefix, std::unique_ptr<ByteSource> source)
+      : m_prefix(prefix), m_source(std::move(source)) {}
+  size_t read(char *dst, size_t n) override {
+    if (m_pos < m_prefix.size()) {
+      n = std::min(n, m_prefix.size() - m_pos);
+      memcpy(dst, m_prefix.data() + m_pos, n);
+      m_pos += n;
+      return n;
+    }
+    return m_source->read(dst, n);
+  }
+
+private:
+  std::string m_prefix;
+  size_t m_pos = 0;
+  std::unique_ptr<ByteSource> m_source;
+};
+
+#ifdef CIGSEGY_ZLIB
+
+// inflates a gzip stream, concatenated members are read one after another
+class GzipSource : public ByteSource {
+public:
+  explicit GzipSource(std::unique_ptr<ByteSource> source)
+      : m_source(std::move(source)), m_input(kStreamReadSize) {
+    memset(&m_z, 0, sizeof(m_z));
+    // 15 + 32: the largest window, and detect the gzip or zlib header
+    if (inflateInit2(&m_z, 15 + 32) != Z_OK) {
+      throw std::runtime_error("inflateInit2 failed");
+    }
+  }
+  ~GzipSource() override { inflateEnd(&m_z); }
+
+  size_t read(char *dst, size_t n) override {
+    // avail_out is 32 bits
+    n = std::min<size_t>(n, 1u << 30);
+    m_z.next_out = reinterpret_cast<Bytef *>(dst);
+    m_z.avail_out = static_cast<uInt>(n);
+    while (m_z.avail_out == n) {
+      if (m_z.avail_in == 0 && !fill()) {
+        if (m_inMember) {
+          throw std::runtime_error("The gzip stream is truncated");
+        }
+        return 0;
+      }
+      int ret = inflate(&m_z, Z_NO_FLUSH);
+      if (ret == Z_STREAM_END) {
+        inflateReset(&m_z);
+        m_inMember = false;
+      } else if (ret == Z_OK || ret == Z_BUF_ERROR) {
+        m_inMember = true;
+      } else {
+        throw std::runtime_error(fmt::format(
+            "Invalid gzip stream: {}", m_z.msg ? m_z.msg : "unknown error"));
+      }
+    }
+    return n - m_z.avail_out;
+  }
+
+private:
+  std::unique_ptr<ByteSource> m_source;
+  std::vector<char> m_input;
+  z_stream m_z;
+  bool m_inMember = false;
+
+  bool fill() {
+    size_t got = m_source->read(m_input.data(), m_input.size());
+    m_z.next_in = reinterpret_cast<Bytef *>(m_input.data());
+    m_z.avail_in = static_cast<uInt>(got);
+    return got > 0;
+  }
+};
+
+#endif
+
+#ifdef CIGSEGY_ZSTD
+
+class ZstdSource : public ByteSource {
+public:
+  explicit ZstdSource(std::unique_ptr<ByteSource> source)
+      : m_source(std::move(source)), m_input(kStreamReadSize) {
+    m_stream = ZSTD_createDStream();
+    if (m_stream == nullptr) {
+      throw std::runtime_error("ZSTD_createDStream failed");
+    }
+    ZSTD_initDStream(m_stream);
+    m_in.src = m_input.data();
+    m_in.size = 0;
+    m_in.pos = 0;
+  }
+  ~ZstdSource() override { ZSTD_freeDStream(m_stream); }
+
+  size_t read(char *dst, size_t n) override {
+    ZSTD_outBuffer out = {dst, n, 0};
+    while (out.pos == 0) {
+      if (m_in.pos == m_in.size) {
+        m_in.size = m_source->read(m_input.data(), m_input.size());
+        m_in.pos = 0;
+        if (m_in.size == 0) {
+          if (m_inFrame) {
+            throw std::runtime_error("The zstd stream is truncated");
+          }
+          return 0;
+        }
+      }
+      size_t ret = ZSTD_decompressStream(m_stream, &out, &m_in);
+      if (ZSTD_isError(ret)) {
+        throw std::runtime_error(fmt::format("Invalid zstd stream: {}",
+                                             ZSTD_getErrorName(ret)));
+      }
+      m_inFrame = ret != 0;
+    }
+    return out.pos;
+  }
+
+private:
+  std::unique_ptr<ByteSource> m_source;
+  std::vector<char> m_input;
+  ZSTD_DStream *m_stream;
+  ZSTD_inBuffer m_in;
+  bool m_inFrame = false;
+};
+
+class ZstdStorage : public Storage {
+public:
+  explicit ZstdStorage(const std::string &name);
+  ~ZstdStorage() override { ZSTD_freeDCtx(m_dctx); }
+  Backend backend() const override { return Backend::Zstd; }
+  const char *fetch(uint64_t offset, uint64_t size) override;
+  void fetch_many(const uint64_t *offsets, const uint64_t *sizes, size_t n,
+                  char *dst, uint64_t stride) override;
+  uint64_t size() const { return m_size; }
+
+private:
+  struct Frame {
+    uint64_t offset; // in the compressed file
+    uint64_t csize;
+    uint64_t start; // in the decompressed file
+    uint64_t size;
+  };
+  struct Slot {
+    size_t frame;
+    uint64_t used;
+    std::vector<char> data;
+  };
+
+  mio::mmap_source m_file;
+  ZSTD_DCtx *m_dctx;
+  std::vector<Frame> m_frames;
+  std::vector<Slot> m_cache;
+  uint64_t m_clock = 0;
+  uint64_t m_size = 0;
+  std::vector<char> m_buffer;
+
+  void add_frame(uint64_t offset, uint64_t csize, uint64_t size);
+  bool read_seek_table();
+  void scan_frames();
+  size_t find_frame(uint64_t offset) const;
+  const char *frame_data(size_t i);
+  void copy(char *dst, uint64_t offset, uint64_t size);
+};
+
+ZstdStorage::ZstdStorage(const std::string &name) {
+  std::error_code error;
+  m_file.map(name, error);
+  if (error) {
+    throw std::runtime_error("Cannot mmap segy file");
+  }
+  m_dctx = ZSTD_createDCtx();
+  if (m_dctx == nullptr) {
+    throw std::runtime_error("ZSTD_createDCtx failed");
+  }
+  try {
+    if (!read_seek_table()) {
+      scan_frames();
+    }
+    if (m_frames.empty()) {
+      throw std::runtime_error("No data in this zstd file");
+    }
+    for (const Frame &f : m_frames) {
+      if (f.size > kZstdMaxFrameSize) {
+        throw std::runtime_error(fmt::format(
+            "The zstd file has a frame of {} MB, it can only be read "
+            "sequentially (SegyStream, tofile), or recompress it with "
+            "smaller frames for random access",
+            f.size / 1024 / 1024));
+      }
+    }
+  } catch (...) {
+    ZSTD_freeDCtx(m_dctx);
+    throw;
+  }
+}
+
+void ZstdStorage::add_frame(uint64_t offset, uint64_t csize, uint64_t size) {
+  if (offset + csize > m_file.size()) {
+    throw std::runtime_error("The zstd file is truncated");
+  }
+  if (size > 0) {
+    m_frames.push_back({offset, csize, m_size, size});
+    m_size += size;
+  }
+}
+
+bool ZstdStorage::read_seek_table() {
+  // [skippable header][entries][number of frames, descriptor, magic]
+  uint64_t fsize = m_file.size();
+  if (fsize < kZstdSeekFooterSize + kZstdSkippableHeaderSize) {
+    return false;
+  }
+  const char *footer = m_file.data() + fsize - kZstdSeekFooterSize;
+  if (le32(footer + 5) != kZstdSeekTableMagic) {
+    return false;
+  }
+  uint64_t nframes = le32(footer);
+  bool checksum = static_cast<unsigned char>(footer[4]) & 0x80;
+  uint64_t entry = checksum ? 12 : 8;
+  uint64_t table = nframes * entry + kZstdSeekFooterSize;
+  if (table + kZstdSkippableHeaderSize > fsize) {
+    return false;
+  }
+  const char *header = footer + kZstdSeekFooterSize - table -
+                       kZstdSkippableHeaderSize;
+  if ((le32(header) & 0xFFFFFFF0) != kZstdSkippableMagic ||
+      le32(header + 4) != table) {
+    return false;
+  }
+
+  uint64_t offset = 0;
+  const char *p = header + kZstdSkippableHeaderSize;
+  for (uint64_t i = 0; i < nframes; i++, p += entry) {
+    add_frame(offset, le32(p), le32(p + 4));
+    offset += le32(p);
+  }
+  return true;
+}
+
+void ZstdStorage::scan_frames() {
+  // ZSTD_findFrameCompressedSize only walks the block headers
+  uint64_t pos = 0;
+  while (pos < m_file.size()) {
+    const char *src = m_file.data() + pos;
+    size_t left = m_file.size() - pos;
+    size_t csize = ZSTD_findFrameCompressedSize(src, left);
+    if (ZSTD_isError(csize)) {
+      throw std::runtime_error(fmt::format("Invalid zstd frame at byte {}: {}",
+                                           pos, ZSTD_getErrorName(csize)));
+    }
+    if (left >= 4 && (le32(src) & 0xFFFFFFF0) != kZstdSkippableMagic) {
+      unsigned long long size = ZSTD_getFrameContentSize(src, left);
+      if (size == ZSTD_CONTENTSIZE_UNKNOWN || size == ZSTD_CONTENTSIZE_ERROR) {
+        throw std::runtime_error(
+            "The zstd frames don't record their sizes (e.g., compressed "
+            "from a pipe), it can only be read sequentially (SegyStream, "
+            "tofile)");
+      }
+      add_frame(pos, csize, size);
+    }
+    pos += csize;
+  }
+}
+
+size_t ZstdStorage::find_frame(uint64_t offset) const {
+  if (offset >= m_size) {
+    throw std::runtime_error("read beyond the end of the zstd file");
+  }
+  auto it = std::upper_bound(
+      m_frames.begin(), m_frames.end(), offset,
+      [](uint64_t value, const Frame &f) { return value < f.start; });
+  return (it - m_frames.begin()) - 1;
+}
+
+const char *ZstdStorage::frame_data(size_t i) {
+  m_clock++;
+  Slot *slot = nullptr;
+  for (Slot &s : m_cache) {
+    if (s.frame == i) {
+      s.used = m_clock;
+      return s.data.data();
+    }
+    if (slot == nullptr || s.used < slot->used) {
+      slot = &s;
+    }
+  }
+  if (m_cache.size() < static_cast<size_t>(kZstdCacheFrames)) {
+    m_cache.push_back(Slot());
+    slot = &m_cache.back();
+  }
+
+  // the least recently used frame is replaced
+  const Frame &f = m_frames[i];
+  slot->frame = i;
+  slot->used = m_clock;
+  slot->data.resize(f.size);
+  size_t ret = ZSTD_decompressDCtx(m_dctx, slot->data.data(), f.size,
+                                   m_file.data() + f.offset, f.csize);
+  if (ZSTD_isError(ret) || ret != f.size) {
+    slot->frame = m_frames.size();
+    throw std::runtime_error(fmt::format(
+        "Decompress zstd frame {} failed: {}", i,
+        ZSTD_isError(ret) ? ZSTD_getErrorName(ret) : "wrong size"));
+  }
+  return slot->data.data();
+}
+
+void ZstdStorage::copy(char *dst, uint64_t offset, uint64_t size) {
+  if (size == 0) {
+    return;
+  }
+  size_t i = find_frame(offset);
+  while (size > 0) {
+    if (i >= m_frames.size()) {
+      throw std::runtime_error("read beyond the end of the zstd file");
+    }
+    const Frame &f = m_frames[i];
+    uint64_t n = std::min(size, f.start + f.size - offset);
+    memcpy(dst, frame_data(i) + (offset - f.start), n);
+    dst += n;
+    offset += n;
+    size -= n;
+    i++;
+  }
+}
+
+const char *ZstdStorage::fetch(uint64_t offset, uint64_t size) {
+  size_t i = find_frame(offset);
+  const Frame &f = m_frames[i];
+  if (offset + size <= f.start + f.size) {
+    return frame_data(i) + (offset - f.start);
+  }
+  if (m_buffer.size() < size) {
+    m_buffer.resize(size);
+  }
+  copy(m_buffer.data(), offset, size);
+  return m_buffer.data();
+}
+
+void ZstdStorage::fetch_many(const uint64_t *offsets, const uint64_t *sizes,
+                             size_t n, char *dst, uint64_t stride) {
+  for (size_t i = 0; i < n; i++) {
+    copy(dst + i * stride, offsets[i], sizes[i]);
+  }
+}
+
+#endif
+
+std::unique_ptr<ByteSource>
+open_decompressed(std::unique_ptr<ByteSource> source) {
+  char magic[4];
+  size_t n = 0;
+  while (n < sizeof(magic)) {
+    size_t got = source->read(magic + n, sizeof(magic) - n);
+    if (got == 0) {
+      break;
+    }
+    n += got;
+  }
+  Compression compression = detect_compression(magic, n);
+  std::unique_ptr<ByteSource> raw(
+      new PrefixSource(std::string(magic, n), std::move(source)));
+
+  if (compression == Compression::Gzip) {
+#ifdef CIGSEGY_ZLIB
+    return std::unique_ptr<ByteSource>(new GzipSource(std::move(raw)));
+#else
+    throw std::runtime_error("The input is gzip compressed, but this build "
+                             "has no zlib, use 'gunzip -c' as a pipe");
+#endif
+  }
+  if (compression == Compression::Zstd) {
+#ifdef CIGSEGY_ZSTD
+    return std::unique_ptr<ByteSource>(new ZstdSource(std::move(raw)));
+#else
+    throw std::runtime_error("The input is zstd compressed, but this build "
+                             "has no libzstd, use 'zstd -dc' as a pipe");
+#endif
+  }
+  return raw;
+}
+
+std::unique_ptr<Storage> open_zstd(const std::string &name, uint64_t &size) {
+#ifdef CIGSEGY_ZSTD
+  ZstdStorage *storage = new ZstdStorage(name);
+  size = storage->size();
+  return std::unique_ptr<Storage>(storage);
+#else
+  (void)size;
+  throw std::runtime_error(fmt::format(
+      "{} is zstd compressed, but this build has no libzstd", name));
+#endif
+}
+
+} // namespace segy
@@ -0,0 +1,267 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: convert.cpp
+** @Time: 2026/10/20 00:18:52
+** @Version: 1.0
+** @Description : reduced precision output of the reads
+*********************************************************************/
+
+#include "convert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define CIGSEGY_F16C
+#endif
+
+#include "segy.h"
+
+namespace segy {
+
+size_t dtype_size(DType dtype) {
+  switch (dtype) {
+  case DType::Float32:
+    return 4;
+  case DType::Float16:
+  case DType::BFloat16:
+  case DType::Int16:
+    return 2;
+  case DType::Int8:
+    return 1;
+  }
+  return 4;
+}
+
+float dtype_max(DType dtype) {
+  return dtype == DType::Int8 ? 127 : (dtype == DType::Int16 ? 32767 : 0);
+}
+
+static inline uint16_t float_to_half(float f) {
+  uint32_t x;
+  memcpy(&x, &f, sizeof(x));
+  uint32_t sign = (x >> 16) & 0x8000;
+  uint32_t exp = (x >> 23) & 0xFF;
+  uint32_t mant = x & 0x7FFFFF;
+  if (exp == 0xFF) {
+    return sign | 0x7C00 | (mant ? 0x200 : 0);
+  }
+  int e = static_cast<int>(exp) - 127 + 15;
+  if (e >= 31) {
+    return sign | 0x7C00;
+  }
+  if (e <= 0) {
+    // a subnormal half, or zero
+    if (e < -10) {
+      return sign;
+    }
+    mant |= 0x800000;
+    int shift = 14 - e;
+    uint32_t half = mant >> shift;
+    uint32_t rem = mant & ((1u << shift) - 1);
+    uint32_t mid = 1u << (shift - 1);
+    if (rem > mid || (rem == mid && (half & 1))) {
+      half++;
+    }
+    return sign | half;
+  }
+  // rounding to nearest even, a carry moves into the exponent
+  uint32_t half = sign | (e << 10) | (mant >> 13);
+  uint32_t rem = mant & 0x1FFF;
+  if (rem > 0x1000 || (rem == 0x1000 && (half & 1))) {
+    half++;
+  }
+  return half;
+}
+
+#ifdef CIGSEGY_F16C
+__attribute__((target("avx,f16c"))) static size_t
+to_half_f16c(const float *src, uint16_t *dst, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i),
+                                _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), h);
+  }
+  return i;
+}
+#endif
+
+static void to_half(const float *src, uint16_t *dst, size_t n) {
+  size_t i = 0;
+#ifdef CIGSEGY_F16C
+  static const bool has_f16c = __builtin_cpu_supports("f16c");
+  if (has_f16c) {
+    i = to_half_f16c(src, dst, n);
+  }
+#endif
+  for (; i < n; i++) {
+    dst[i] = float_to_half(src[i]);
+  }
+}
+
+static void to_bfloat16(const float *src, uint16_t *dst, size_t n) {
+  // integer operations only, the compiler vectorizes it
+  for (size_t i = 0; i < n; i++) {
+    uint32_t x;
+    memcpy(&x, src + i, sizeof(x));
+    uint32_t rounded = (x + 0x7FFF + ((x >> 16) & 1)) >> 16;
+    bool nan = (x & 0x7FFFFFFF) > 0x7F800000;
+    dst[i] = static_cast<uint16_t>(nan ? ((x >> 16) | 0x40) : rounded);
+  }
+}
+
+template <typename T>
+static void quantize(const float *src, T *dst, size_t n, float scale,
+                     float max) {
+  size_t i = 0;
+#ifdef __SSE2__
+  // NaN is masked to 0, then clamped, rounded (to nearest even) and packed
+  // with saturation
+  const __m128 vscale = _mm_set1_ps(scale);
+  const __m128 vmax = _mm_set1_ps(max);
+  const __m128 vmin = _mm_set1_ps(-max);
+  for (; i + 8 <= n; i += 8) {
+    __m128 a = _mm_loadu_ps(src + i);
+    __m128 b = _mm_loadu_ps(src + i + 4);
+    a = _mm_and_ps(_mm_div_ps(a, vscale), _mm_cmpeq_ps(a, a));
+    b = _mm_and_ps(_mm_div_ps(b, vscale), _mm_cmpeq_ps(b, b));
+    a = _mm_max_ps(_mm_min_ps(a, vmax), vmin);
+    b = _mm_max_ps(_mm_min_ps(b, vmax), vmin);
+    __m128i w = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+    if (sizeof(T) == 2) {
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), w);
+    } else {
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i),
+                       _mm_packs_epi16(w, w));
+    }
+  }
+#endif
+  for (; i < n; i++) {
+    float v = src[i] == src[i] ? src[i] / scale : 0;
+    v = v > max ? max : (v < -max ? -max : v);
+    dst[i] = static_cast<T>(std::nearbyint(v));
+  }
+}
+
+void convert_samples(const float *src, void *dst, size_t n, DType dtype,
+                     float scale) {
+  switch (dtype) {
+  case DType::Float32:
+    memcpy(dst, src, n * sizeof(float));
+    break;
+  case DType::Float16:
+    to_half(src, static_cast<uint16_t *>(dst), n);
+    break;
+  case DType::BFloat16:
+    to_bfloat16(src, static_cast<uint16_t *>(dst), n);
+    break;
+  case DType::Int16:
+    quantize(src, static_cast<int16_t *>(dst), n, scale, dtype_max(dtype));
+    break;
+  case DType::Int8:
+    quantize(src, static_cast<int8_t *>(dst), n, scale, dtype_max(dtype));
+    break;
+  }
+}
+
+float SegyIO::volume_peak() {
+  requireZoneMap();
+  float peak = 0;
+  for (size_t i = 0; i < m_zoneMap.min.size(); i++) {
+    peak = std::max(peak, m_zoneMap.peak(i));
+  }
+  if (m_clip > 0) {
+    peak = std::min(peak, m_clip);
+  }
+  if (m_transform.scaling == Scaling::Global) {
+    peak *= std::fabs(m_gain);
+  } else if (m_transform.scaling != Scaling::Off) {
+    throw std::runtime_error("The peak of the volume is unknown with this "
+                             "scaling, quantize with the scales per inline");
+  }
+  return peak;
+}
+
+std::vector<float> SegyIO::read_as(void *dst, DType dtype, bool per_inline,
+                                   int startX, int endX, int startY, int endY,
+                                   int startZ, int endZ) {
+  if (dtype == DType::Float32) {
+    read(static_cast<float *>(dst), startX, endX, startY, endY, startZ, endZ);
+    return std::vector<float>();
+  }
+  if (!isReadSegy) {
+    throw std::runtime_error(
+        "'read_as()' function used only in reading segy mode");
+  }
+  if (startX >= endX || startY >= endY || startZ >= endZ) {
+    throw std::runtime_error("Index 'end' must large than 'start'");
+  }
+  if (startX < 0 || endX > shape(0) || startY < 0 ||
+      endY > m_metaInfo.sizeY || startZ < 0 || endZ > m_metaInfo.sizeZ) {
+    throw std::runtime_error("Index out of range");
+  }
+  if (m_metaInfo.data_format != 1 && m_metaInfo.data_format != 5) {
+    throw std::runtime_error("Unsuport sample format");
+  }
+  prepareTransform();
+
+  int sizeX = endX - startX;
+  int sizeY = endY - startY;
+  uint64_t line_size = static_cast<uint64_t>(sizeX) * sizeY;
+  uint64_t line_bytes = line_size * dtype_size(dtype);
+  bool quantized = dtype_quantized(dtype);
+  std::vector<float> scales;
+  float scale = 1;
+  if (quantized && !per_inline) {
+    float peak = volume_peak();
+    scale = peak > 0 ? peak / dtype_max(dtype) : 1;
+    scales.push_back(scale);
+  }
+
+  // Each inline is decoded into a float buffer and converted from it, so
+  // the float volume is never allocated. The scale of an inline is taken
+  // from its buffer.
+  std::vector<float> buffer(line_size);
+  begin_access(choose_hint(startX, endX, startY, endY, startZ, endZ), startZ,
+               endZ);
+  for (int iZ = startZ; iZ < endZ; iZ++) {
+    advance_access(iZ, startZ, endZ);
+    read_line(buffer.data(), iZ, startX, sizeX, startY, endY);
+    if (quantized && per_inline) {
+      // the fill values of the missing, dead and short traces are not
+      // samples, as in volume_peak()
+      float fill = m_metaInfo.fillNoValue;
+      float peak = 0;
+      for (float v : buffer) {
+        if (v != fill) {
+          peak = std::max(peak, std::fabs(v));
+        }
+      }
+      scale = peak > 0 ? peak / dtype_max(dtype) : 1;
+      scales.push_back(scale);
+    }
+    convert_samples(buffer.data(),
+                    static_cast<char *>(dst) + (iZ - startZ) * line_bytes,
+                    line_size, dtype, scale);
+  }
+  return scales;
+}
+
+std::vector<float> SegyIO::read_as(void *dst, DType dtype, bool per_inline) {
+  if (!isScan) {
+    scan();
+  }
+  return read_as(dst, dtype, per_inline, 0, shape(0), 0, m_metaInfo.sizeY, 0,
+                 m_metaInfo.sizeZ);
+}
+
+} // namespace segy
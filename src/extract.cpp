@@ -0,0 +1,613 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: extract.cpp
+** @Time: 2026/10/20 01:47:15
+** @Version: 1.0
+** @Description : extraction of traces at arbitrary positions
+*********************************************************************/
+
+#include "extract.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <sys/mman.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "segy.h"
+
+namespace segy {
+
+// dst = the sum of the `nsrc` (up to 4) src weighted by w, n samples
+static void blend(float *dst, const float *const *src, const float *w,
+                  int nsrc, int n) {
+  int i = 0;
+#ifdef __SSE2__
+  for (; i + 4 <= n; i += 4) {
+    __m128 s = _mm_mul_ps(_mm_loadu_ps(src[0] + i), _mm_set1_ps(w[0]));
+    for (int c = 1; c < nsrc; c++) {
+      s = _mm_add_ps(
+          s, _mm_mul_ps(_mm_loadu_ps(src[c] + i), _mm_set1_ps(w[c])));
+    }
+    _mm_storeu_ps(dst + i, s);
+  }
+#endif
+  for (; i < n; i++) {
+    float s = src[0][i] * w[0];
+    for (int c = 1; c < nsrc; c++) {
+      s += src[c][i] * w[c];
+    }
+    dst[i] = s;
+  }
+}
+
+int64_t SegyIO::trace_at(int iZ, int iY) const {
+  if (iZ < 0 || iZ >= m_metaInfo.sizeZ || iY < 0 || iY >= m_metaInfo.sizeY) {
+    return -1;
+  }
+  if (m_metaInfo.isNormalSegy) {
+    return static_cast<int64_t>(iZ) * m_metaInfo.sizeY + iY;
+  }
+  if (m_lineInfo[iZ].count == m_metaInfo.sizeY) {
+    return m_lineInfo[iZ].trace_start + iY;
+  }
+  // the runs of the line are sorted by crossline
+  const CrosslineRun *first = m_xlineRuns.data() + m_runIndex[iZ];
+  const CrosslineRun *last = m_xlineRuns.data() + m_runIndex[iZ + 1];
+  const CrosslineRun *run = std::upper_bound(
+      first, last, iY,
+      [](int y, const CrosslineRun &r) { return y < r.crossline; });
+  if (run == first) {
+    return -1;
+  }
+  run--;
+  return iY < run->crossline + run->count ? run->trace + (iY - run->crossline)
+                                          : -1;
+}
+
+void SegyIO::read_trace_set(float *dst, const std::vector<int64_t> &traces,
+                            int startX, int sizeX) {
+  // The sorted traces are gathered into requests, the traces closer than
+  // kGatherGap share one. The mapped file is prefetched kPrefetchSize ahead
+  // of the decoding.
+  struct Request {
+    size_t first;
+    size_t last;
+    uint64_t begin;
+    uint64_t end;
+  };
+  std::vector<Request> requests;
+  for (size_t i = 0; i < traces.size();) {
+    uint64_t begin = trace_offset(traces[i]);
+    size_t j = i + 1;
+    while (j < traces.size() &&
+           trace_offset(traces[j]) <=
+               trace_offset(traces[j - 1] + 1) + kGatherGap &&
+           trace_offset(traces[j] + 1) - begin <= kGatherSize) {
+      j++;
+    }
+    requests.push_back({i, j, begin, trace_offset(traces[j - 1] + 1)});
+    i = j;
+  }
+
+  bool mapped = backend() == Backend::MMap;
+  size_t ahead = 0;
+  uint64_t prefetched = 0;
+  for (size_t r = 0; r < requests.size(); r++) {
+    const Request &req = requests[r];
+    const char *raw = m_source.data();
+    uint64_t base = 0;
+    if (mapped) {
+      prefetched -= std::min(prefetched, req.end - req.begin);
+      for (ahead = std::max(ahead, r);
+           ahead < requests.size() && prefetched < kPrefetchSize; ahead++) {
+        advise_range(requests[ahead].begin, requests[ahead].end,
+                     MADV_WILLNEED);
+        prefetched += requests[ahead].end - requests[ahead].begin;
+      }
+    } else {
+      raw = m_storage->fetch(req.begin, req.end - req.begin);
+      base = req.begin;
+    }
+    // the runs of consecutive traces in the request
+    for (size_t k = req.first; k < req.last;) {
+      size_t l = k + 1;
+      while (l < req.last && traces[l] == traces[l - 1] + 1) {
+        l++;
+      }
+      read_traces(dst + k * sizeX, traces[k], l - k, startX, sizeX, raw,
+                  base);
+      k = l;
+    }
+  }
+}
+
+std::vector<double> SegyIO::arbitrary_path(const double *points, int npoints,
+                                           bool world, double step) {
+  if (!isScan) {
+    scan();
+  }
+  if (npoints < 1) {
+    throw std::runtime_error("The polyline needs at least one point");
+  }
+  if (!(step > 0)) {
+    throw std::runtime_error("The step must be positive");
+  }
+  std::vector<double> lines(points, points + 2 * npoints);
+  if (world) {
+    for (int i = 0; i < npoints; i++) {
+      coord_to_line(points[2 * i], points[2 * i + 1], lines[2 * i],
+                    lines[2 * i + 1]);
+    }
+  }
+  // every segment is sampled from its first point, so all the points of
+  // the polyline (e.g., the wells) are traces of the line
+  std::vector<double> path;
+  for (int i = 0; i + 1 < npoints; i++) {
+    double z0 = lines[2 * i];
+    double y0 = lines[2 * i + 1];
+    double dz = lines[2 * i + 2] - z0;
+    double dy = lines[2 * i + 3] - y0;
+    double length = std::sqrt(dz * dz + dy * dy);
+    for (int k = 0; k * step < length; k++) {
+      double t = k * step / length;
+      path.push_back(z0 + t * dz);
+      path.push_back(y0 + t * dy);
+    }
+  }
+  path.push_back(lines[2 * npoints - 2]);
+  path.push_back(lines[2 * npoints - 1]);
+  return path;
+}
+
+void SegyIO::read_arbitrary_line(float *dst, const double *path,
+                                 int64_t npath, Interpolation interp,
+                                 int startX, int endX) {
+  if (!isReadSegy) {
+    throw std::runtime_error(
+        "'read_arbitrary_line()' function used only in reading segy mode");
+  }
+  if (!isScan) {
+    scan();
+  }
+  if (startX >= endX) {
+    throw std::runtime_error("Index 'end' must large than 'start'");
+  }
+  if (startX < 0 || endX > shape(0)) {
+    throw std::runtime_error("Index out of range");
+  }
+  if (m_metaInfo.data_format != 1 && m_metaInfo.data_format != 5) {
+    throw std::runtime_error("Unsuport sample format");
+  }
+  prepareTransform();
+  int sizeX = endX - startX;
+
+  // up to 4 traces and their weights for each position, -1 for the
+  // missing and dead traces
+  std::vector<int64_t> taps(npath * 4, -1);
+  std::vector<float> weights(npath * 4, 0);
+  auto tap = [&](int64_t k, int iZ, int iY, double w) {
+    int64_t itrace = w > 0 ? trace_at(iZ, iY) : -1;
+    if (itrace >= 0 && !is_dead(itrace)) {
+      taps[k] = itrace;
+      weights[k] = static_cast<float>(w);
+    }
+  };
+  for (int64_t p = 0; p < npath; p++) {
+    double z = path[2 * p] - m_metaInfo.min_inline;
+    double y = path[2 * p + 1] - m_metaInfo.min_crossline;
+    if (interp == Interpolation::Nearest) {
+      tap(4 * p, static_cast<int>(std::floor(z + 0.5)),
+          static_cast<int>(std::floor(y + 0.5)), 1);
+      continue;
+    }
+    int z0 = static_cast<int>(std::floor(z));
+    int y0 = static_cast<int>(std::floor(y));
+    double fz = z - z0;
+    double fy = y - y0;
+    tap(4 * p, z0, y0, (1 - fz) * (1 - fy));
+    tap(4 * p + 1, z0 + 1, y0, fz * (1 - fy));
+    tap(4 * p + 2, z0, y0 + 1, (1 - fz) * fy);
+    tap(4 * p + 3, z0 + 1, y0 + 1, fz * fy);
+  }
+
+  // each trace is decoded once, in the order of the file
+  std::vector<int64_t> traces;
+  for (int64_t t : taps) {
+    if (t >= 0) {
+      traces.push_back(t);
+    }
+  }
+  std::sort(traces.begin(), traces.end());
+  traces.erase(std::unique(traces.begin(), traces.end()), traces.end());
+  std::vector<float> buffer(traces.size() * sizeX);
+  read_trace_set(buffer.data(), traces, startX, sizeX);
+
+  for (int64_t p = 0; p < npath; p++) {
+    float *out = dst + p * sizeX;
+    float total = 0;
+    for (int k = 0; k < 4; k++) {
+      total += weights[4 * p + k];
+    }
+    if (total == 0) {
+      std::fill(out, out + sizeX, m_metaInfo.fillNoValue);
+      continue;
+    }
+    std::fill(out, out + sizeX, 0.0f);
+    for (int k = 0; k < 4; k++) {
+      int64_t itrace = taps[4 * p + k];
+      if (itrace < 0) {
+        continue;
+      }
+      size_t slot = std::lower_bound(traces.begin(), traces.end(), itrace) -
+                    traces.begin();
+      const float *src = buffer.data() + slot * sizeX;
+      float w = weights[4 * p + k] / total;
+      for (int iX = 0; iX < sizeX; iX++) {
+        out[iX] += w * src[iX];
+      }
+    }
+  }
+}
+
+void SegyIO::read_oblique(float *dst, const ObliqueGrid &grid) {
+  if (!isReadSegy) {
+    throw std::runtime_error(
+        "'read_oblique()' function used only in reading segy mode");
+  }
+  if (!isScan) {
+    scan();
+  }
+  if (grid.nu < 1 || grid.nv < 1 || grid.nw < 1) {
+    throw std::runtime_error("The grid must have at least one point");
+  }
+  if (m_metaInfo.data_format != 1 && m_metaInfo.data_format != 5) {
+    throw std::runtime_error("Unsuport sample format");
+  }
+  prepareTransform();
+  int64_t total = static_cast<int64_t>(grid.nu) * grid.nv * grid.nw;
+  std::fill(dst, dst + total, m_metaInfo.fillNoValue);
+  int nx = shape(0);
+
+  // (inline, crossline) as the indices of the lines
+  const double origin[3] = {grid.origin[0] - m_metaInfo.min_inline,
+                            grid.origin[1] - m_metaInfo.min_crossline,
+                            grid.origin[2]};
+  const double *axes[3] = {grid.u, grid.v, grid.w};
+  const int sizes[3] = {grid.nu, grid.nv, grid.nw};
+  auto point = [&](int i, int j, int k, int d) {
+    return origin[d] + i * axes[0][d] + j * axes[1][d] + k * axes[2][d];
+  };
+
+  // the bounding box of the grid, from its corners, clipped to the volume
+  double lo[3], hi[3];
+  for (int d = 0; d < 3; d++) {
+    lo[d] = hi[d] = origin[d];
+    for (int a = 0; a < 3; a++) {
+      double e = axes[a][d] * (sizes[a] - 1);
+      lo[d] += std::min(e, 0.0);
+      hi[d] += std::max(e, 0.0);
+    }
+  }
+  const int limits[3] = {m_metaInfo.sizeZ, m_metaInfo.sizeY, nx};
+  int first[3], last[3];
+  for (int d = 0; d < 3; d++) {
+    if (!(hi[d] >= 0 && lo[d] <= limits[d] - 1)) {
+      return;
+    }
+    first[d] = std::max(static_cast<int>(std::floor(lo[d])), 0);
+    last[d] = std::min(static_cast<int>(std::floor(hi[d])) + 2, limits[d]);
+  }
+  int boxZ = last[0] - first[0];
+  int boxY = last[1] - first[1];
+  int sizeX = last[2] - first[2];
+
+  // Plan: mark the bins around the points, then the traces of the marked
+  // bins are decoded once each, in the order of the file. With a vertical
+  // w only the columns are visited.
+  bool vertical = grid.w[0] == 0 && grid.w[1] == 0;
+  int nk = vertical ? 1 : grid.nw;
+  std::vector<int64_t> cells(static_cast<size_t>(boxZ) * boxY, -1);
+  auto cell = [&](int iZ, int iY) -> int64_t * {
+    iZ -= first[0];
+    iY -= first[1];
+    if (iZ < 0 || iZ >= boxZ || iY < 0 || iY >= boxY) {
+      return nullptr;
+    }
+    return &cells[static_cast<size_t>(iZ) * boxY + iY];
+  };
+  for (int i = 0; i < grid.nu; i++) {
+    for (int j = 0; j < grid.nv; j++) {
+      for (int k = 0; k < nk; k++) {
+        double z = point(i, j, k, 0);
+        double y = point(i, j, k, 1);
+        int z0 = static_cast<int>(std::floor(z));
+        int y0 = static_cast<int>(std::floor(y));
+        // the bins of zero weight are not needed
+        for (int c = 0; c < 4; c++) {
+          int64_t *p = cell(z0 + c / 2, y0 + c % 2);
+          if (p != nullptr && (c / 2 == 0 || z > z0) &&
+              (c % 2 == 0 || y > y0)) {
+            *p = 0;
+          }
+        }
+      }
+    }
+  }
+  std::vector<int64_t> traces;
+  for (int iZ = first[0]; iZ < last[0]; iZ++) {
+    for (int iY = first[1]; iY < last[1]; iY++) {
+      int64_t *p = cell(iZ, iY);
+      if (*p == 0) {
+        int64_t itrace = trace_at(iZ, iY);
+        *p = itrace >= 0 && !is_dead(itrace) ? itrace : -1;
+        if (*p >= 0) {
+          traces.push_back(itrace);
+        }
+      }
+    }
+  }
+  if (traces.empty()) {
+    return;
+  }
+  std::sort(traces.begin(), traces.end());
+  std::vector<float> buffer(traces.size() * sizeX);
+  read_trace_set(buffer.data(), traces, first[2], sizeX);
+  for (int64_t &p : cells) {
+    if (p >= 0) {
+      p = std::lower_bound(traces.begin(), traces.end(), p) - traces.begin();
+    }
+  }
+
+  // the decoded traces around (z, y) and their bilinear weights, the
+  // missing ones are left out and the others renormalized
+  auto corners = [&](double z, double y, const float **src, float *w) {
+    int z0 = static_cast<int>(std::floor(z));
+    int y0 = static_cast<int>(std::floor(y));
+    double fz = z - z0;
+    double fy = y - y0;
+    const double wc[4] = {(1 - fz) * (1 - fy), (1 - fz) * fy,
+                          fz * (1 - fy), fz * fy};
+    int n = 0;
+    float sum = 0;
+    for (int c = 0; c < 4; c++) {
+      const int64_t *p = cell(z0 + c / 2, y0 + c % 2);
+      if (wc[c] > 0 && p != nullptr && *p >= 0) {
+        src[n] = buffer.data() + *p * sizeX;
+        w[n] = static_cast<float>(wc[c]);
+        sum += w[n++];
+      }
+    }
+    for (int c = 0; c < n; c++) {
+      w[c] /= sum;
+    }
+    return n;
+  };
+  // linear interpolation at x of the samples [a, b) of the trace t, false
+  // if x is out of them
+  auto linear = [&](const float *t, int a, int b, double x, float &out) {
+    if (!(x >= 0 && x <= nx - 1)) {
+      return false;
+    }
+    int iX = static_cast<int>(std::floor(x));
+    if (iX < a || iX >= b) {
+      return false;
+    }
+    const float *p = t + (iX - first[2]);
+    float f = static_cast<float>(x - iX);
+    out = iX + 1 < b ? p[0] + f * (p[1] - p[0]) : p[0];
+    return true;
+  };
+
+  const float *src[4];
+  float w[4];
+  if (vertical) {
+    // the traces around each column are blended once, then interpolated
+    // along the time axis
+    std::vector<float> column(sizeX);
+    for (int i = 0; i < grid.nu; i++) {
+      for (int j = 0; j < grid.nv; j++) {
+        int n = corners(point(i, j, 0, 0), point(i, j, 0, 1), src, w);
+        if (n == 0) {
+          continue;
+        }
+        double x0 = point(i, j, 0, 2);
+        double x1 = point(i, j, grid.nw - 1, 2);
+        int a = static_cast<int>(std::floor(std::min(x0, x1)));
+        int b = static_cast<int>(std::floor(std::max(x0, x1))) + 2;
+        a = std::min(std::max(a, first[2]), last[2]);
+        b = std::min(std::max(b, a), last[2]);
+        for (int c = 0; c < n; c++) {
+          src[c] += a - first[2];
+        }
+        blend(column.data() + (a - first[2]), src, w, n, b - a);
+        float *out = dst + (static_cast<int64_t>(i) * grid.nv + j) * grid.nw;
+        for (int k = 0; k < grid.nw; k++) {
+          linear(column.data(), a, b, x0 + k * grid.w[2], out[k]);
+        }
+      }
+    }
+    return;
+  }
+  float *out = dst;
+  for (int i = 0; i < grid.nu; i++) {
+    for (int j = 0; j < grid.nv; j++) {
+      for (int k = 0; k < grid.nw; k++, out++) {
+        int n = corners(point(i, j, k, 0), point(i, j, k, 1), src, w);
+        if (n == 0) {
+          continue;
+        }
+        double x = point(i, j, k, 2);
+        float value = 0;
+        float v = 0;
+        int c = 0;
+        for (; c < n && linear(src[c], first[2], last[2], x, v); c++) {
+          value += w[c] * v;
+        }
+        if (c < n) {
+          continue;
+        }
+        *out = value;
+      }
+    }
+  }
+}
+
+void SegyIO::read_horizons(float *dst, const float *horizons, int nhorizon,
+                           HorizonAttr attr, int window) {
+  if (!isReadSegy) {
+    throw std::runtime_error(
+        "'read_horizons()' function used only in reading segy mode");
+  }
+  if (!isScan) {
+    scan();
+  }
+  if (nhorizon < 1) {
+    throw std::runtime_error("At least one horizon is needed");
+  }
+  if (window < 0) {
+    throw std::runtime_error("The window must be non-negative");
+  }
+  if (m_metaInfo.data_format != 1 && m_metaInfo.data_format != 5) {
+    throw std::runtime_error("Unsuport sample format");
+  }
+  int dt = sample_interval();
+  if (dt <= 0) {
+    throw std::runtime_error("The sample interval is unknown, "
+                             "use 'setSampleInterval(dt)' to set");
+  }
+  prepareTransform();
+  int64_t nbins = static_cast<int64_t>(m_metaInfo.sizeZ) * m_metaInfo.sizeY;
+  std::fill(dst, dst + nhorizon * nbins, m_metaInfo.fillNoValue);
+  int half = attr == HorizonAttr::Amplitude ? 0 : window;
+
+  // the times (ms, or the depth unit) to fractional sample indices of the
+  // traces as they are read, i.e., resampled if they are
+  std::vector<float> index(nhorizon * nbins);
+  double rate = 1000.0 / dt;
+  for (size_t i = 0; i < index.size(); i++) {
+    index[i] = static_cast<float>((horizons[i] - m_metaInfo.start_time) * rate);
+  }
+
+  // the samples [first, last) of the horizons at (iZ, iY), false if none
+  auto range = [&](int64_t bin, int n, int h, int &first, int &last) {
+    float t = index[h * nbins + bin];
+    if (!(t >= 0 && t <= n - 1)) {
+      return false;
+    }
+    if (attr == HorizonAttr::Amplitude) {
+      first = static_cast<int>(std::floor(t));
+      last = std::min(first + 2, n);
+    } else {
+      int center = static_cast<int>(std::lround(t));
+      first = std::max(center - half, 0);
+      last = std::min(center + half + 1, n);
+    }
+    return true;
+  };
+
+  // a window of each trace of the line, the union of the horizons
+  struct Window {
+    int64_t itrace;
+    int64_t bin;
+    int n;
+    int first;
+    int last;
+  };
+  std::vector<Window> windows;
+  std::vector<float> samples;
+  std::vector<uint64_t> offsets;
+  std::vector<uint64_t> sizes;
+  bool batched = backend() != Backend::MMap && m_resampler.empty();
+  for (int iZ = 0; iZ < m_metaInfo.sizeZ; iZ++) {
+    windows.clear();
+    int stride = 0;
+    for (int iY = 0; iY < m_metaInfo.sizeY; iY++) {
+      int64_t itrace = trace_at(iZ, iY);
+      if (itrace < 0 || is_dead(itrace)) {
+        continue;
+      }
+      int n = std::min(trace_samples(itrace), m_metaInfo.sizeX);
+      n = m_resampler.empty() ? n : m_resampler.out_size(n);
+      Window win = {itrace, static_cast<int64_t>(iZ) * m_metaInfo.sizeY + iY,
+                    n, n, 0};
+      for (int h = 0; h < nhorizon; h++) {
+        int first, last;
+        if (range(win.bin, n, h, first, last)) {
+          win.first = std::min(win.first, first);
+          win.last = std::max(win.last, last);
+        }
+      }
+      if (win.first < win.last) {
+        windows.push_back(win);
+        stride = std::max(stride, win.last - win.first);
+      }
+    }
+    if (windows.empty()) {
+      continue;
+    }
+
+    samples.resize(windows.size() * stride);
+    if (batched) {
+      // the windows of the line in one request, decoded in place
+      offsets.resize(windows.size());
+      sizes.resize(windows.size());
+      for (size_t k = 0; k < windows.size(); k++) {
+        offsets[k] = trace_offset(windows[k].itrace) + kTraceHeaderSize +
+                     windows[k].first * sizeof(float);
+        sizes[k] = (windows[k].last - windows[k].first) * sizeof(float);
+      }
+      char *raw = reinterpret_cast<char *>(samples.data());
+      m_storage->fetch_many(offsets.data(), sizes.data(), windows.size(), raw,
+                            stride * sizeof(float));
+    }
+    for (size_t k = 0; k < windows.size(); k++) {
+      const Window &win = windows[k];
+      float *trace = samples.data() + k * stride;
+      if (batched) {
+        read_one_trace(trace, reinterpret_cast<char *>(trace), win.itrace,
+                       win.first, win.last - win.first);
+      } else {
+        read_traces(trace, win.itrace, 1, win.first, win.last - win.first);
+      }
+    }
+
+    for (int h = 0; h < nhorizon; h++) {
+      for (size_t k = 0; k < windows.size(); k++) {
+        const Window &win = windows[k];
+        int first, last;
+        if (!range(win.bin, win.n, h, first, last)) {
+          continue;
+        }
+        // the samples [first, last) of the trace
+        const float *trace = samples.data() + k * stride + first - win.first;
+        int count = last - first;
+        float &out = dst[h * nbins + win.bin];
+        if (attr == HorizonAttr::Amplitude) {
+          float f = index[h * nbins + win.bin] - first;
+          out = count == 2 ? trace[0] + f * (trace[1] - trace[0]) : trace[0];
+          continue;
+        }
+        double sum = 0;
+        float peak = trace[0];
+        for (int iX = 0; iX < count; iX++) {
+          float v = trace[iX];
+          sum += attr == HorizonAttr::RMS ? static_cast<double>(v) * v : v;
+          peak = std::max(peak, v);
+        }
+        out = attr == HorizonAttr::Max
+                  ? peak
+                  : static_cast<float>(attr == HorizonAttr::RMS
+                                           ? std::sqrt(sum / count)
+                                           : sum / count);
+      }
+    }
+  }
+}
+
+} // namespace segy
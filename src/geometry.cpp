@@ -0,0 +1,306 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: geometry.cpp
+** @Time: 2026/10/19 10:12:05
+** @Version: 1.0
+** @Description : survey geometry, (X, Y) <-> (inline, crossline)
+*********************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "segy.h"
+
+namespace segy {
+
+const double kPi = 3.14159265358979323846;
+
+static inline double coord_scalar(int16_t scalar) {
+  if (scalar > 0) {
+    return scalar;
+  } else if (scalar < 0) {
+    return 1.0 / -scalar;
+  }
+  return 1.0;
+}
+
+// solve A x = b, A is 3 x 3, Gaussian elimination with partial pivoting
+static bool solve3(const double A[3][3], const double b[3], double x[3]) {
+  double m[3][4];
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      m[i][j] = A[i][j];
+    }
+    m[i][3] = b[i];
+  }
+  for (int col = 0; col < 3; col++) {
+    int pivot = col;
+    for (int i = col + 1; i < 3; i++) {
+      if (std::fabs(m[i][col]) > std::fabs(m[pivot][col])) {
+        pivot = i;
+      }
+    }
+    if (std::fabs(m[pivot][col]) < 1e-12) {
+      return false;
+    }
+    for (int j = 0; j < 4; j++) {
+      std::swap(m[col][j], m[pivot][j]);
+    }
+    for (int i = col + 1; i < 3; i++) {
+      double f = m[i][col] / m[col][col];
+      for (int j = col; j < 4; j++) {
+        m[i][j] -= f * m[col][j];
+      }
+    }
+  }
+  for (int i = 2; i >= 0; i--) {
+    double v = m[i][3];
+    for (int j = i + 1; j < 3; j++) {
+      v -= m[i][j] * x[j];
+    }
+    x[i] = v / m[i][i];
+  }
+  return true;
+}
+
+void SegyIO::fitGeometry() {
+  m_geometry = Geometry();
+  m_coordIndex = CoordIndex();
+  double factor = coord_scalar(m_metaInfo.scalar);
+  m_geometry.scalar = factor;
+
+  // The first, the middle and the last trace of each line (at most 4096
+  // lines) are enough to fit an affine transform, and the cost of the fit
+  // doesn't grow with the number of crosslines.
+  int stride = m_metaInfo.sizeZ > 4096 ? m_metaInfo.sizeZ / 4096 + 1 : 1;
+  std::vector<double> points; // iZ, iY, X, Y
+  for (int iZ = 0; iZ < m_metaInfo.sizeZ; iZ += stride) {
+    const LineInfo &line = m_lineInfo[iZ];
+    uint64_t traces[3] = {line.trace_start,
+                          (line.trace_start + line.trace_end) / 2,
+                          line.trace_end};
+    for (int k = 0; k < 3; k++) {
+      if (k > 0 && traces[k] == traces[k - 1]) {
+        continue;
+      }
+      TraceInfo info{};
+      get_TraceInfo(trace_ptr(traces[k]), info);
+      points.push_back(info.inline_num - m_metaInfo.min_inline);
+      points.push_back(info.crossline_num - m_metaInfo.min_crossline);
+      points.push_back(info.X * factor);
+      points.push_back(info.Y * factor);
+    }
+    if (iZ + stride >= m_metaInfo.sizeZ && iZ != m_metaInfo.sizeZ - 1) {
+      iZ = m_metaInfo.sizeZ - 1 - stride; // always include the last line
+    }
+  }
+
+  // least squares, the normal equations of (1, iZ, iY)
+  double AtA[3][3] = {{0}};
+  double AtX[3] = {0};
+  double AtY[3] = {0};
+  size_t npoints = points.size() / 4;
+  for (size_t i = 0; i < npoints; i++) {
+    const double *p = &points[i * 4];
+    double row[3] = {1, p[0], p[1]};
+    for (int r = 0; r < 3; r++) {
+      for (int c = 0; c < 3; c++) {
+        AtA[r][c] += row[r] * row[c];
+      }
+      AtX[r] += row[r] * p[2];
+      AtY[r] += row[r] * p[3];
+    }
+  }
+
+  double *coef = m_geometry.coef;
+  if (!solve3(AtA, AtX, coef) || !solve3(AtA, AtY, coef + 3)) {
+    // all sampled traces are on a line, e.g., each line has only one trace
+    m_metaInfo.Y_interval = 0;
+    m_metaInfo.Z_interval = 0;
+    return;
+  }
+
+  double err = 0;
+  for (size_t i = 0; i < npoints; i++) {
+    const double *p = &points[i * 4];
+    double dx = coef[0] + coef[1] * p[0] + coef[2] * p[1] - p[2];
+    double dy = coef[3] + coef[4] * p[0] + coef[5] * p[1] - p[3];
+    err += dx * dx + dy * dy;
+  }
+
+  m_geometry.valid = true;
+  m_geometry.origin_X = coef[0];
+  m_geometry.origin_Y = coef[3];
+  m_geometry.inline_bin = std::sqrt(coef[1] * coef[1] + coef[4] * coef[4]);
+  m_geometry.crossline_bin = std::sqrt(coef[2] * coef[2] + coef[5] * coef[5]);
+  double azimuth = std::atan2(coef[2], coef[5]) * 180.0 / kPi;
+  m_geometry.azimuth = azimuth < 0 ? azimuth + 360.0 : azimuth;
+  m_geometry.rms_error = std::sqrt(err / npoints);
+
+  // the intervals are kept in the units of the header coordinates
+  m_metaInfo.Y_interval = m_geometry.crossline_bin / factor;
+  m_metaInfo.Z_interval = m_geometry.inline_bin / factor;
+}
+
+Geometry SegyIO::geometry() {
+  if (!isScan) {
+    scan();
+  }
+  return m_geometry;
+}
+
+void SegyIO::coord_to_line(double x, double y, double &iline, double &xline) {
+  if (!isScan) {
+    scan();
+  }
+  const double *c = m_geometry.coef;
+  double det = c[1] * c[5] - c[2] * c[4];
+  if (!m_geometry.valid || det == 0) {
+    throw std::runtime_error("The survey geometry is unavailable, the "
+                             "coordinates of the traces are degenerate");
+  }
+  double dx = x - c[0];
+  double dy = y - c[3];
+  iline = m_metaInfo.min_inline + (dx * c[5] - c[2] * dy) / det;
+  xline = m_metaInfo.min_crossline + (c[1] * dy - c[4] * dx) / det;
+}
+
+void SegyIO::line_to_coord(double iline, double xline, double &x, double &y) {
+  if (!isScan) {
+    scan();
+  }
+  if (!m_geometry.valid) {
+    throw std::runtime_error("The survey geometry is unavailable, the "
+                             "coordinates of the traces are degenerate");
+  }
+  const double *c = m_geometry.coef;
+  double iZ = iline - m_metaInfo.min_inline;
+  double iY = xline - m_metaInfo.min_crossline;
+  x = c[0] + c[1] * iZ + c[2] * iY;
+  y = c[3] + c[4] * iZ + c[5] * iY;
+}
+
+void SegyIO::buildCoordIndex() {
+  if (!isScan) {
+    scan();
+  }
+
+  // one pass over all trace headers
+  int64_t ntrace = m_metaInfo.trace_count;
+  double factor = coord_scalar(m_metaInfo.scalar);
+  std::vector<double> X(ntrace), Y(ntrace);
+  double minX = std::numeric_limits<double>::max();
+  double minY = minX;
+  double maxX = std::numeric_limits<double>::lowest();
+  double maxY = maxX;
+  for (int64_t i = 0; i < ntrace; i++) {
+    TraceInfo info{};
+    get_TraceInfo(trace_ptr(i), info);
+    X[i] = info.X * factor;
+    Y[i] = info.Y * factor;
+    minX = std::min(minX, X[i]);
+    maxX = std::max(maxX, X[i]);
+    minY = std::min(minY, Y[i]);
+    maxY = std::max(maxY, Y[i]);
+  }
+
+  // about 4 traces per bucket, or 2 traces per bucket for a straight 2D line
+  CoordIndex &ci = m_coordIndex;
+  double width = std::max(maxX - minX, 1e-6);
+  double height = std::max(maxY - minY, 1e-6);
+  ci.minX = minX;
+  ci.minY = minY;
+  ci.cell = std::max(std::sqrt(width * height / ntrace),
+                     std::max(width, height) / ntrace) *
+            2;
+  ci.nX = static_cast<int64_t>(width / ci.cell) + 1;
+  ci.nY = static_cast<int64_t>(height / ci.cell) + 1;
+
+  // counting sort of the traces into the buckets
+  std::vector<uint64_t> bucket(ntrace);
+  ci.start.assign(ci.nX * ci.nY + 1, 0);
+  for (int64_t i = 0; i < ntrace; i++) {
+    int64_t bx = static_cast<int64_t>((X[i] - minX) / ci.cell);
+    int64_t by = static_cast<int64_t>((Y[i] - minY) / ci.cell);
+    bucket[i] = std::min(by, ci.nY - 1) * ci.nX + std::min(bx, ci.nX - 1);
+    ci.start[bucket[i] + 1]++;
+  }
+  for (size_t i = 1; i < ci.start.size(); i++) {
+    ci.start[i] += ci.start[i - 1];
+  }
+  std::vector<uint64_t> fill(ci.start.begin(), ci.start.end() - 1);
+  ci.traces.resize(ntrace);
+  ci.X.resize(ntrace);
+  ci.Y.resize(ntrace);
+  for (int64_t i = 0; i < ntrace; i++) {
+    uint64_t k = fill[bucket[i]]++;
+    ci.traces[k] = i;
+    ci.X[k] = static_cast<float>(X[i] - minX);
+    ci.Y[k] = static_cast<float>(Y[i] - minY);
+  }
+}
+
+int64_t SegyIO::nearest_trace(double x, double y) {
+  if (m_coordIndex.traces.empty()) {
+    buildCoordIndex();
+  }
+  const CoordIndex &ci = m_coordIndex;
+  double rx = x - ci.minX;
+  double ry = y - ci.minY;
+  double fx = rx / ci.cell;
+  double fy = ry / ci.cell;
+  int64_t cx = std::min(std::max(static_cast<int64_t>(std::floor(fx)),
+                                 static_cast<int64_t>(0)),
+                        ci.nX - 1);
+  int64_t cy = std::min(std::max(static_cast<int64_t>(std::floor(fy)),
+                                 static_cast<int64_t>(0)),
+                        ci.nY - 1);
+
+  double best = std::numeric_limits<double>::max();
+  int64_t best_trace = -1;
+  auto visit = [&](int64_t bx, int64_t by) {
+    if (bx < 0 || by < 0 || bx >= ci.nX || by >= ci.nY) {
+      return;
+    }
+    uint64_t b = by * ci.nX + bx;
+    for (uint64_t k = ci.start[b]; k < ci.start[b + 1]; k++) {
+      double dx = ci.X[k] - rx;
+      double dy = ci.Y[k] - ry;
+      double d = dx * dx + dy * dy;
+      if (d < best) {
+        best = d;
+        best_trace = ci.traces[k];
+      }
+    }
+  };
+
+  // search the rings of buckets around (cx, cy) until no closer trace
+  // can exist outside the visited square
+  int64_t max_ring = std::max(ci.nX, ci.nY) + 1;
+  for (int64_t r = 0; r <= max_ring; r++) {
+    for (int64_t bx = cx - r; bx <= cx + r; bx++) {
+      visit(bx, cy - r);
+      if (r > 0) {
+        visit(bx, cy + r);
+      }
+    }
+    for (int64_t by = cy - r + 1; by <= cy + r - 1; by++) {
+      visit(cx - r, by);
+      visit(cx + r, by);
+    }
+    double bound = std::min(std::min(fx - (cx - r), (cx + r + 1) - fx),
+                            std::min(fy - (cy - r), (cy + r + 1) - fy)) *
+                   ci.cell;
+    if (best_trace >= 0 && bound > 0 && best <= bound * bound) {
+      break;
+    }
+  }
+  return best_trace;
+}
+
+} // namespace segy
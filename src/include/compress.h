@@ -0,0 +1,49 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: compress.h
+** @Time: 2026/10/19 20:12:36
+** @Version: 1.0
+** @Description : read gzip and zstd compressed segy files
+*********************************************************************/
+
+#ifndef CIG_COMPRESS_H
+#define CIG_COMPRESS_H
+
+#include <memory>
+#include <string>
+
+#include "storage.h"
+#include "stream.h"
+
+namespace segy {
+
+// a zstd frame larger than this is not decompressed as a whole for random
+// access, such files can only be read sequentially
+const uint64_t kZstdMaxFrameSize = 256 * 1024 * 1024;
+// number of decompressed frames kept by the random access reader
+const int kZstdCacheFrames = 4;
+
+enum class Compression { None, Gzip, Zstd };
+
+// detect the compression by the magic number at the beginning of the file
+Compression detect_compression(const char *data, size_t size);
+Compression file_compression(const std::string &name);
+
+// Returns a source that decompresses `source` on the fly when it starts with
+// a gzip or zstd magic number, otherwise the bytes are passed through.
+std::unique_ptr<ByteSource>
+open_decompressed(std::unique_ptr<ByteSource> source);
+
+// Random access to a zstd file made of many independent frames (e.g., the
+// zstd seekable format, or the frames of `split | zstd` concatenated). The
+// frame index is taken from the seek table when there is one, otherwise from
+// the frame headers. Only the frames overlapping a request are decompressed.
+// `size` is set to the decompressed size of the file.
+std::unique_ptr<Storage> open_zstd(const std::string &name, uint64_t &size);
+
+} // namespace segy
+
+#endif
@@ -0,0 +1,43 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: convert.h
+** @Time: 2026/10/20 00:18:52
+** @Version: 1.0
+** @Description : reduced precision output of the reads
+*********************************************************************/
+
+#ifndef CIG_CONVERT_H
+#define CIG_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace segy {
+
+// the sample type of SegyIO::read_as()
+enum class DType {
+  Float32,
+  Float16,  // IEEE half precision
+  BFloat16, // the upper 16 bits of a float32, rounded to nearest even
+  Int16,    // quantized, value = sample * scale
+  Int8
+};
+
+size_t dtype_size(DType dtype);
+inline bool dtype_quantized(DType dtype) {
+  return dtype == DType::Int16 || dtype == DType::Int8;
+}
+// the largest magnitude of a quantized sample
+float dtype_max(DType dtype);
+
+// Convert n samples of src to `dtype` at dst. The quantized types store
+// round(src / scale) saturated to +/- dtype_max(), NaN is stored as 0.
+void convert_samples(const float *src, void *dst, size_t n, DType dtype,
+                     float scale = 1);
+
+} // namespace segy
+
+#endif
@@ -0,0 +1,54 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: extract.h
+** @Time: 2026/10/20 01:47:15
+** @Version: 1.0
+** @Description : extraction of traces at arbitrary positions
+*********************************************************************/
+
+#ifndef CIG_EXTRACT_H
+#define CIG_EXTRACT_H
+
+#include <cstdint>
+
+namespace segy {
+
+// the traces closer than this (bytes) are fetched by one request
+const uint64_t kGatherGap = 256 * 1024;
+// the largest request of the gathered traces
+const uint64_t kGatherSize = 16 * 1024 * 1024;
+
+// how a trace between the bins is made from its neighbours
+enum class Interpolation {
+  Nearest,
+  Bilinear // of the 4 traces around it, the missing ones are left out
+};
+
+// how the samples around a horizon are reduced to one value
+enum class HorizonAttr {
+  Amplitude, // linear interpolation at the horizon, no window
+  Mean,
+  RMS,
+  Max // the largest sample
+};
+
+// A grid at any orientation in the volume, its point (i, j, k) is at
+// origin + i * u + j * v + k * w, in (inline, crossline, sample index).
+// E.g., a slice along a fault strike has nu = 1, v along the strike and w
+// the time axis (0, 0, 1).
+struct ObliqueGrid {
+  double origin[3];
+  double u[3];
+  double v[3];
+  double w[3];
+  int nu;
+  int nv;
+  int nw;
+};
+
+} // namespace segy
+
+#endif
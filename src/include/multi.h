@@ -0,0 +1,67 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: multi.h
+** @Time: 2026/10/20 03:12:40
+** @Version: 1.0
+** @Description : read several segy files of the same geometry together
+*********************************************************************/
+
+#ifndef CIG_MULTI_H
+#define CIG_MULTI_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "segy.h"
+
+namespace segy {
+
+// Several segy files of the same geometry, e.g., the attributes of one
+// survey, read as the channels of one array. Only the first file is
+// scanned, the others take its index (SegyIO::share_scan()). The files are
+// read in parallel, one thread for each, so their progress bars are off.
+class MultiSegy {
+public:
+  explicit MultiSegy(const std::vector<std::string> &names,
+                     Backend backend = Backend::MMap);
+
+  void setInlineLocation(int loc);
+  void setCrosslineLocation(int loc);
+  void setFillNoValue(float noValue);
+  void setResample(int interval);
+  // the number of files read at the same time (0: one per core)
+  inline void setThreads(int threads) { m_threads = threads; }
+
+  void scan();
+  inline int count() const { return static_cast<int>(m_volumes.size()); }
+  // the file `i`, e.g., for its own transform
+  inline SegyIO &volume(int i) { return *m_volumes.at(i); }
+  int shape(int dimension);
+
+  // dst is (N, endZ - startZ, endY - startY, endX - startX), or
+  // (endZ - startZ, endY - startY, endX - startX, N) if `channels_last`
+  void read(float *dst, int startX, int endX, int startY, int endY,
+            int startZ, int endZ, bool channels_last = false);
+  void read(float *dst, bool channels_last = false);
+  // `npatch` patches of sizeZ x sizeY x sizeX, `starts` holds (iZ, iY, iX)
+  // of each. dst is (npatch, N, sizeZ, sizeY, sizeX), or (npatch, sizeZ,
+  // sizeY, sizeX, N) if `channels_last`.
+  void read_patches(float *dst, const int *starts, int npatch, int sizeX,
+                    int sizeY, int sizeZ, bool channels_last = false);
+
+private:
+  std::vector<std::unique_ptr<SegyIO>> m_volumes;
+  int m_threads = 0;
+  bool isScan = false;
+
+  // run task(i) for each file, in parallel
+  template <typename Task> void for_each_volume(Task task);
+};
+
+} // namespace segy
+
+#endif
@@ -0,0 +1,124 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: output.h
+** @Time: 2026/10/19 14:02:31
+** @Version: 1.0
+** @Description : output files, preallocation and streaming writer
+*********************************************************************/
+
+#ifndef CIG_OUTPUT_H
+#define CIG_OUTPUT_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace segy {
+
+// size of each of the two buffers of StreamWriter
+const size_t kStreamBufferSize = 32 * 1024 * 1024;
+const size_t kStreamBufferAlign = 4096;
+// the zero pages of this size (aligned in the file) are holes of a sparse
+// output file, a multiple of the block size of common file systems
+const uint64_t kSparsePageSize = 4096;
+
+// the traces create_by_sharing_header() copies from the header segy by one
+// memcpy before encoding their samples over it
+const uint64_t kShareChunk = 256 * 1024;
+
+// how tofile() and create() write the output file
+enum class WriteMode {
+  MMap,    // write through a shared memory map of the output
+  Stream,  // pwrite from two aligned buffers on a background thread
+  Pipeline // tofile() only: read, decode (on many threads) and write stages
+           // overlap, create() writes as Stream
+};
+
+// Create (or truncate) `name` with `size` bytes and return its file
+// descriptor. The blocks are allocated up front when the file system
+// supports it, otherwise the file is only extended. A sparse file is only
+// extended, the blocks that are never written stay holes.
+int create_file(const std::string &name, uint64_t size, bool sparse = false);
+
+// encode n samples as the big endian `format` (1: IBM, 5: IEEE) of segy
+void encode_samples(char *dst, const float *src, int64_t n, int format);
+
+// pread/pwrite all `size` bytes, throw on errors
+void pread_full(int fd, char *dst, uint64_t size, uint64_t offset);
+void pwrite_full(int fd, const char *src, uint64_t size, uint64_t offset);
+
+// As pwrite_full(), but the pages of zeros are not written, they stay holes
+// of a sparse file created by create_file(). Returns the bytes skipped.
+uint64_t pwrite_sparse(int fd, const char *src, uint64_t size,
+                       uint64_t offset);
+// As pread_full(), but the holes (SEEK_HOLE) are zero-filled without
+// reading them. Returns the bytes in holes.
+uint64_t pread_sparse(int fd, char *dst, uint64_t size, uint64_t offset);
+
+// Write a file sequentially from `offset` with double buffering, the
+// caller fills one buffer while the other one is written by pwrite on a
+// background thread. The buffers are page aligned.
+class StreamWriter {
+public:
+  StreamWriter(int fd, uint64_t offset = 0,
+               size_t buffer_size = kStreamBufferSize);
+  ~StreamWriter();
+
+  StreamWriter(const StreamWriter &) = delete;
+  StreamWriter &operator=(const StreamWriter &) = delete;
+
+  inline size_t capacity() const { return m_size; }
+
+  // Write with O_DIRECT, bypassing the page cache. The last unaligned
+  // block is written without it. Returns false when the file system
+  // doesn't support it. Call it before writing.
+  bool setDirect(bool direct);
+  // skip the zero pages, see pwrite_sparse()
+  inline void setSparse(bool sparse) { m_sparse = sparse; }
+  // bytes skipped by the sparse writes, final after close()
+  inline uint64_t skipped() const { return m_skipped; }
+
+  // a pointer to `n` free bytes of the current buffer, fill them and
+  // then call commit(n)
+  char *reserve(size_t n);
+  void commit(size_t n);
+  void write(const char *src, size_t n);
+
+  // write the rest of the data and stop the background thread
+  void close();
+
+private:
+  int m_fd;
+  uint64_t m_offset; // file offset of the current buffer
+  size_t m_size;
+  size_t m_used;
+  char *m_buffers[2];
+  int m_current;
+  bool m_closed;
+  bool m_direct;
+  bool m_sparse = false;
+  uint64_t m_skipped = 0;
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_pending;
+  bool m_stop;
+  const char *m_job;
+  size_t m_jobSize;
+  uint64_t m_jobOffset;
+  bool m_jobLast; // submitted by close()
+  std::string m_error;
+  std::thread m_thread;
+
+  void submit();
+  void run();
+};
+
+} // namespace segy
+
+#endif
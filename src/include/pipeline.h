@@ -0,0 +1,80 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: pipeline.h
+** @Time: 2026/10/19 21:03:17
+** @Version: 1.0
+** @Description : bounded queues between the stages of a pipeline
+*********************************************************************/
+
+#ifndef CIG_PIPELINE_H
+#define CIG_PIPELINE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace segy {
+
+// memory of the blocks in flight of the pipelined tofile()
+const uint64_t kPipelineMemory = 512 * 1024 * 1024;
+// the largest block of inlines, smaller blocks start overlapping sooner
+const uint64_t kPipelineBlockSize = 32 * 1024 * 1024;
+
+// A queue of at most `capacity` items. push() waits while it is full and
+// pop() waits while it is empty. After close(), push() fails and pop()
+// returns the remaining items, then fails.
+template <typename T> class BoundedQueue {
+public:
+  explicit BoundedQueue(size_t capacity) : m_capacity(capacity) {}
+
+  bool push(const T &item) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notFull.wait(lock,
+                   [this] { return m_closed || m_items.size() < m_capacity; });
+    if (m_closed) {
+      return false;
+    }
+    m_items.push_back(item);
+    lock.unlock();
+    m_notEmpty.notify_one();
+    return true;
+  }
+
+  bool pop(T &item) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+    if (m_items.empty()) {
+      return false;
+    }
+    item = m_items.front();
+    m_items.pop_front();
+    lock.unlock();
+    m_notFull.notify_one();
+    return true;
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_closed = true;
+    }
+    m_notFull.notify_all();
+    m_notEmpty.notify_all();
+  }
+
+private:
+  size_t m_capacity;
+  bool m_closed = false;
+  std::deque<T> m_items;
+  std::mutex m_mutex;
+  std::condition_variable m_notFull;
+  std::condition_variable m_notEmpty;
+};
+
+} // namespace segy
+
+#endif
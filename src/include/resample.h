@@ -0,0 +1,66 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: resample.h
+** @Time: 2026/10/20 01:02:37
+** @Version: 1.0
+** @Description : polyphase resampling of the time axis
+*********************************************************************/
+
+#ifndef CIG_RESAMPLE_H
+#define CIG_RESAMPLE_H
+
+#include <cstdint>
+#include <vector>
+
+namespace segy {
+
+// zero crossings of the windowed sinc on each side
+const int kResampleZeros = 8;
+// cutoff of the anti-alias filter when downsampling, as a fraction of the
+// output Nyquist frequency
+const double kResampleCutoff = 0.9;
+
+// Resampling by the rational factor up / down = interval_in / interval_out
+// with a polyphase windowed sinc (Blackman) filter. The output sample j is
+// at the input position j * down / up, so both start at the same time. The
+// ends of the trace are extended by mirroring.
+class Resampler {
+public:
+  Resampler() = default;
+  Resampler(int interval_in, int interval_out);
+
+  inline bool empty() const { return m_up == 0; }
+  inline int up() const { return m_up; }
+  inline int down() const { return m_down; }
+  // output samples of a trace of n input samples
+  inline int out_size(int n) const {
+    if (n <= 0) {
+      return 0;
+    }
+    return static_cast<int>(static_cast<int64_t>(n - 1) * m_up / m_down) + 1;
+  }
+  // the input samples [first, last) that the output samples
+  // [start, start + count) use, not clipped to the trace
+  void input_range(int start, int count, int &first, int &last) const;
+  // Resample the output samples [start, start + count) of a trace of n
+  // input samples to dst. `in` holds the input samples [lo, hi), which
+  // cover input_range() clipped to [0, n) and extended by half the filter
+  // on both sides, for the mirrored ends.
+  void apply(const float *in, int lo, int hi, int n, int start, int count,
+             float *dst) const;
+  inline int half() const { return m_half; }
+
+private:
+  int m_up = 0;
+  int m_down = 0;
+  int m_half = 0; // the filter of each phase spans (-m_half, m_half]
+  int m_taps = 0; // 2 * m_half, rounded up to the SIMD width
+  std::vector<float> m_coefs; // m_up phases of m_taps
+};
+
+} // namespace segy
+
+#endif
@@ -16,8 +16,17 @@
 #include <vector>
 // #include <omp.h>
 
+#include "convert.h"
+#include "extract.h"
 #include "mio.hpp"
+#include "output.h"
+#include "pipeline.h"
+#include "resample.h"
+#include "stats.h"
+#include "storage.h"
+#include "transform.h"
 #include "utils.h"
+#include "zonemap.h"
 
 namespace segy {
 
@@ -28,24 +37,35 @@ const int kTraceHeaderSize = 240;
 const int kTextualColumns = 80;
 const int kTextualRows = 40;
 
-const int kMaxSizeOneDimemsion = 10000;
-
 // const binary header field
 const int kBSampleIntervalField = 17;
 const int kBSampleCountField = 21;
 const int kBSampleFormatField = 25;
+const int kBRevisionField = 301;
+const int kBFixedLengthField = 303;
 
 // const trace header field
 const int kTStartTimeField = 111; // TODO(Jintao): check
 const int kTScalarField = 71;
 const int kTSampleCountField = 115;
 const int kTSampleIntervalField = 117;
+const int kTTraceIDField = 29; // 2 marks a dead trace
 
 const int kDefaultInlineField = 189;
 const int kDefaultCrosslineField = 193;
+const int kDefaultCDPField = 21;
 const int kDefaultXField = 73;
 const int kDefaultYField = 77;
 
+// access hints of the mapped file
+const uint64_t kPrefetchSize = 64 * 1024 * 1024;     // WILLNEED ahead
+const uint64_t kRandomSpanSize = 1024 * 1024;        // smaller spans are random
+const uint64_t kDropBehindSize = 1024 * 1024 * 1024; // larger reads stream
+
+// a single line whose keys span more than this times its traces has a
+// corrupt key, its traces are indexed by their order in the file
+const int64_t kMaxKeysPerTrace = 4;
+
 // const int kMaxTempSize = 512 * 512 * 512 * 4;
 
 // const int kMaxThreadsNum = 8;
@@ -205,6 +225,8 @@ struct MetaInfo {
   int max_crossline;
 
   bool isNormalSegy;
+  bool isVariableLength; // traces have different sample counts (rev 2)
+  bool is2D;             // 2D line, traces are indexed by crossline_field
 
   float fillNoValue;
 
@@ -219,7 +241,58 @@ struct LineInfo {
   int line_num;
   uint64_t trace_start;
   uint64_t trace_end;
-  int count;
+  int64_t count;
+};
+
+// Affine survey geometry fitted from the trace headers. iZ and iY are the
+// inline and crossline indices, i.e., inline - min_inline and
+// crossline - min_crossline. The coordinates have been multiplied by the
+// coordinate scalar (bytes 71-72).
+//   X = coef[0] + coef[1] * iZ + coef[2] * iY
+//   Y = coef[3] + coef[4] * iZ + coef[5] * iY
+struct Geometry {
+  bool valid;
+  double origin_X; // coordinates of (min_inline, min_crossline)
+  double origin_Y;
+  double inline_bin;    // distance between two adjacent inlines
+  double crossline_bin; // distance between two adjacent crosslines
+  double azimuth;       // azimuth (degrees, clockwise from +Y) of the
+                        // increasing crossline direction
+  double scalar;        // multiplier applied to the header coordinates
+  double rms_error;     // root mean square misfit of the fitted traces
+  double coef[6];
+};
+
+// Uniform buckets over the trace coordinates, for the nearest trace query
+// of irregular surveys. The coordinates are stored relative to
+// (minX, minY) and in bucket order.
+struct CoordIndex {
+  double minX;
+  double minY;
+  double cell;
+  int64_t nX;
+  int64_t nY;
+  std::vector<uint64_t> start; // nX * nY + 1 elements
+  std::vector<int64_t> traces;
+  std::vector<float> X;
+  std::vector<float> Y;
+};
+
+// a run of traces with consecutive crossline numbers in a line
+struct CrosslineRun {
+  int32_t crossline; // index of the first crossline (from min_crossline)
+  int32_t count;     // number of traces in this run
+  int64_t trace;     // index of the first trace
+};
+
+// how the mapped segy file will be accessed, given to the kernel by madvise
+enum class AccessHint {
+  Auto,       // chosen by each read call
+  Normal,     // default readahead of the kernel
+  Sequential, // sequential readahead, and prefetch of the next lines
+  Stream,     // as Sequential, and drop the lines already read from the
+              // page cache
+  Random      // no readahead, e.g., time slices and small patches
 };
 
 struct TraceInfo {
@@ -231,8 +304,9 @@ struct TraceInfo {
 
 class SegyIO {
 public:
-  // read segy mode
-  explicit SegyIO(const std::string &segyname);
+  // read segy mode, the trace data is read by `backend`
+  explicit SegyIO(const std::string &segyname,
+                  Backend backend = Backend::MMap);
   // create segy from memory
   SegyIO(int sizeX, int sizeY, int sizeZ);
   // create segy file from binary file
@@ -240,9 +314,11 @@ public:
 
   ~SegyIO();
 
+  // the time axis is the one of the reads, see setResample()
   inline int shape(int dimension) {
     if (dimension == 0) {
-      return m_metaInfo.sizeX;
+      return m_resampler.empty() ? m_metaInfo.sizeX
+                                 : m_resampler.out_size(m_metaInfo.sizeX);
     } else if (dimension == 1) {
       return m_metaInfo.sizeY;
     } else if (dimension == 2) {
@@ -260,14 +336,22 @@ public:
     m_metaInfo.sizeZ = z;
     if (isReadSegy) {
       m_metaInfo.isNormalSegy = true;
+      m_metaInfo.isVariableLength = false;
+      m_traceOffsets.clear();
+      m_deadTraces.clear();
+      m_deadCount = 0;
+      m_transformReady = false;
       isScan = true;
       int64_t trace_count =
-          (m_source.size() - kTextualHeaderSize - kBinaryHeaderSize) /
+          (m_fileSize - kTextualHeaderSize - kBinaryHeaderSize) /
           (kTraceHeaderSize + x * sizeof(float));
-      if (y * z != (trace_count)) {
+      if (static_cast<int64_t>(y) * z != trace_count) {
         throw std::runtime_error("invalid shape. inline * crossline != "
                                  "total_trace_count");
       }
+      m_metaInfo.trace_count = trace_count;
+      // no scan() follows, so the dead traces are found here
+      scanDeadTraces();
     }
   }
 
@@ -277,16 +361,89 @@ public:
   std::string metaInfo();
   std::string binary_header_string();
   inline std::vector<LineInfo> line_info() { return m_lineInfo; }
-  inline MetaInfo get_metaInfo() { return m_metaInfo; }
+  // the mapped bytes of the file (read mode), nullptr if it is compressed
+  inline const char *file_data() const {
+    return m_compressed ? nullptr : m_source.data();
+  }
+  // sizeX and sample_interval are the ones of the reads
+  MetaInfo get_metaInfo();
 
   void setInlineLocation(int loc);
   void setCrosslineLocation(int loc);
   void setXLocation(int loc);
   void setYLocation(int loc);
+  void setLine2D(int keyloc = kDefaultCDPField);
+
+  // survey geometry (need scan)
+  Geometry geometry();
+  void coord_to_line(double x, double y, double &iline, double &xline);
+  void line_to_coord(double iline, double xline, double &x, double &y);
+  int64_t nearest_trace(double x, double y);
+  void buildCoordIndex();
+  inline TraceInfo trace_info(int64_t itrace) {
+    if (itrace < 0 || itrace >= m_metaInfo.trace_count) {
+      throw std::runtime_error("Trace index out of range");
+    }
+    TraceInfo info{};
+    get_TraceInfo(trace_ptr(itrace), info);
+    return info;
+  }
 
   // read segy
   void setFillNoValue(float noValue);
+  void setVariableLength(bool variable);
+  inline void setWriteMode(WriteMode mode) { m_writeMode = mode; }
+  // WriteMode::Pipeline: the number of decode threads (0: one per core),
+  // the memory of the blocks in flight, and O_DIRECT output
+  inline void setThreads(int threads) { m_threads = threads; }
+  inline void setMemoryBudget(uint64_t bytes) { m_memoryBudget = bytes; }
+  inline void setDirectIO(bool direct) { m_directIO = direct; }
+  // tofile() leaves the pages of the fill value 0 as holes of a sparse
+  // file, read it by read_binary() to skip the holes
+  inline void setSparse(bool sparse) { m_sparse = sparse; }
+  // bytes left as holes by the last tofile()
+  inline uint64_t sparse_bytes() const { return m_skipped; }
+  inline void setAccessHint(AccessHint hint) { m_accessHint = hint; }
+  inline void setVerbose(bool verbose) { m_verbose = verbose; }
+  // scan() also finds the dead traces, i.e., marked as dead by the trace
+  // identification code (bytes 29-30) or with all samples zero. Reads emit
+  // fillNoValue for them without decoding. It costs a pass over all samples.
+  inline void setDetectDead(bool detect) {
+    if (detect != m_detectDead) {
+      m_detectDead = detect;
+      isScan = false;
+    }
+  }
+  // (need scan with setDetectDead(true))
+  inline int64_t dead_count() const { return m_deadCount; }
+  inline bool is_dead(int64_t itrace) const {
+    return !m_deadTraces.empty() &&
+           ((m_deadTraces[itrace >> 6] >> (itrace & 63)) & 1);
+  }
+  // the state of each (inline, crossline) as (n-inline, n-crossline):
+  // 0 live trace, 1 dead trace, 2 missing trace
+  void dead_mask(uint8_t *mask);
+
+  // Min, max and RMS of each window of `window` samples of each trace (0:
+  // one window per trace). It's loaded from `<segy>.zmap` when that file
+  // matches, otherwise built in one parallel pass and saved there.
+  void buildZoneMap(int window = 0);
+  inline const ZoneMap &zone_map() const { return m_zoneMap; }
+  // the traces whose max abs amplitude exceeds `threshold` in the windows
+  // overlapping samples [startX, endX)
+  std::vector<int64_t> traces_exceeding(float threshold, int startX,
+                                        int endX);
+  // the `percentile` (0-100) of the peak amplitudes of the windows, a clip
+  // value for display without reading the data
+  float clip_estimate(float percentile);
+  inline Backend backend() const {
+    return m_storage ? m_storage->backend() : Backend::MMap;
+  }
   void scan();
+  // take the index scanned by `other`, a file of the same geometry (e.g.,
+  // another attribute of the survey), instead of scanning. The file sizes
+  // and the keys of the first and last traces of each line are checked.
+  void share_scan(SegyIO &other);
   void tofile(const std::string &binary_out_name);
   void read(float *dst, int startX, int endX, int startY, int endY, int startZ,
             int endZ);
@@ -295,6 +452,62 @@ public:
   void read_cross_slice(float *dst, int iY);
   void read_time_slice(float *dst, int iX);
   void read_trace(float *dst, int iY, int iZ);
+  // update the samples of the file in place, e.g., an edited patch, src is
+  // (endZ - startZ) x (endY - startY) x (endX - startX). The samples are
+  // encoded straight into the traces found by scan(), the headers are never
+  // written. The missing traces are skipped, the samples past the end of a
+  // short trace are dropped, and the values are written as given (without
+  // the transform). The edit is synced to the disk before it returns.
+  void write(const float *src, int startX, int endX, int startY, int endY,
+             int startZ, int endZ);
+  // as write(), all samples set to `value`, e.g., a mute zone
+  void fill(float value, int startX, int endX, int startY, int endY,
+            int startZ, int endZ);
+  // clip and scale the samples while decoding them, in read() and tofile()
+  inline void setTransform(const Transform &transform) {
+    m_transform = transform;
+    m_transformReady = false;
+  }
+  inline Transform transform() const { return m_transform; }
+  // resample the traces to `interval` (us) while decoding them, in all
+  // reads and tofile(), 0 for the interval of the file. shape(0) and
+  // sample_interval() become the ones of the resampled traces.
+  void setResample(int interval);
+  int sample_interval();
+  // as read(), and the statistics of the samples read, accumulated while
+  // they are decoded. The fill values of the missing, dead and short
+  // traces are not counted.
+  SampleStats read_with_stats(float *dst, int startX, int endX, int startY,
+                              int endY, int startZ, int endZ);
+  SampleStats read_with_stats(float *dst);
+  // as read(), stored as `dtype`, one inline is decoded at a time. It
+  // returns the scales of the quantized types (value = sample * scale): one
+  // for the volume, from the zone map, or one per inline if `per_inline`.
+  std::vector<float> read_as(void *dst, DType dtype, bool per_inline,
+                             int startX, int endX, int startY, int endY,
+                             int startZ, int endZ);
+  std::vector<float> read_as(void *dst, DType dtype, bool per_inline = false);
+  // positions (inline, crossline) of the traces of an arbitrary line: the
+  // polyline through `npoints` points (inline, crossline), or (x, y) if
+  // `world`, sampled every `step` bins
+  std::vector<double> arbitrary_path(const double *points, int npoints,
+                                     bool world = false, double step = 1);
+  // the samples [startX, endX) of the traces at the `npath` positions
+  // (inline, crossline) of `path`, dst is npath x (endX - startX). The
+  // traces are read once each, in the order of the file.
+  void read_arbitrary_line(float *dst, const double *path, int64_t npath,
+                           Interpolation interp, int startX, int endX);
+  // the trilinear interpolation of the volume on `grid`, dst is
+  // nu x nv x nw. Only the traces around the grid are decoded, once each.
+  void read_oblique(float *dst, const ObliqueGrid &grid);
+  // The attribute maps of `nhorizon` horizons, each is n-inline x
+  // n-crossline times in ms (or depths in the unit of the file), NaN where
+  // absent, and so is each map of dst. The times are converted to samples
+  // with the start time and sample_interval(). The window is the samples
+  // within +/- `window` of the nearest one. Only the samples the horizons
+  // need are read, once for all of them.
+  void read_horizons(float *dst, const float *horizons, int nhorizon,
+                     HorizonAttr attr, int window = 0);
 
   // create segy
   void setSampleInterval(int interval);
@@ -311,20 +524,158 @@ public:
   void close_file();
 
 private:
+  // SegyWriter writes the headers of its SegyIO
+  friend class SegyWriter;
+
   bool isReadSegy{};
   bool isScan = false;
+  std::string m_segyName;
   mio::mmap_source m_source;
   mio::mmap_sink m_sink;
+  std::unique_ptr<Storage> m_storage;
+  // why the backend asked for was not opened, reported by scan()
+  std::string m_storageFallback;
+  // a seekable zstd file, m_source is not mapped and all bytes are read
+  // through m_storage
+  bool m_compressed = false;
+  uint64_t m_fileSize = 0; // decompressed
+  bool m_verbose = true;
   std::vector<LineInfo> m_lineInfo;
+  // byte offset of each trace, only built for variable length traces.
+  // It has trace_count + 1 elements, the last one is the end of the data.
+  std::vector<uint64_t> m_traceOffsets;
+  // crossline runs of the irregular lines, the runs of line iZ are
+  // m_xlineRuns[m_runIndex[iZ]:m_runIndex[iZ + 1]]
+  std::vector<CrosslineRun> m_xlineRuns;
+  std::vector<uint64_t> m_runIndex;
+  // bit i is set when trace i is dead, empty if not detected
+  bool m_detectDead = false;
+  std::vector<uint64_t> m_deadTraces;
+  int64_t m_deadCount = 0;
+  ZoneMap m_zoneMap;
+  // the samples decoded by read_one_trace() are added to it, if not null
+  SampleStats *m_stats = nullptr;
+  // m_transform resolved by prepareTransform(): the clip value, the gain of
+  // Scaling::Global and the gain of each trace of Scaling::Inline
+  Transform m_transform;
+  bool m_transformReady = false;
+  bool m_hasTransform = false;
+  float m_clip = 0;
+  float m_gain = 1;
+  std::vector<float> m_traceGain;
+  Resampler m_resampler;
+  int m_resampleInterval = 0;
   MetaInfo m_metaInfo{};
+  Geometry m_geometry{};
+  CoordIndex m_coordIndex{};
+  WriteMode m_writeMode = WriteMode::MMap;
+  int m_threads = 0;
+  uint64_t m_memoryBudget = kPipelineMemory;
+  bool m_directIO = false;
+  bool m_sparse = false;
+  uint64_t m_skipped = 0;
+  AccessHint m_accessHint = AccessHint::Auto;
+  // the hint of the current read call, and how many lines are prefetched
+  AccessHint m_activeHint = AccessHint::Normal;
+  int m_prefetchLines = 0;
 
   void scanBinaryHeader();
+  void scanTraceOffsets();
+  void scanSingleLine();
+  // the number of keys of a single line (crossline_field) in steps of the
+  // increment of its first two traces, 0 if the keys don't increase evenly
+  int64_t singleLineKeys(int32_t &step);
+  void scanCrosslineRuns();
+  void scanDeadTraces();
+  void requireZoneMap();
+  // RMS of the traces [first, last) from the zone map
+  double zone_rms(int64_t first, int64_t last);
+  void prepareTransform();
+  // the largest magnitude read() can return, from the zone map
+  float volume_peak();
+  void transform_trace(float *dst, int64_t itrace, int count);
+  void fitGeometry();
+  AccessHint choose_hint(int startX, int endX, int startY, int endY,
+                         int startZ, int endZ);
+  void begin_access(AccessHint hint, int startZ, int endZ);
+  void advance_access(int iZ, int startZ, int endZ);
+  void advise_range(uint64_t start, uint64_t end, int advice);
+  void drop_range(uint64_t start, uint64_t end);
+  // `raw`, when given, holds the bytes of the file from offset `base` on,
+  // otherwise the traces are read by m_storage
+  void read_line(float *dst, int iZ, int startX, int sizeX, int startY,
+                 int endY, const char *raw = nullptr, uint64_t base = 0);
+  void read_traces(float *dst, int64_t first, int64_t count, int startX,
+                   int sizeX, const char *raw = nullptr, uint64_t base = 0);
+  // index of the trace at (iZ, iY), -1 if it is missing
+  int64_t trace_at(int iZ, int iY) const;
+  // decode the sorted `traces` to dst, sizeX samples each
+  void read_trace_set(float *dst, const std::vector<int64_t> &traces,
+                      int startX, int sizeX);
+  void tofile_pipeline(int fd, bool sparse);
+  void read_one_trace(float *dst, const char *src, int64_t itrace, int startX,
+                      int sizeX);
+  // `src` or, if it is nullptr, `value` to the samples of the file
+  void update(const float *src, float value, int startX, int endX, int startY,
+              int endY, int startZ, int endZ);
+  // the dead flag of a trace just updated
+  void update_dead(int64_t itrace);
+  // decode and resample the output samples [startX, startX + sizeX) of a
+  // trace, `src` is its first sample. It returns the samples written.
+  int resample_trace(float *dst, const char *src, int64_t itrace, int startX,
+                     int sizeX);
   void initMetaInfo();
   void initTraceHeader(TraceHeader *trace_header);
   void write_textual_header(char *dst, const std::string &segy_out_name);
   void write_binary_header(char *dst);
   void write_trace_header(char *dst, TraceHeader *trace_header, int32_t iY,
                           int32_t iZ, int32_t x, int32_t y);
+  void write_trace(char *dst, TraceHeader *trace_header, const float *src,
+                   int iY, int iZ);
+
+  inline uint64_t trace_offset(int64_t itrace) const {
+    if (!m_traceOffsets.empty()) {
+      return m_traceOffsets[itrace];
+    }
+    return kTextualHeaderSize + kBinaryHeaderSize +
+           itrace * (m_metaInfo.sizeX * sizeof(float) + kTraceHeaderSize);
+  }
+
+  // byte range [begin, end) of line iZ in the file
+  inline void line_bytes(int iZ, uint64_t &begin, uint64_t &end) const {
+    int64_t first = static_cast<int64_t>(iZ) * m_metaInfo.sizeY;
+    int64_t last = first + m_metaInfo.sizeY;
+    if (!m_metaInfo.isNormalSegy) {
+      first = m_lineInfo[iZ].trace_start;
+      last = m_lineInfo[iZ].trace_end + 1;
+    }
+    begin = trace_offset(first);
+    end = trace_offset(last);
+  }
+
+  // bytes [offset, offset + size) of the segy file. When it's compressed,
+  // the pointer is only valid until the next read.
+  inline const char *file_ptr(uint64_t offset, uint64_t size) const {
+    if (m_compressed) {
+      return m_storage->fetch(offset, size);
+    }
+    return m_source.data() + offset;
+  }
+
+  inline const char *trace_ptr(int64_t itrace) const {
+    uint64_t offset = trace_offset(itrace);
+    return file_ptr(offset, trace_offset(itrace + 1) - offset);
+  }
+
+  // number of samples stored in trace `itrace`
+  inline int trace_samples(int64_t itrace) const {
+    if (!m_traceOffsets.empty()) {
+      return (m_traceOffsets[itrace + 1] - m_traceOffsets[itrace] -
+              kTraceHeaderSize) /
+             sizeof(float);
+    }
+    return m_metaInfo.sizeX;
+  }
 
   inline void get_TraceInfo(const char *field, TraceInfo &tmetaInfo) {
     tmetaInfo.inline_num =
@@ -345,6 +696,10 @@ void tofile_ignore_header(const std::string &segy_name,
 void tofile(const std::string &segy_name, const std::string &out_name,
             int iline = kDefaultInlineField,
             int xline = kDefaultCrosslineField);
+// read a binary file written by tofile(), the holes of a sparse file are
+// zero-filled without reading them
+void read_binary(const std::string &binary_name, float *dst, int sizeX,
+                 int sizeY, int sizeZ);
 void read(const std::string &segy_name, float *dst,
           int iline = kDefaultInlineField, int xline = kDefaultCrosslineField);
 
@@ -352,6 +707,14 @@ void create_by_sharing_header(const std::string &segy_name,
                               const std::string &header_segy, const float *src,
                               int sizeX, int sizeY, int sizeZ, int iline = 189,
                               int xline = 193);
+// create_by_sharing_header() of several arrays of the same shape, the
+// header segy is scanned and mapped once and the outputs are written in
+// parallel by `threads` threads (0: one per core)
+void create_by_sharing_header(const std::vector<std::string> &segy_names,
+                              const std::string &header_segy,
+                              const std::vector<const float *> &srcs,
+                              int sizeX, int sizeY, int sizeZ, int iline = 189,
+                              int xline = 193, int threads = 0);
 } // namespace segy
 
 #endif
\ No newline at end of file
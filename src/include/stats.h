@@ -0,0 +1,60 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: stats.h
+** @Time: 2026/10/19 23:02:45
+** @Version: 1.0
+** @Description : single pass statistics of the samples read
+*********************************************************************/
+
+#ifndef CIG_STATS_H
+#define CIG_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace segy {
+
+// The histogram bins are the top 16 bits of the samples in an order
+// preserving encoding of the float bits (sign, exponent and 7 bits of
+// mantissa), so no range is needed up front and the width of a bin is
+// below 1% of the values in it.
+const int kStatsBinBits = 16;
+const int kStatsBins = 1 << kStatsBinBits;
+
+// Min, max, sum and sum of squares of the samples, and a histogram for
+// approximate percentiles, accumulated in one pass. NaN samples are not
+// counted.
+class SampleStats {
+public:
+  SampleStats();
+
+  void add(const float *data, size_t n);
+  void merge(const SampleStats &other);
+
+  inline int64_t count() const { return m_count; }
+  inline float min() const { return m_min; }
+  inline float max() const { return m_max; }
+  inline double sum() const { return m_sum; }
+  inline double sum2() const { return m_sum2; }
+  double mean() const;
+  double std() const; // population standard deviation, as numpy
+  // `p` in [0, 100], interpolated within the bin of the rank
+  float percentile(double p) const;
+  inline const std::vector<uint64_t> &histogram() const { return m_hist; }
+
+private:
+  int64_t m_count = 0;
+  float m_min;
+  float m_max;
+  double m_sum = 0;
+  double m_sum2 = 0;
+  std::vector<uint64_t> m_hist;
+};
+
+} // namespace segy
+
+#endif
@@ -0,0 +1,91 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: storage.h
+** @Time: 2026/10/19 16:40:12
+** @Version: 1.0
+** @Description : storage backends for reading the trace data
+*********************************************************************/
+
+#ifndef CIG_STORAGE_H
+#define CIG_STORAGE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace segy {
+
+// size of each read of the io_uring backend, and how many are in flight
+const uint64_t kIOBlockSize = 1024 * 1024;
+const unsigned kIOQueueDepth = 64;
+
+// where the trace data is read from
+enum class Backend {
+  MMap,   // the shared memory map of the file (default)
+  PRead,  // one large pread() for each request
+  IOUring, // many asynchronous reads in flight with io_uring (Linux)
+  Zstd     // decompressed frames of a zstd file, chosen automatically
+           // (only reported by backend(), it can't be requested)
+};
+
+// A storage backend reads byte ranges of the segy file. It is used for the
+// trace data only, the headers are read from the memory map, unless the file
+// is compressed.
+class Storage {
+public:
+  virtual ~Storage() {}
+  virtual Backend backend() const = 0;
+
+  // bytes [offset, offset + size) of the file, the returned pointer is
+  // valid until the next call
+  virtual const char *fetch(uint64_t offset, uint64_t size) = 0;
+
+  // read n blocks, block i (sizes[i] bytes at offsets[i]) is copied to
+  // dst + i * stride
+  virtual void fetch_many(const uint64_t *offsets, const uint64_t *sizes,
+                          size_t n, char *dst, uint64_t stride) = 0;
+};
+
+class MMapStorage : public Storage {
+public:
+  explicit MMapStorage(const char *data) : m_data(data) {}
+  Backend backend() const override { return Backend::MMap; }
+  const char *fetch(uint64_t offset, uint64_t size) override;
+  void fetch_many(const uint64_t *offsets, const uint64_t *sizes, size_t n,
+                  char *dst, uint64_t stride) override;
+
+private:
+  const char *m_data;
+};
+
+class PReadStorage : public Storage {
+public:
+  explicit PReadStorage(const std::string &name);
+  ~PReadStorage() override;
+  Backend backend() const override { return Backend::PRead; }
+  const char *fetch(uint64_t offset, uint64_t size) override;
+  void fetch_many(const uint64_t *offsets, const uint64_t *sizes, size_t n,
+                  char *dst, uint64_t stride) override;
+
+protected:
+  int m_fd;
+  std::vector<char> m_buffer;
+
+  char *buffer(uint64_t size);
+  void read_full(char *dst, uint64_t size, uint64_t offset);
+};
+
+// Open a storage backend of `name`, `data` is its memory map. It falls back
+// to pread when io_uring is unavailable (old kernels, containers), the
+// reason is put in `fallback`. The backend opened is Storage::backend().
+std::unique_ptr<Storage> open_storage(Backend backend, const std::string &name,
+                                      const char *data,
+                                      std::string *fallback = nullptr);
+
+} // namespace segy
+
+#endif
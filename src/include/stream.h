@@ -0,0 +1,110 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: stream.h
+** @Time: 2026/10/19 19:05:48
+** @Version: 1.0
+** @Description : read segy sequentially from pipes and other streams
+*********************************************************************/
+
+#ifndef CIG_STREAM_H
+#define CIG_STREAM_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "segy.h"
+
+namespace segy {
+
+// size of the input buffer of SegyStream
+const size_t kStreamReadSize = 4 * 1024 * 1024;
+
+// a sequential source of bytes
+class ByteSource {
+public:
+  virtual ~ByteSource() {}
+  // read at most n bytes, returns 0 at the end of the stream
+  virtual size_t read(char *dst, size_t n) = 0;
+};
+
+class FdSource : public ByteSource {
+public:
+  FdSource(int fd, bool own) : m_fd(fd), m_own(own) {}
+  ~FdSource() override;
+  size_t read(char *dst, size_t n) override;
+
+private:
+  int m_fd;
+  bool m_own;
+};
+
+// one inline of SegyStream
+struct StreamLine {
+  int inline_num;
+  std::vector<int32_t> crosslines; // crossline number of each trace
+  std::vector<float> data;         // crosslines.size() * sizeX samples
+};
+
+// Read a segy file sequentially, e.g., from a pipe or stdin, without
+// mapping or seeking. The traces must be sorted by inline. The data is
+// emitted one inline at a time, so the memory is bounded by the size of one
+// inline. gzip and zstd compressed input is decompressed on the fly.
+class SegyStream {
+public:
+  // read from `fd`, the caller keeps the ownership of it
+  explicit SegyStream(int fd);
+  // read from a file, "-" for stdin
+  explicit SegyStream(const std::string &name);
+  explicit SegyStream(std::unique_ptr<ByteSource> source);
+
+  void setInlineLocation(int loc);
+  void setCrosslineLocation(int loc);
+  void setFillNoValue(float noValue);
+  // the crossline range of the output of tofile(), the traces out of it
+  // are dropped. Otherwise it's taken from the traces, and the written
+  // lines are rearranged in place when a later line extends it
+  void setCrosslineRange(int min_crossline, int max_crossline);
+
+  std::string textual_header();
+  inline MetaInfo get_metaInfo() { return m_metaInfo; }
+
+  // read the next inline, returns false at the end of the stream
+  bool next_line(StreamLine &line);
+
+  // Write the rest of the stream as a binary file (n-inline, n-crossline,
+  // n-time) like SegyIO::tofile(), the missing traces and inlines are
+  // filled with fillNoValue. The shape is in get_metaInfo() afterwards.
+  void tofile(const std::string &binary_out_name);
+
+private:
+  std::unique_ptr<ByteSource> m_source;
+  std::vector<char> m_buffer;
+  size_t m_pos = 0;
+  size_t m_len = 0;
+
+  char m_header[kTextualHeaderSize + kBinaryHeaderSize];
+  MetaInfo m_metaInfo{};
+  bool m_hasRange = false;
+  bool m_started = false;
+  // the traces longer than sizeX, cut to it
+  int64_t m_longTraces = 0;
+
+  // the first trace of the next line
+  std::vector<char> m_pending;
+  bool m_hasPending = false;
+
+  void readHeaders();
+  size_t read_exact(char *dst, size_t n);
+  bool read_trace(std::vector<char> &trace);
+  inline int32_t field(const std::vector<char> &trace, int loc) const {
+    return swap_endian(*reinterpret_cast<const int32_t *>(&trace[loc - 1]));
+  }
+};
+
+} // namespace segy
+
+#endif
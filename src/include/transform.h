@@ -0,0 +1,53 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: transform.h
+** @Time: 2026/10/19 23:41:20
+** @Version: 1.0
+** @Description : clipping and scaling applied while decoding
+*********************************************************************/
+
+#ifndef CIG_TRANSFORM_H
+#define CIG_TRANSFORM_H
+
+#include <vector>
+
+namespace segy {
+
+enum class Scaling {
+  Off,
+  Global,   // divided by the RMS of the volume, or multiplied by `scale`
+  Inline,   // divided by the RMS of its inline
+  TraceRMS, // divided by the RMS of the samples read of the trace
+  AGC       // automatic gain control, divided by the RMS of a window of
+            // `agc_window` samples centered on each sample
+};
+
+// What the reads do with the decoded samples, before they are stored. The
+// samples are clipped first, then scaled. The clip percentile and the RMS
+// of the volume and of the inlines come from the zone map (buildZoneMap()),
+// so they are the same for every read of the file, e.g., all patches of a
+// training set. The fill values are kept as they are.
+struct Transform {
+  // > 0: clip to +/- the percentile of the window peaks (clip_estimate())
+  float clip_percentile = 0;
+  // > 0: clip to [-clip, clip], if clip_percentile is 0
+  float clip = 0;
+  Scaling scaling = Scaling::Off;
+  // Scaling::Global: the multiplier, 0 for 1 / RMS of the volume
+  float scale = 0;
+  // Scaling::AGC: the window length in samples
+  int agc_window = 0;
+};
+
+// clip `data` to [-clip, clip]
+void clip_samples(float *data, int n, float clip);
+// multiply each sample by 1 / RMS of the `window` samples centered on it,
+// `scratch` is resized to hold the running sums
+void agc_samples(float *data, int n, int window, std::vector<double> &scratch);
+
+} // namespace segy
+
+#endif
@@ -13,6 +13,8 @@
 
 #include <cctype>
 #include <climits>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 #include <map>
 #include <set>
@@ -187,8 +189,6 @@ const std::set<int> kTraceHeader4Bytes = {1,  5,  9,  13,  17,  21,  25,  37,
                                           41, 45, 49, 53,  57,  61,  65,  73,
                                           77, 81, 85, 181, 185, 189, 193, 197};
 
-const uint64_t kMaxLSeekSize = std::numeric_limits<long>::max();
-
 template <typename T> T swap_endian(T u) {
   static_assert(CHAR_BIT == 8, "CHAR_BIT != 8");
 
@@ -332,6 +332,29 @@ inline bool isTextInEBCDICFormat(const char *text, size_t size) {
   return true;
 }
 
+// whether all `size` bytes are zero. The words are OR-ed without early
+// exit in blocks of 64 bytes, so the compiler vectorizes the inner loop.
+inline bool is_zero(const char *data, size_t size) {
+  size_t i = 0;
+  for (; i + 64 <= size; i += 64) {
+    uint64_t word[8];
+    memcpy(word, data + i, 64);
+    uint64_t acc = 0;
+    for (int k = 0; k < 8; k++) {
+      acc |= word[k];
+    }
+    if (acc != 0) {
+      return false;
+    }
+  }
+  for (; i < size; i++) {
+    if (data[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 } // namespace segy
 
 #endif
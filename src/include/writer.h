@@ -0,0 +1,71 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: writer.h
+** @Time: 2026/10/20 04:05:26
+** @Version: 1.0
+** @Description : create a segy file one block of inlines at a time
+*********************************************************************/
+
+#ifndef CIG_WRITER_H
+#define CIG_WRITER_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "segy.h"
+
+namespace segy {
+
+// Create a segy file one block of inlines at a time, e.g., the output of an
+// inference patch by patch, without the whole volume in memory. The
+// geometry is set up front as for SegyIO::create(). open() writes the
+// headers and allocates the file, then the blocks can be written in any
+// order and from several threads at once, each is encoded with its trace
+// headers and written by pwrite. close() writes the inlines that were never
+// given as zeros.
+class SegyWriter {
+public:
+  SegyWriter(int sizeX, int sizeY, int sizeZ);
+  ~SegyWriter();
+
+  SegyWriter(const SegyWriter &) = delete;
+  SegyWriter &operator=(const SegyWriter &) = delete;
+
+  // the geometry, before open()
+  void setSampleInterval(int interval);
+  void setDataFormatCode(int format);
+  void setStartTime(int start_time);
+  void setXInterval(float dz);
+  void setYInterval(float dy);
+  void setMinInline(int in);
+  void setMinCrossline(int cross);
+
+  inline int shape(int dimension) { return m_segy.shape(dimension); }
+
+  void open(const std::string &segy_out_name);
+  // the inlines [startZ, startZ + count), src is count x sizeY x sizeX,
+  // nullptr for zeros
+  void write_lines(const float *src, int startZ, int count);
+  // the number of inlines written so far
+  int lines_written();
+  void close();
+
+private:
+  SegyIO m_segy; // the geometry and the headers
+  int m_fd = -1;
+  TraceHeader m_traceHeader{};
+  std::mutex m_mutex;
+  std::vector<char> m_written; // of each inline
+  int m_count = 0;
+
+  void check_closed();
+  void encode_line(char *dst, const float *src, int iZ, TraceHeader &header);
+};
+
+} // namespace segy
+
+#endif
@@ -0,0 +1,57 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: zonemap.h
+** @Time: 2026/10/19 22:14:06
+** @Version: 1.0
+** @Description : per-trace amplitude zone map, persisted as .zmap
+*********************************************************************/
+
+#ifndef CIG_ZONEMAP_H
+#define CIG_ZONEMAP_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace segy {
+
+// the zone map of `f3.segy` is saved as `f3.segy.zmap`
+const char *const kZoneMapSuffix = ".zmap";
+// traces decoded per task of the parallel pass
+const int64_t kZoneMapChunk = 1024;
+
+// Min, max and RMS amplitude of each window of `window` samples of each
+// trace, the last window of a trace may be shorter. The statistics of
+// window iw of trace itrace are at [itrace * nwindows + iw]. A window
+// without samples (dead traces, the missing end of a variable length
+// trace) has zeros.
+struct ZoneMap {
+  int64_t trace_count = 0;
+  int32_t sizeX = 0;
+  int32_t window = 0;
+  int32_t nwindows = 0;
+  // built with dead trace detection, the windows of dead traces are zeros
+  bool detect_dead = false;
+  // the segy file it was built from, a stale map is rebuilt
+  uint64_t file_size = 0;
+  int64_t mtime = 0;
+  std::vector<float> min;
+  std::vector<float> max;
+  std::vector<float> rms;
+
+  inline bool empty() const { return min.empty(); }
+  inline float peak(int64_t i) const {
+    return -min[i] > max[i] ? -min[i] : max[i];
+  }
+};
+
+// Returns false when `name` doesn't exist or isn't a zone map file
+bool load_zonemap(const std::string &name, ZoneMap &map);
+void save_zonemap(const std::string &name, const ZoneMap &map);
+
+} // namespace segy
+
+#endif
@@ -0,0 +1,247 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: multi.cpp
+** @Time: 2026/10/20 03:12:40
+** @Version: 1.0
+** @Description : read several segy files of the same geometry together
+*********************************************************************/
+
+#include "multi.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <fmt/format.h>
+
+namespace segy {
+
+void SegyIO::share_scan(SegyIO &other) {
+  if (!isReadSegy || !other.isReadSegy) {
+    throw std::runtime_error(
+        "'share_scan()' function only used in reading segy mode.");
+  }
+  if (!other.isScan) {
+    other.scan();
+  }
+  if (m_fileSize != other.m_fileSize ||
+      (!other.m_metaInfo.isVariableLength &&
+       m_metaInfo.sizeX != other.m_metaInfo.sizeX)) {
+    throw std::runtime_error("The segy files have different sizes");
+  }
+
+  MetaInfo meta = other.m_metaInfo;
+  meta.data_format = m_metaInfo.data_format;
+  meta.sample_interval = m_metaInfo.sample_interval;
+  meta.fillNoValue = m_metaInfo.fillNoValue;
+  m_metaInfo = meta;
+  m_lineInfo = other.m_lineInfo;
+  m_traceOffsets = other.m_traceOffsets;
+  m_xlineRuns = other.m_xlineRuns;
+  m_runIndex = other.m_runIndex;
+  m_geometry = other.m_geometry;
+  m_coordIndex = other.m_coordIndex;
+
+  // the first and last trace of each line have the same keys
+  auto check = [&](int64_t itrace) {
+    TraceInfo a{}, b{};
+    get_TraceInfo(trace_ptr(itrace), a);
+    other.get_TraceInfo(other.trace_ptr(itrace), b);
+    if (a.inline_num != b.inline_num || a.crossline_num != b.crossline_num) {
+      throw std::runtime_error(
+          fmt::format("The segy files have different geometries, trace {} "
+                      "is ({}, {}) and ({}, {})",
+                      itrace, a.inline_num, a.crossline_num, b.inline_num,
+                      b.crossline_num));
+    }
+  };
+  check(0);
+  check(m_metaInfo.trace_count - 1);
+  for (const LineInfo &line : m_lineInfo) {
+    check(line.trace_start);
+    check(line.trace_end);
+  }
+
+  isScan = true;
+  m_transformReady = false;
+  // the dead traces are the ones of this file
+  scanDeadTraces();
+}
+
+MultiSegy::MultiSegy(const std::vector<std::string> &names, Backend backend) {
+  if (names.empty()) {
+    throw std::runtime_error("At least one segy file is needed");
+  }
+  for (const std::string &name : names) {
+    m_volumes.emplace_back(new SegyIO(name, backend));
+    m_volumes.back()->setVerbose(false);
+  }
+}
+
+void MultiSegy::setInlineLocation(int loc) {
+  for (auto &v : m_volumes) {
+    v->setInlineLocation(loc);
+  }
+  isScan = false;
+}
+
+void MultiSegy::setCrosslineLocation(int loc) {
+  for (auto &v : m_volumes) {
+    v->setCrosslineLocation(loc);
+  }
+  isScan = false;
+}
+
+void MultiSegy::setFillNoValue(float noValue) {
+  for (auto &v : m_volumes) {
+    v->setFillNoValue(noValue);
+  }
+}
+
+void MultiSegy::setResample(int interval) {
+  for (auto &v : m_volumes) {
+    v->setResample(interval);
+  }
+}
+
+void MultiSegy::scan() {
+  m_volumes[0]->scan();
+  for (size_t i = 1; i < m_volumes.size(); i++) {
+    m_volumes[i]->share_scan(*m_volumes[0]);
+  }
+  isScan = true;
+}
+
+int MultiSegy::shape(int dimension) {
+  if (!isScan) {
+    scan();
+  }
+  int size = m_volumes[0]->shape(dimension);
+  for (auto &v : m_volumes) {
+    if (v->shape(dimension) != size) {
+      throw std::runtime_error(
+          "The segy files have different shapes, e.g., sample intervals");
+    }
+  }
+  return size;
+}
+
+template <typename Task> void MultiSegy::for_each_volume(Task task) {
+  // a SegyIO is read by one thread at a time, so the files are the units
+  // of the work
+  int n = count();
+  int workers = m_threads > 0
+                    ? m_threads
+                    : std::max<int>(std::thread::hardware_concurrency(), 1);
+  workers = std::min(workers, n);
+  std::atomic<int> next(0);
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  std::atomic<bool> failed(false);
+
+  auto work = [&]() {
+    try {
+      int i;
+      while (!failed && (i = next.fetch_add(1)) < n) {
+        task(i);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+      failed = true;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < workers; i++) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (std::thread &t : threads) {
+    t.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void MultiSegy::read(float *dst, int startX, int endX, int startY, int endY,
+                     int startZ, int endZ, bool channels_last) {
+  if (startX >= endX || startY >= endY || startZ >= endZ) {
+    throw std::runtime_error("Index 'end' must large than 'start'");
+  }
+  if (startX < 0 || endX > shape(0) || startY < 0 || endY > shape(1) ||
+      startZ < 0 || endZ > shape(2)) {
+    throw std::runtime_error("Index out of range");
+  }
+  int64_t line = static_cast<int64_t>(endY - startY) * (endX - startX);
+  int64_t size = line * (endZ - startZ);
+  int n = count();
+  for_each_volume([&](int i) {
+    SegyIO &v = *m_volumes[i];
+    if (!channels_last) {
+      v.read(dst + i * size, startX, endX, startY, endY, startZ, endZ);
+      return;
+    }
+    // one inline at a time, interleaved into the channel i of dst
+    std::vector<float> buffer(line);
+    for (int iZ = startZ; iZ < endZ; iZ++) {
+      v.read(buffer.data(), startX, endX, startY, endY, iZ, iZ + 1);
+      float *out = dst + (iZ - startZ) * line * n + i;
+      for (int64_t k = 0; k < line; k++) {
+        out[k * n] = buffer[k];
+      }
+    }
+  });
+}
+
+void MultiSegy::read(float *dst, bool channels_last) {
+  read(dst, 0, shape(0), 0, shape(1), 0, shape(2), channels_last);
+}
+
+void MultiSegy::read_patches(float *dst, const int *starts, int npatch,
+                             int sizeX, int sizeY, int sizeZ,
+                             bool channels_last) {
+  if (sizeX < 1 || sizeY < 1 || sizeZ < 1) {
+    throw std::runtime_error("The patch size must be positive");
+  }
+  const int sizes[3] = {sizeZ, sizeY, sizeX};
+  for (int p = 0; p < npatch; p++) {
+    for (int d = 0; d < 3; d++) {
+      if (starts[3 * p + d] < 0 ||
+          starts[3 * p + d] + sizes[d] > shape(2 - d)) {
+        throw std::runtime_error("Index out of range");
+      }
+    }
+  }
+  int64_t size = static_cast<int64_t>(sizeZ) * sizeY * sizeX;
+  int n = count();
+  for_each_volume([&](int i) {
+    SegyIO &v = *m_volumes[i];
+    std::vector<float> buffer(channels_last ? size : 0);
+    for (int p = 0; p < npatch; p++) {
+      const int *s = starts + 3 * p;
+      float *out = dst + p * size * n;
+      if (!channels_last) {
+        v.read(out + i * size, s[2], s[2] + sizeX, s[1], s[1] + sizeY, s[0],
+               s[0] + sizeZ);
+        continue;
+      }
+      v.read(buffer.data(), s[2], s[2] + sizeX, s[1], s[1] + sizeY, s[0],
+             s[0] + sizeZ);
+      for (int64_t k = 0; k < size; k++) {
+        out[k * n + i] = buffer[k];
+      }
+    }
+  });
+}
+
+} // namespace segy
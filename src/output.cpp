@@ -0,0 +1,321 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: output.cpp
+** @Time: 2026/10/19 14:02:31
+** @Version: 1.0
+** @Description : output files, preallocation and streaming writer
+*********************************************************************/
+
+#include "output.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#include "utils.h"
+
+namespace segy {
+
+int create_file(const std::string &name, uint64_t size, bool sparse) {
+  int fd = open(name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 00644);
+  if (fd < 0) {
+    throw std::runtime_error("create file failed");
+  }
+  if (size == 0) {
+    return fd;
+  }
+#ifdef __linux__
+  // fallocate() instead of posix_fallocate(), because glibc emulates the
+  // latter by writing every block when the file system can't allocate
+  if (!sparse && fallocate(fd, 0, 0, size) == 0) {
+    return fd;
+  }
+#else
+  (void)sparse;
+#endif
+  if (ftruncate(fd, size) != 0) {
+    ::close(fd);
+    throw std::runtime_error("create file failed");
+  }
+  return fd;
+}
+
+void encode_samples(char *dst, const float *src, int64_t n, int format) {
+  float *out = reinterpret_cast<float *>(dst);
+  if (format == 1) {
+    for (int64_t i = 0; i < n; i++) {
+      out[i] = swap_endian(ieee_to_ibm(src[i], true));
+    }
+  } else {
+    for (int64_t i = 0; i < n; i++) {
+      out[i] = swap_endian(src[i]);
+    }
+  }
+}
+
+void pread_full(int fd, char *dst, uint64_t size, uint64_t offset) {
+  while (size > 0) {
+    ssize_t n = pread(fd, dst, size, offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      throw std::runtime_error("read file failed");
+    }
+    dst += n;
+    size -= n;
+    offset += n;
+  }
+}
+
+void pwrite_full(int fd, const char *src, uint64_t size, uint64_t offset) {
+  while (size > 0) {
+    ssize_t n = pwrite(fd, src, size, offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      throw std::runtime_error("write file failed");
+    }
+    src += n;
+    size -= n;
+    offset += n;
+  }
+}
+
+uint64_t pwrite_sparse(int fd, const char *src, uint64_t size,
+                       uint64_t offset) {
+  uint64_t skipped = 0;
+  uint64_t end = offset + size;
+  // runs of data pages are written at once
+  uint64_t run = offset;
+  uint64_t page = (offset + kSparsePageSize - 1) / kSparsePageSize *
+                  kSparsePageSize;
+  for (; page + kSparsePageSize <= end; page += kSparsePageSize) {
+    if (!is_zero(src + (page - offset), kSparsePageSize)) {
+      continue;
+    }
+    pwrite_full(fd, src + (run - offset), page - run, run);
+    run = page + kSparsePageSize;
+    skipped += kSparsePageSize;
+  }
+  pwrite_full(fd, src + (run - offset), end - run, run);
+  return skipped;
+}
+
+uint64_t pread_sparse(int fd, char *dst, uint64_t size, uint64_t offset) {
+#ifdef SEEK_HOLE
+  uint64_t holes = 0;
+  uint64_t end = offset + size;
+  uint64_t pos = offset;
+  while (pos < end) {
+    off_t data = lseek(fd, pos, SEEK_DATA);
+    if (data < 0 && errno != ENXIO) {
+      // no SEEK_DATA support, read everything
+      pread_full(fd, dst + (pos - offset), end - pos, pos);
+      return holes;
+    }
+    uint64_t data_start = data < 0 ? end : std::min<uint64_t>(data, end);
+    memset(dst + (pos - offset), 0, data_start - pos);
+    holes += data_start - pos;
+    if (data_start == end) {
+      break;
+    }
+    off_t hole = lseek(fd, data_start, SEEK_HOLE);
+    uint64_t data_end = hole < 0 ? end : std::min<uint64_t>(hole, end);
+    pread_full(fd, dst + (data_start - offset), data_end - data_start,
+               data_start);
+    pos = data_end;
+  }
+  return holes;
+#else
+  pread_full(fd, dst, size, offset);
+  return 0;
+#endif
+}
+
+StreamWriter::StreamWriter(int fd, uint64_t offset, size_t buffer_size)
+    : m_fd(fd), m_offset(offset), m_size(buffer_size), m_used(0),
+      m_buffers{nullptr, nullptr}, m_current(0), m_closed(false),
+      m_direct(false), m_pending(false), m_stop(false), m_job(nullptr),
+      m_jobSize(0), m_jobOffset(0), m_jobLast(false) {
+  m_size = (m_size + kStreamBufferAlign - 1) / kStreamBufferAlign *
+           kStreamBufferAlign;
+  for (int i = 0; i < 2; i++) {
+    void *ptr = nullptr;
+    if (posix_memalign(&ptr, kStreamBufferAlign, m_size) != 0) {
+      free(m_buffers[0]);
+      throw std::runtime_error("Cannot allocate the write buffers");
+    }
+    m_buffers[i] = static_cast<char *>(ptr);
+  }
+  m_thread = std::thread(&StreamWriter::run, this);
+}
+
+StreamWriter::~StreamWriter() {
+  if (!m_closed) {
+    try {
+      close();
+    } catch (...) {
+    }
+  }
+  free(m_buffers[0]);
+  free(m_buffers[1]);
+}
+
+bool StreamWriter::setDirect(bool direct) {
+#ifdef O_DIRECT
+  int flags = fcntl(m_fd, F_GETFL);
+  flags = direct ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+  if (flags < 0 || fcntl(m_fd, F_SETFL, flags) != 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_direct = direct;
+  return true;
+#else
+  return !direct;
+#endif
+}
+
+char *StreamWriter::reserve(size_t n) {
+  if (n > m_size) {
+    throw std::runtime_error("The block is larger than the write buffer");
+  }
+  if (m_used + n > m_size) {
+    submit();
+  }
+  return m_buffers[m_current] + m_used;
+}
+
+void StreamWriter::commit(size_t n) { m_used += n; }
+
+void StreamWriter::write(const char *src, size_t n) {
+  // the buffer is filled up before it is submitted, so only the last job
+  // can have a size O_DIRECT doesn't accept
+  while (n > 0) {
+    if (m_used == m_size) {
+      submit();
+    }
+    size_t len = std::min(n, m_size - m_used);
+    memcpy(m_buffers[m_current] + m_used, src, len);
+    m_used += len;
+    src += len;
+    n -= len;
+  }
+}
+
+void StreamWriter::submit() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  // the other buffer is free once its job is done
+  m_cv.wait(lock, [this] { return !m_pending; });
+  if (!m_error.empty()) {
+    throw std::runtime_error(m_error);
+  }
+  m_job = m_buffers[m_current];
+  m_jobSize = m_used;
+  m_jobOffset = m_offset;
+  m_jobLast = m_closed;
+  m_pending = true;
+  lock.unlock();
+  m_cv.notify_all();
+
+  m_offset += m_used;
+  m_used = 0;
+  m_current = 1 - m_current;
+}
+
+void StreamWriter::run() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_cv.wait(lock, [this] { return m_pending || m_stop; });
+    if (!m_pending) {
+      return;
+    }
+    const char *job = m_job;
+    size_t size = m_jobSize;
+    uint64_t offset = m_jobOffset;
+#ifdef O_DIRECT
+    if (m_direct &&
+        (size % kStreamBufferAlign || offset % kStreamBufferAlign)) {
+      // the tail of the file, O_DIRECT needs aligned sizes and offsets
+      if (!m_jobLast) {
+        fmt::print("[Warning]: an unaligned block before the end of the "
+                   "file, the rest is written through the page cache\n");
+      }
+      fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) & ~O_DIRECT);
+      m_direct = false;
+    }
+#endif
+    lock.unlock();
+
+    std::string error;
+    if (m_sparse) {
+      try {
+        m_skipped += pwrite_sparse(m_fd, job, size, offset);
+      } catch (const std::exception &e) {
+        error = e.what();
+      }
+      size = 0;
+    }
+    while (size > 0) {
+      ssize_t n = pwrite(m_fd, job, size, offset);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        error = std::string("write file failed: ") + strerror(errno);
+        break;
+      }
+      job += n;
+      size -= n;
+      offset += n;
+    }
+
+    lock.lock();
+    if (!error.empty()) {
+      m_error = error;
+    }
+    m_pending = false;
+    m_cv.notify_all();
+  }
+}
+
+void StreamWriter::close() {
+  if (m_closed) {
+    return;
+  }
+  m_closed = true;
+  std::string error;
+  try {
+    if (m_used > 0) {
+      submit();
+    }
+  } catch (const std::exception &e) {
+    error = e.what();
+  }
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this] { return !m_pending; });
+    m_stop = true;
+    if (error.empty()) {
+      error = m_error;
+    }
+  }
+  m_cv.notify_all();
+  m_thread.join();
+  if (!error.empty()) {
+    throw std::runtime_error(error);
+  }
+}
+
+} // namespace segy
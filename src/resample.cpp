@@ -0,0 +1,201 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: resample.cpp
+** @Time: 2026/10/20 01:02:37
+** @Version: 1.0
+** @Description : polyphase resampling of the time axis
+*********************************************************************/
+
+#include "resample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "segy.h"
+
+namespace segy {
+
+static const double kPI = 3.14159265358979323846;
+
+static int gcd(int a, int b) {
+  while (b != 0) {
+    int t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// index i reflected into [0, n), the end samples are not repeated
+static inline int mirror(int i, int n) {
+  if (n == 1) {
+    return 0;
+  }
+  int period = 2 * (n - 1);
+  i %= period;
+  i = i < 0 ? i + period : i;
+  return i < n ? i : period - i;
+}
+
+static inline float dot(const float *x, const float *c, int n) {
+#ifdef __SSE2__
+  // n is a multiple of 8
+  __m128 s0 = _mm_setzero_ps();
+  __m128 s1 = _mm_setzero_ps();
+  for (int i = 0; i < n; i += 8) {
+    s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(c + i)));
+    s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(x + i + 4),
+                                   _mm_loadu_ps(c + i + 4)));
+  }
+  float s[4];
+  _mm_storeu_ps(s, _mm_add_ps(s0, s1));
+  return (s[0] + s[1]) + (s[2] + s[3]);
+#else
+  float s = 0;
+  for (int i = 0; i < n; i++) {
+    s += x[i] * c[i];
+  }
+  return s;
+#endif
+}
+
+Resampler::Resampler(int interval_in, int interval_out) {
+  if (interval_in <= 0 || interval_out <= 0) {
+    throw std::runtime_error("The sample intervals must be positive");
+  }
+  if (interval_in == interval_out) {
+    return;
+  }
+  int g = gcd(interval_in, interval_out);
+  m_up = interval_in / g;
+  m_down = interval_out / g;
+
+  // the cutoff relative to the input Nyquist frequency, below the output
+  // one when downsampling
+  double fc = m_up < m_down ? kResampleCutoff * m_up / m_down : 1.0;
+  m_half = static_cast<int>(std::ceil(kResampleZeros / fc));
+  m_taps = (2 * m_half + 7) / 8 * 8;
+  m_coefs.assign(static_cast<size_t>(m_up) * m_taps, 0);
+  for (int p = 0; p < m_up; p++) {
+    float *c = m_coefs.data() + static_cast<size_t>(p) * m_taps;
+    double sum = 0;
+    for (int k = 0; k < 2 * m_half; k++) {
+      // from the output position to the input sample k, in (-m_half, m_half]
+      double t = k - m_half + 1 - static_cast<double>(p) / m_up;
+      double x = t / m_half;
+      double w = 0.42 + 0.5 * std::cos(kPI * x) + 0.08 * std::cos(2 * kPI * x);
+      double s = t == 0 ? 1 : std::sin(kPI * fc * t) / (kPI * fc * t);
+      c[k] = static_cast<float>(fc * s * w);
+      sum += c[k];
+    }
+    // unit gain at 0 Hz for every phase
+    for (int k = 0; k < 2 * m_half; k++) {
+      c[k] = static_cast<float>(c[k] / sum);
+    }
+  }
+}
+
+void Resampler::input_range(int start, int count, int &first,
+                            int &last) const {
+  int64_t begin = static_cast<int64_t>(start) * m_down / m_up;
+  int64_t end = static_cast<int64_t>(start + count - 1) * m_down / m_up;
+  first = static_cast<int>(begin) - m_half + 1;
+  last = static_cast<int>(end) - m_half + 1 + m_taps;
+}
+
+void Resampler::apply(const float *in, int lo, int hi, int n, int start,
+                      int count, float *dst) const {
+  if (count <= 0) {
+    return;
+  }
+  int first, last;
+  input_range(start, count, first, last);
+  // the input [first, last), out of the trace it is mirrored
+  static thread_local std::vector<float> padded;
+  padded.resize(last - first);
+  auto sample = [&](int i) {
+    int j = std::min(std::max(mirror(i, n), lo), hi - 1);
+    return in[j - lo];
+  };
+  int a = std::min(std::max(first, lo), last);
+  int b = std::max(std::min(last, hi), a);
+  for (int i = first; i < a; i++) {
+    padded[i - first] = sample(i);
+  }
+  memcpy(padded.data() + (a - first), in + (a - lo), (b - a) * sizeof(float));
+  for (int i = b; i < last; i++) {
+    padded[i - first] = sample(i);
+  }
+
+  for (int j = 0; j < count; j++) {
+    int64_t pos = static_cast<int64_t>(start + j) * m_down;
+    int base = static_cast<int>(pos / m_up);
+    int phase = static_cast<int>(pos % m_up);
+    dst[j] = dot(padded.data() + (base - m_half + 1 - first),
+                 m_coefs.data() + static_cast<size_t>(phase) * m_taps, m_taps);
+  }
+}
+
+void SegyIO::setResample(int interval) {
+  if (!isReadSegy) {
+    throw std::runtime_error(
+        "'setResample()' function only used in reading segy mode");
+  }
+  if (interval < 0 || interval > INT16_MAX) {
+    throw std::runtime_error("The sample interval must be in [0, 32767]");
+  }
+  m_resampler = interval == 0
+                    ? Resampler()
+                    : Resampler(m_metaInfo.sample_interval, interval);
+  m_resampleInterval = m_resampler.empty() ? 0 : interval;
+}
+
+int SegyIO::sample_interval() {
+  return m_resampleInterval > 0 ? m_resampleInterval
+                                : m_metaInfo.sample_interval;
+}
+
+MetaInfo SegyIO::get_metaInfo() {
+  MetaInfo meta = m_metaInfo;
+  meta.sizeX = shape(0);
+  meta.sample_interval = static_cast<int16_t>(sample_interval());
+  return meta;
+}
+
+int SegyIO::resample_trace(float *dst, const char *src, int64_t itrace,
+                           int startX, int sizeX) {
+  int n = std::min(trace_samples(itrace), m_metaInfo.sizeX);
+  int count = std::min(std::max(m_resampler.out_size(n) - startX, 0), sizeX);
+  if (count == 0) {
+    return 0;
+  }
+  // only the input samples around the output ones are decoded
+  int first, last;
+  m_resampler.input_range(startX, count, first, last);
+  int lo = std::max(first - m_resampler.half(), 0);
+  int hi = std::min(last + m_resampler.half(), n);
+  static thread_local std::vector<float> in;
+  in.resize(hi - lo);
+  memcpy(in.data(), src + lo * sizeof(float), (hi - lo) * sizeof(float));
+  if (m_metaInfo.data_format == 1) {
+    for (int iX = 0; iX < hi - lo; iX++) {
+      in[iX] = ibm_to_ieee(in[iX], true);
+    }
+  } else {
+    for (int iX = 0; iX < hi - lo; iX++) {
+      in[iX] = swap_endian(in[iX]);
+    }
+  }
+  m_resampler.apply(in.data(), lo, hi, n, startX, count, dst);
+  return count;
+}
+
+} // namespace segy
@@ -10,26 +10,61 @@
 *********************************************************************/
 
 #include "segy.h"
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cmath>
 #include <cstring>
+#include <exception>
+#include <fcntl.h>
 #define FMT_HEADER_ONLY
 #include <fmt/format.h>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <stdexcept>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
 
+#include "compress.h"
 #include "mio.hpp"
+#include "output.h"
 #include "progressbar.hpp"
 #include "utils.h"
 
 namespace segy {
 
-SegyIO::SegyIO(const std::string &segyname) {
+static inline int32_t getCrossline(const char *source, int field) {
+  return swap_endian(*(int32_t *)(source + field - 1));
+}
+
+SegyIO::SegyIO(const std::string &segyname, Backend backend) {
   this->isReadSegy = true;
+  this->m_segyName = segyname;
   memset(&this->m_metaInfo, 0, sizeof(MetaInfo));
   std::error_code error;
   this->m_source.map(segyname, error);
   if (error) {
     throw std::runtime_error("Cannot mmap segy file");
   }
+  Compression compression =
+      detect_compression(m_source.data(), m_source.size());
+  if (compression == Compression::Gzip) {
+    throw std::runtime_error(
+        "A gzip compressed segy file can only be read sequentially, use "
+        "SegyStream or tofile()");
+  }
+  if (compression == Compression::Zstd) {
+    // the headers and the traces are read from the decompressed frames
+    m_source.unmap();
+    this->m_storage = open_zstd(segyname, m_fileSize);
+    this->m_compressed = true;
+  } else {
+    this->m_fileSize = m_source.size();
+    this->m_storage = open_storage(backend, segyname, m_source.data(),
+                                   &m_storageFallback);
+  }
   scanBinaryHeader();
 }
 
@@ -38,7 +73,7 @@ SegyIO::SegyIO(int sizeX, int sizeY, int sizeZ) {
   this->m_metaInfo.sizeX = sizeX;
   this->m_metaInfo.sizeY = sizeY;
   this->m_metaInfo.sizeZ = sizeZ;
-  this->m_metaInfo.trace_count = sizeY * sizeZ;
+  this->m_metaInfo.trace_count = static_cast<int64_t>(sizeY) * sizeZ;
   this->initMetaInfo();
 }
 
@@ -52,7 +87,7 @@ SegyIO::SegyIO(const std::string &binaryname, int sizeX, int sizeY, int sizeZ) {
   this->m_metaInfo.sizeX = sizeX;
   this->m_metaInfo.sizeY = sizeY;
   this->m_metaInfo.sizeZ = sizeZ;
-  this->m_metaInfo.trace_count = sizeY * sizeZ;
+  this->m_metaInfo.trace_count = static_cast<int64_t>(sizeY) * sizeZ;
   this->initMetaInfo();
 }
 
@@ -60,6 +95,9 @@ SegyIO::~SegyIO() {
   if (m_source.is_mapped()) {
     m_source.unmap();
   }
+  if (m_sink.is_mapped()) {
+    m_sink.unmap();
+  }
 }
 
 void SegyIO::setInlineLocation(int loc) {
@@ -115,6 +153,21 @@ void SegyIO::setYLocation(int loc) {
   isScan = false;
 }
 
+void SegyIO::setLine2D(int keyloc) {
+  if (keyloc != 21 && keyloc != 1 && keyloc != 5) {
+    fmt::print("[Warning]: You set a unusual trace key field for 2D line: {}, "
+               "the best choice is set it as 21 (CDP) or 1 or 5 (trace "
+               "sequence number).\n",
+               keyloc);
+  }
+  if (keyloc <= 0) {
+    throw std::runtime_error("Invalid location (must > 0)");
+  }
+  m_metaInfo.is2D = true;
+  m_metaInfo.crossline_field = keyloc;
+  isScan = false;
+}
+
 void SegyIO::setFillNoValue(float noValue) {
   m_metaInfo.fillNoValue = noValue;
   isScan = false;
@@ -178,17 +231,77 @@ void SegyIO::setMinCrossline(int cross) {
   isScan = false;
 }
 
+void SegyIO::setVariableLength(bool variable) {
+  if (!isReadSegy) {
+    throw std::runtime_error(
+        "'setVariableLength()' function only used in reading segy mode.");
+  }
+  if (variable) {
+    scanTraceOffsets();
+  } else {
+    const auto *binary_header = reinterpret_cast<const BinaryHeader *>(
+        file_ptr(kTextualHeaderSize, kBinaryHeaderSize));
+    m_traceOffsets.clear();
+    m_metaInfo.isVariableLength = false;
+    m_metaInfo.sizeX = swap_endian(binary_header->trace_length);
+    m_metaInfo.trace_count =
+        (m_fileSize - kTextualHeaderSize - kBinaryHeaderSize) /
+        (kTraceHeaderSize + m_metaInfo.sizeX * sizeof(float));
+  }
+  isScan = false;
+}
+
 void SegyIO::scanBinaryHeader() {
   const auto *binary_header = reinterpret_cast<const BinaryHeader *>(
-      m_source.data() + kTextualHeaderSize);
+      file_ptr(kTextualHeaderSize, kBinaryHeaderSize));
   m_metaInfo.data_format = swap_endian(binary_header->data_format);
   m_metaInfo.sizeX = swap_endian(binary_header->trace_length);
   m_metaInfo.sample_interval = swap_endian(binary_header->sample_interval);
+
+  // SEG-Y rev 2 marks files whose traces have different sample counts
+  // with a zero 'fixed length trace flag'
+  int revision = static_cast<unsigned char>(binary_header->major_version);
+  if (revision >= 2 && swap_endian(binary_header->fixed_length_trace) == 0) {
+    scanTraceOffsets();
+    return;
+  }
+
   m_metaInfo.trace_count =
-      (m_source.size() - kTextualHeaderSize - kBinaryHeaderSize) /
+      (m_fileSize - kTextualHeaderSize - kBinaryHeaderSize) /
       (kTraceHeaderSize + m_metaInfo.sizeX * sizeof(float));
 }
 
+void SegyIO::scanTraceOffsets() {
+  // walk the trace headers once, each one tells the sample count
+  // (bytes 115-116) of its own trace
+  m_traceOffsets.clear();
+  uint64_t offset = kTextualHeaderSize + kBinaryHeaderSize;
+  int max_samples = 0;
+  while (offset + kTraceHeaderSize <= m_fileSize) {
+    uint16_t nsamples = swap_endian(*reinterpret_cast<const uint16_t *>(
+        file_ptr(offset + kTSampleCountField - 1, 2)));
+    uint64_t next = offset + kTraceHeaderSize + nsamples * sizeof(float);
+    if (next > m_fileSize) {
+      fmt::print("[Warning]: the last trace is truncated, ignore it.\n");
+      break;
+    }
+    m_traceOffsets.push_back(offset);
+    if (nsamples > max_samples) {
+      max_samples = nsamples;
+    }
+    offset = next;
+  }
+  m_traceOffsets.push_back(offset);
+
+  if (m_traceOffsets.size() < 2) {
+    throw std::runtime_error("No trace in this segy file");
+  }
+  m_metaInfo.isVariableLength = true;
+  m_metaInfo.sizeX = max_samples;
+  m_metaInfo.trace_count = m_traceOffsets.size() - 1;
+  isScan = false;
+}
+
 void SegyIO::scan() {
   if (!isReadSegy) {
     throw std::runtime_error(
@@ -196,6 +309,11 @@ void SegyIO::scan() {
   }
 
   isScan = true;
+  m_transformReady = false;
+  if (m_verbose && !m_storageFallback.empty()) {
+    fmt::print("[Warning]: {}, use pread instead.\n", m_storageFallback);
+    m_storageFallback.clear();
+  }
   if (m_metaInfo.inline_field == 0) {
     m_metaInfo.inline_field = kDefaultInlineField;
   }
@@ -212,8 +330,7 @@ void SegyIO::scan() {
   }
 
   // get sizeZ, i.e. line_count
-  int trace_size = m_metaInfo.sizeX * sizeof(float) + kTraceHeaderSize;
-  const char *start = m_source.data() + kTextualHeaderSize + kBinaryHeaderSize;
+  const char *start = trace_ptr(0);
   m_metaInfo.start_time = swap_endian(
       *reinterpret_cast<const int16_t *>(start + kTStartTimeField - 1));
   m_metaInfo.scalar = swap_endian(
@@ -223,9 +340,19 @@ void SegyIO::scan() {
   // line x+1: trace2 ...
   TraceInfo trace1{}, trace2{};
   get_TraceInfo(start, trace1);
-  get_TraceInfo(start + static_cast<uint64_t>(m_metaInfo.trace_count - 1) *
-                            trace_size,
-                trace2);
+  get_TraceInfo(trace_ptr(m_metaInfo.trace_count - 1), trace2);
+
+  // a 2D line or a 3D file with only one inline. Without setLine2D(), the
+  // crossline keys must account for every trace, otherwise the inline
+  // field is more likely wrong (e.g., all zeros) than the file one line.
+  int32_t step = 0;
+  if (m_metaInfo.is2D || (trace1.inline_num == trace2.inline_num &&
+                          singleLineKeys(step) == m_metaInfo.trace_count)) {
+    scanSingleLine();
+    scanDeadTraces();
+    return;
+  }
+
   m_metaInfo.sizeZ = trace2.inline_num - trace1.inline_num + 1;
   m_metaInfo.min_inline = trace1.inline_num;
   m_metaInfo.max_inline = trace2.inline_num;
@@ -234,8 +361,7 @@ void SegyIO::scan() {
   m_metaInfo.min_crossline = trace1.crossline_num;
   m_metaInfo.max_crossline = trace2.crossline_num;
 
-  if (m_metaInfo.sizeZ > kMaxSizeOneDimemsion ||
-      m_metaInfo.trace_count / m_metaInfo.sizeZ == 0 || m_metaInfo.sizeZ < 2) {
+  if (m_metaInfo.sizeZ < 2 || m_metaInfo.sizeZ > m_metaInfo.trace_count) {
     throw std::runtime_error(
         "Size Z (inline number) is invalid, don't support. Maybe the "
         "inline location is wrong, use 'setInlineLocation(loc)' to set.");
@@ -246,10 +372,10 @@ void SegyIO::scan() {
   m_lineInfo.resize(m_metaInfo.sizeZ);
 
   // fill m_lineInfo
-  int jump = m_metaInfo.trace_count / m_metaInfo.sizeZ;
+  int64_t jump = m_metaInfo.trace_count / m_metaInfo.sizeZ;
   m_metaInfo.sizeY = jump;
   int64_t itrace = 0;
-  get_TraceInfo(start, trace2);
+  get_TraceInfo(trace_ptr(0), trace2);
   for (int i = 0; i < m_metaInfo.sizeZ - 1; i++) {
     m_lineInfo[i].trace_start = itrace;
     m_lineInfo[i].line_num = trace2.inline_num;
@@ -260,22 +386,24 @@ void SegyIO::scan() {
     }
 
     itrace += jump;
-    get_TraceInfo(start + itrace * trace_size, trace2);
-    get_TraceInfo(start + (itrace - 1) * trace_size, trace1);
+    if (itrace >= m_metaInfo.trace_count) {
+      itrace = m_metaInfo.trace_count - 1;
+    }
+    get_TraceInfo(trace_ptr(itrace), trace2);
+    get_TraceInfo(trace_ptr(itrace - 1), trace1);
 
     if (trace2.inline_num == m_lineInfo[i].line_num) {
       m_metaInfo.isNormalSegy = false;
       while (trace2.inline_num != m_lineInfo[i].line_num + 1 &&
-             itrace < m_metaInfo.trace_count &&
-             m_metaInfo.sizeY <= kMaxSizeOneDimemsion) {
+             itrace < m_metaInfo.trace_count) {
         itrace++;
         jump++;
-        if (jump > kMaxSizeOneDimemsion || itrace >= m_metaInfo.trace_count) {
+        if (itrace >= m_metaInfo.trace_count) {
           throw std::runtime_error(
               "inline/crossline location is wrong, use "
               "'setInlineLocation(loc)'/'setCrosslineLocation(loc)' to set");
         }
-        get_TraceInfo(start + itrace * trace_size, trace2);
+        get_TraceInfo(trace_ptr(itrace), trace2);
       }
       if (jump > m_metaInfo.sizeY) {
         m_metaInfo.sizeY = jump;
@@ -292,7 +420,7 @@ void SegyIO::scan() {
               "'setInlineLocation(loc)'/'setCrosslineLocation(loc)' to set");
         }
         trace2 = trace1;
-        get_TraceInfo(start + (itrace - 1) * trace_size, trace1);
+        get_TraceInfo(trace_ptr(itrace - 1), trace1);
       }
     }
 
@@ -314,25 +442,173 @@ void SegyIO::scan() {
   m_lineInfo[m_metaInfo.sizeZ - 1].trace_end = m_metaInfo.trace_count - 1;
   m_lineInfo[m_metaInfo.sizeZ - 1].count = m_metaInfo.trace_count - itrace;
 
-  // cal x, y interval
-  get_TraceInfo(start, trace1);
-  get_TraceInfo(start + m_lineInfo[0].trace_end * trace_size, trace2);
-  m_metaInfo.Y_interval = std::sqrt(std::pow(trace2.X - trace1.X, 2) +
-                                    std::pow(trace2.Y - trace1.Y, 2)) /
-                          m_lineInfo[0].count;
-  int num = m_metaInfo.trace_count > 10 ? 10 : m_metaInfo.trace_count - 1;
-  get_TraceInfo(start + m_lineInfo[num].trace_start * trace_size, trace2);
-  m_metaInfo.Z_interval =
-      std::sqrt(std::pow(trace2.X - trace1.X, 2) +
-                std::pow(trace2.Y - trace1.Y, 2) -
-                std::pow((trace2.crossline_num - trace1.crossline_num) *
-                             m_metaInfo.Y_interval,
-                         2)) /
-      (trace2.inline_num - trace1.inline_num);
+  scanCrosslineRuns();
+
+  // fit the affine transform from (inline, crossline) to (X, Y),
+  // the crossline and inline intervals are obtained from it
+  fitGeometry();
+
+  scanDeadTraces();
 }
 
-static inline int32_t getCrossline(const char *source, int field) {
-  return swap_endian(*(int32_t *)(source + field - 1));
+int64_t SegyIO::singleLineKeys(int32_t &step) {
+  step = 0;
+  if (m_metaInfo.trace_count < 2) {
+    return m_metaInfo.trace_count;
+  }
+  int32_t first = getCrossline(trace_ptr(0), m_metaInfo.crossline_field);
+  int32_t second = getCrossline(trace_ptr(1), m_metaInfo.crossline_field);
+  int32_t last = getCrossline(trace_ptr(m_metaInfo.trace_count - 1),
+                              m_metaInfo.crossline_field);
+  int64_t span = static_cast<int64_t>(last) - first;
+  if (second <= first || span % (second - first) != 0) {
+    return 0;
+  }
+  step = second - first;
+  return span / step + 1;
+}
+
+void SegyIO::scanSingleLine() {
+  // Only the first two and the last trace are visited, so it costs the
+  // same for any length of the line. The traces are indexed by the key in
+  // crossline_field (CDP, trace sequence number or crossline number).
+  TraceInfo first{}, last{};
+  get_TraceInfo(trace_ptr(0), first);
+  get_TraceInfo(trace_ptr(m_metaInfo.trace_count - 1), last);
+
+  m_metaInfo.sizeZ = 1;
+  m_metaInfo.min_inline = first.inline_num;
+  m_metaInfo.max_inline = first.inline_num;
+  m_metaInfo.min_crossline = first.crossline_num;
+  m_metaInfo.max_crossline = last.crossline_num;
+
+  int32_t step = 0;
+  int64_t nkeys = singleLineKeys(step);
+  if (nkeys == m_metaInfo.trace_count) {
+    // one trace for each key, whatever the increment (e.g., CDP by 2)
+    m_metaInfo.isNormalSegy = true;
+  } else if (step == 1 && nkeys > m_metaInfo.trace_count &&
+             nkeys <= std::min<int64_t>(
+                          kMaxKeysPerTrace * m_metaInfo.trace_count,
+                          std::numeric_limits<int>::max())) {
+    // sorted one by one, but missing some traces
+    m_metaInfo.isNormalSegy = false;
+  } else {
+    fmt::print("[Warning]: the trace keys (field: {}) are not increasing "
+               "evenly, index the traces by their order in the file.\n",
+               m_metaInfo.crossline_field);
+    m_metaInfo.isNormalSegy = true;
+    m_metaInfo.min_crossline = 1;
+    m_metaInfo.max_crossline = m_metaInfo.trace_count;
+    nkeys = m_metaInfo.trace_count;
+  }
+  m_metaInfo.sizeY = static_cast<int>(nkeys);
+
+  m_lineInfo.resize(1);
+  m_lineInfo[0].line_num = first.inline_num;
+  m_lineInfo[0].trace_start = 0;
+  m_lineInfo[0].trace_end = m_metaInfo.trace_count - 1;
+  m_lineInfo[0].count = m_metaInfo.trace_count;
+
+  m_metaInfo.Y_interval =
+      std::sqrt(std::pow(last.X - first.X, 2) + std::pow(last.Y - first.Y, 2)) /
+      std::max<int64_t>(m_lineInfo[0].count - 1, 1);
+  m_metaInfo.Z_interval = 0;
+  m_geometry = Geometry();
+  m_coordIndex = CoordIndex();
+
+  scanCrosslineRuns();
+}
+
+void SegyIO::scanCrosslineRuns() {
+  // For the lines missing some traces, record which crosslines are present
+  // as runs of consecutive crosslines, so that reading a line never needs
+  // to visit the trace headers again.
+  m_xlineRuns.clear();
+  m_runIndex.assign(m_metaInfo.sizeZ + 1, 0);
+  for (int iZ = 0; iZ < m_metaInfo.sizeZ; iZ++) {
+    m_runIndex[iZ] = m_xlineRuns.size();
+    if (m_metaInfo.isNormalSegy || m_lineInfo[iZ].count == m_metaInfo.sizeY) {
+      continue;
+    }
+    size_t first = m_xlineRuns.size();
+    for (uint64_t itrace = m_lineInfo[iZ].trace_start;
+         itrace <= m_lineInfo[iZ].trace_end; itrace++) {
+      int32_t iY = getCrossline(trace_ptr(itrace), m_metaInfo.crossline_field) -
+                   m_metaInfo.min_crossline;
+      if (iY < 0 || iY >= m_metaInfo.sizeY) {
+        continue;
+      }
+      if (m_xlineRuns.size() > first) {
+        CrosslineRun &last = m_xlineRuns.back();
+        if (iY == last.crossline + last.count &&
+            static_cast<int64_t>(itrace) == last.trace + last.count) {
+          last.count++;
+          continue;
+        }
+      }
+      CrosslineRun run{iY, 1, static_cast<int64_t>(itrace)};
+      m_xlineRuns.push_back(run);
+    }
+    std::sort(m_xlineRuns.begin() + first, m_xlineRuns.end(),
+              [](const CrosslineRun &a, const CrosslineRun &b) {
+                return a.crossline < b.crossline;
+              });
+  }
+  m_runIndex[m_metaInfo.sizeZ] = m_xlineRuns.size();
+}
+
+void SegyIO::scanDeadTraces() {
+  m_deadTraces.clear();
+  m_deadCount = 0;
+  if (!m_detectDead) {
+    return;
+  }
+  if (m_accessHint != AccessHint::Normal &&
+      m_accessHint != AccessHint::Random) {
+    advise_range(0, m_source.mapped_length(), MADV_SEQUENTIAL);
+  }
+  m_deadTraces.assign((m_metaInfo.trace_count + 63) / 64, 0);
+  for (int64_t itrace = 0; itrace < m_metaInfo.trace_count; itrace++) {
+    const char *src = trace_ptr(itrace);
+    int16_t code = swap_endian(
+        *reinterpret_cast<const int16_t *>(src + kTTraceIDField - 1));
+    // both IBM and IEEE zeros are all zero bits
+    if (code == 2 || is_zero(src + kTraceHeaderSize,
+                             trace_samples(itrace) * sizeof(float))) {
+      m_deadTraces[itrace >> 6] |= uint64_t(1) << (itrace & 63);
+      m_deadCount++;
+    }
+  }
+  if (m_deadCount == 0) {
+    m_deadTraces.clear();
+  }
+}
+
+void SegyIO::dead_mask(uint8_t *mask) {
+  if (!isScan) {
+    scan();
+  }
+  int sizeY = m_metaInfo.sizeY;
+  for (int iZ = 0; iZ < m_metaInfo.sizeZ; iZ++) {
+    uint8_t *line = mask + static_cast<uint64_t>(iZ) * sizeY;
+    if (m_metaInfo.isNormalSegy || m_lineInfo[iZ].count == sizeY) {
+      int64_t first = m_metaInfo.isNormalSegy
+                          ? static_cast<int64_t>(iZ) * sizeY
+                          : m_lineInfo[iZ].trace_start;
+      for (int iY = 0; iY < sizeY; iY++) {
+        line[iY] = is_dead(first + iY) ? 1 : 0;
+      }
+      continue;
+    }
+    std::fill(line, line + sizeY, 2);
+    for (uint64_t r = m_runIndex[iZ]; r < m_runIndex[iZ + 1]; r++) {
+      const CrosslineRun &run = m_xlineRuns[r];
+      for (int i = 0; i < run.count; i++) {
+        line[run.crossline + i] = is_dead(run.trace + i) ? 1 : 0;
+      }
+    }
+  }
 }
 
 void SegyIO::read(float *dst, int startX, int endX, int startY, int endY,
@@ -344,67 +620,102 @@ void SegyIO::read(float *dst, int startX, int endX, int startY, int endY,
   if (startX >= endX || startY >= endY || startZ >= endZ) {
     throw std::runtime_error("Index 'end' must large than 'start'");
   }
-  if (startX < 0 || endX > m_metaInfo.sizeX || startY < 0 ||
+  if (startX < 0 || endX > shape(0) || startY < 0 ||
       endY > m_metaInfo.sizeY || startZ < 0 || endZ > m_metaInfo.sizeZ) {
     throw std::runtime_error("Index out of range");
   }
 
-  const char *source = m_source.data() + kTextualHeaderSize + kBinaryHeaderSize;
-  int trace_size = m_metaInfo.sizeX * sizeof(float) + kTraceHeaderSize;
+  if (m_metaInfo.data_format != 1 && m_metaInfo.data_format != 5) {
+    throw std::runtime_error("Unsuport sample format");
+  }
+
+  prepareTransform();
 
   int sizeX = endX - startX;
   int sizeY = endY - startY;
   int sizeZ = endZ - startZ;
-  int offset = startX * sizeof(float) + kTraceHeaderSize;
+
+  begin_access(choose_hint(startX, endX, startY, endY, startZ, endZ), startZ,
+               endZ);
 
   progressbar bar(sizeZ);
   auto time_start = std::chrono::high_resolution_clock::now();
 
-  // #pragma omp parallel for
-  for (int iZ = startZ; iZ < endZ; iZ++) {
-    int istart = startY;
-    float *dstline = dst + static_cast<uint64_t>(iZ - startZ) * sizeX * sizeY;
-    uint64_t trace_start = m_metaInfo.isNormalSegy
-                               ? static_cast<uint64_t>(iZ) * m_metaInfo.sizeY
-                               : m_lineInfo[iZ].trace_start;
-    const char *sourceline = source + trace_start * trace_size;
-    bool normal = true;
-    if (!m_metaInfo.isNormalSegy) {
-      normal = m_lineInfo[iZ].count == m_metaInfo.sizeY ? true : false;
-      if (!normal) {
-        int dst_crossline = m_metaInfo.min_crossline + startY;
-        while (getCrossline(sourceline + istart * trace_size,
-                            m_metaInfo.crossline_field) > dst_crossline &&
-               istart > 0) {
-          istart--;
-        }
-      }
-    }
-
-    for (int iY = startY; iY < endY; iY++) {
-      float *dsttrace = dstline + (iY - startY) * sizeX;
-      if (normal || getCrossline(sourceline + istart * trace_size,
-                                 m_metaInfo.crossline_field) ==
-                        (m_metaInfo.min_crossline + iY)) {
-        memcpy(dsttrace, sourceline + istart * trace_size + offset,
-               sizeX * sizeof(float));
-        for (int iX = 0; iX < sizeX; iX++) {
-          if (m_metaInfo.data_format == 1) {
-            dsttrace[iX] = ibm_to_ieee(dsttrace[iX], true);
-          } else if (m_metaInfo.data_format == 5) {
-            dsttrace[iX] = swap_endian(dsttrace[iX]);
+  // the resampling filter costs more than the decoding, so the resampled
+  // lines are read on many threads (the statistics are not shared)
+  int workers = 1;
+  if (!m_resampler.empty() && m_stats == nullptr) {
+    workers = m_threads > 0
+                  ? m_threads
+                  : std::max<int>(std::thread::hardware_concurrency(), 1);
+    workers = std::min(workers, sizeZ);
+  }
+  if (workers > 1) {
+    // The mapped file is shared by the workers, the other backends return
+    // a buffer that is only valid until the next read, so each line is
+    // copied out under the lock.
+    bool mapped = backend() == Backend::MMap;
+    std::atomic<int> next(startZ);
+    std::atomic<bool> failed(false);
+    std::mutex mutex;
+    std::exception_ptr error;
+    auto work = [&]() {
+      try {
+        std::vector<char> raw;
+        int iZ;
+        while (!failed && (iZ = next++) < endZ) {
+          float *out = dst + static_cast<uint64_t>(iZ - startZ) * sizeX * sizeY;
+          if (mapped) {
+            read_line(out, iZ, startX, sizeX, startY, endY, m_source.data());
           } else {
-            throw std::runtime_error("Unsuport sample format");
+            uint64_t begin, end;
+            line_bytes(iZ, begin, end);
+            raw.resize(end - begin);
+            {
+              std::lock_guard<std::mutex> lock(mutex);
+              memcpy(raw.data(), m_storage->fetch(begin, end - begin),
+                     end - begin);
+            }
+            read_line(out, iZ, startX, sizeX, startY, endY, raw.data(), begin);
+          }
+          if (m_verbose) {
+            std::lock_guard<std::mutex> lock(mutex);
+            bar.update();
           }
         }
-        istart++;
-      } else {
-        std::fill(dsttrace, dstline + (iY - startY + 1) * sizeX,
-                  m_metaInfo.fillNoValue);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        failed = true;
       }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < workers; i++) {
+      threads.emplace_back(work);
     }
-    // #pragma omp critical
-    bar.update();
+    work();
+    for (std::thread &t : threads) {
+      t.join();
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  } else {
+    // #pragma omp parallel for
+    for (int iZ = startZ; iZ < endZ; iZ++) {
+      advance_access(iZ, startZ, endZ);
+      read_line(dst + static_cast<uint64_t>(iZ - startZ) * sizeX * sizeY, iZ,
+                startX, sizeX, startY, endY);
+      // #pragma omp critical
+      if (m_verbose) {
+        bar.update();
+      }
+    }
+  }
+  if (!m_verbose) {
+    return;
   }
   fmt::print("\n");
 
@@ -417,25 +728,235 @@ void SegyIO::read(float *dst, int startX, int endX, int startY, int endY,
                  1e-9);
 }
 
+AccessHint SegyIO::choose_hint(int startX, int endX, int startY, int endY,
+                               int startZ, int endZ) {
+  if (m_accessHint != AccessHint::Auto) {
+    return m_accessHint;
+  }
+  uint64_t trace_bytes = m_metaInfo.sizeX * sizeof(float) + kTraceHeaderSize;
+  // a few samples of each trace (time slices), or a few traces of each line
+  // (crossline slices, small patches), readahead only wastes the bandwidth
+  if ((endX - startX) * sizeof(float) * 4 < trace_bytes) {
+    return AccessHint::Random;
+  }
+  if (endY - startY < m_metaInfo.sizeY &&
+      (endY - startY) * trace_bytes < kRandomSpanSize) {
+    return AccessHint::Random;
+  }
+  // don't let a large pass evict the whole page cache
+  uint64_t bytes = static_cast<uint64_t>(endZ - startZ) * m_metaInfo.sizeY *
+                   trace_bytes;
+  return bytes > kDropBehindSize ? AccessHint::Stream : AccessHint::Sequential;
+}
+
+void SegyIO::begin_access(AccessHint hint, int startZ, int endZ) {
+  m_activeHint = hint;
+  m_prefetchLines = 0;
+  // the other backends don't read through the page cache of the mapping
+  if (hint == AccessHint::Auto || !m_source.is_mapped() ||
+      backend() != Backend::MMap) {
+    return;
+  }
+  uint64_t begin, end, tmp;
+  line_bytes(startZ, begin, tmp);
+  line_bytes(endZ - 1, tmp, end);
+  if (hint == AccessHint::Random) {
+    advise_range(begin, end, MADV_RANDOM);
+  } else if (hint == AccessHint::Normal) {
+    advise_range(begin, end, MADV_NORMAL);
+  } else {
+    advise_range(begin, end, MADV_SEQUENTIAL);
+    uint64_t line_size = (end - begin) / (endZ - startZ) + 1;
+    m_prefetchLines = static_cast<int>(
+        std::min<uint64_t>(kPrefetchSize / line_size + 1, endZ - startZ));
+    line_bytes(startZ + m_prefetchLines - 1, tmp, end);
+    advise_range(begin, end, MADV_WILLNEED);
+  }
+}
+
+void SegyIO::advance_access(int iZ, int startZ, int endZ) {
+  if (m_prefetchLines == 0 || iZ == startZ) {
+    return;
+  }
+  uint64_t begin, end;
+  // keep m_prefetchLines lines ahead of the cursor in the page cache
+  if (iZ + m_prefetchLines - 1 < endZ) {
+    line_bytes(iZ + m_prefetchLines - 1, begin, end);
+    advise_range(begin, end, MADV_WILLNEED);
+  }
+  if (m_activeHint == AccessHint::Stream) {
+    line_bytes(iZ - 1, begin, end);
+    drop_range(begin, end);
+  }
+}
+
+void SegyIO::advise_range(uint64_t start, uint64_t end, int advice) {
+  static const uint64_t page = sysconf(_SC_PAGESIZE);
+  start = start / page * page;
+  end = std::min<uint64_t>(end, m_source.mapped_length());
+  if (start >= end) {
+    return;
+  }
+  // only a hint, the result is ignored
+  madvise(const_cast<char *>(m_source.data()) + start, end - start, advice);
+}
+
+void SegyIO::drop_range(uint64_t start, uint64_t end) {
+  // whole pages only, the pages on the boundaries are shared with the
+  // neighbouring lines
+  static const uint64_t page = sysconf(_SC_PAGESIZE);
+  start = (start + page - 1) / page * page;
+  end = std::min<uint64_t>(end, m_source.mapped_length()) / page * page;
+  if (start >= end) {
+    return;
+  }
+  madvise(const_cast<char *>(m_source.data()) + start, end - start,
+          MADV_DONTNEED);
+#ifdef POSIX_FADV_DONTNEED
+  // the pages are clean, this evicts them from the page cache
+  posix_fadvise(m_source.file_handle(), start, end - start,
+                POSIX_FADV_DONTNEED);
+#endif
+}
+
+void SegyIO::read_line(float *dst, int iZ, int startX, int sizeX, int startY,
+                       int endY, const char *raw, uint64_t base) {
+  int sizeY = endY - startY;
+
+  if (m_metaInfo.isNormalSegy || m_lineInfo[iZ].count == m_metaInfo.sizeY) {
+    uint64_t trace_start = m_metaInfo.isNormalSegy
+                               ? static_cast<uint64_t>(iZ) * m_metaInfo.sizeY
+                               : m_lineInfo[iZ].trace_start;
+    read_traces(dst, trace_start + startY, sizeY, startX, sizeX, raw, base);
+  } else {
+    // walk the crossline runs of this line, copy the traces in the runs
+    // and fill the gaps between them
+    const CrosslineRun *run = m_xlineRuns.data() + m_runIndex[iZ];
+    const CrosslineRun *end = m_xlineRuns.data() + m_runIndex[iZ + 1];
+    int iY = startY;
+    for (; run != end && iY < endY; run++) {
+      int run_end = run->crossline + run->count;
+      if (run_end <= iY) {
+        continue;
+      }
+      int copy_start = run->crossline > iY ? run->crossline : iY;
+      int copy_end = run_end < endY ? run_end : endY;
+      if (copy_start >= endY) {
+        break;
+      }
+      std::fill(dst + static_cast<uint64_t>(iY - startY) * sizeX,
+                dst + static_cast<uint64_t>(copy_start - startY) * sizeX,
+                m_metaInfo.fillNoValue);
+      read_traces(dst + static_cast<uint64_t>(copy_start - startY) * sizeX,
+                  run->trace + (copy_start - run->crossline),
+                  copy_end - copy_start, startX, sizeX, raw, base);
+      iY = copy_end;
+    }
+    std::fill(dst + static_cast<uint64_t>(iY - startY) * sizeX,
+              dst + static_cast<uint64_t>(sizeY) * sizeX,
+              m_metaInfo.fillNoValue);
+  }
+}
+
+void SegyIO::read_traces(float *dst, int64_t first, int64_t count,
+                         int startX, int sizeX, const char *raw,
+                         uint64_t base) {
+  uint64_t trace_bytes = m_metaInfo.sizeX * sizeof(float) + kTraceHeaderSize;
+  bool resample = !m_resampler.empty();
+  if (raw != nullptr || backend() == Backend::MMap || resample ||
+      sizeX * sizeof(float) * 4 >= trace_bytes) {
+    // the consecutive traces in one request. The resampled traces are
+    // given from their first sample, the filter needs the samples around.
+    uint64_t begin = trace_offset(first);
+    const char *src =
+        raw != nullptr
+            ? raw + (begin - base)
+            : m_storage->fetch(begin, trace_offset(first + count) - begin);
+    uint64_t skip = kTraceHeaderSize + (resample ? 0 : startX * sizeof(float));
+    for (int64_t i = 0; i < count; i++) {
+      read_one_trace(dst + i * sizeX,
+                     src + (trace_offset(first + i) - begin) + skip,
+                     first + i, startX, sizeX);
+    }
+    return;
+  }
+
+  // a few samples of each trace (e.g., time slices), only these samples are
+  // requested, straight into dst. Nothing is read for the dead traces.
+  std::vector<uint64_t> offsets(count);
+  std::vector<uint64_t> sizes(count);
+  for (int64_t i = 0; i < count; i++) {
+    int n = std::min(std::max(trace_samples(first + i) - startX, 0), sizeX);
+    n = is_dead(first + i) ? 0 : n;
+    offsets[i] =
+        trace_offset(first + i) + kTraceHeaderSize + startX * sizeof(float);
+    sizes[i] = n * sizeof(float);
+  }
+  m_storage->fetch_many(offsets.data(), sizes.data(), count,
+                        reinterpret_cast<char *>(dst), sizeX * sizeof(float));
+  for (int64_t i = 0; i < count; i++) {
+    read_one_trace(dst + i * sizeX, reinterpret_cast<char *>(dst + i * sizeX),
+                   first + i, startX, sizeX);
+  }
+}
+
+void SegyIO::read_one_trace(float *dst, const char *src, int64_t itrace,
+                            int startX, int sizeX) {
+  if (is_dead(itrace)) {
+    std::fill(dst, dst + sizeX, m_metaInfo.fillNoValue);
+    return;
+  }
+  // a variable length trace may be shorter than sizeX,
+  // the rest of it is filled with fillNoValue
+  int count = sizeX;
+  if (!m_resampler.empty()) {
+    count = resample_trace(dst, src, itrace, startX, sizeX);
+  } else {
+    if (m_metaInfo.isVariableLength) {
+      count = trace_samples(itrace) - startX;
+      count = count < 0 ? 0 : (count > sizeX ? sizeX : count);
+    }
+    if (src != reinterpret_cast<const char *>(dst)) {
+      memcpy(dst, src, count * sizeof(float));
+    }
+    if (m_metaInfo.data_format == 1) {
+      for (int iX = 0; iX < count; iX++) {
+        dst[iX] = ibm_to_ieee(dst[iX], true);
+      }
+    } else {
+      for (int iX = 0; iX < count; iX++) {
+        dst[iX] = swap_endian(dst[iX]);
+      }
+    }
+  }
+  if (m_hasTransform) {
+    transform_trace(dst, itrace, count);
+  }
+  if (m_stats != nullptr) {
+    m_stats->add(dst, count);
+  }
+  std::fill(dst + count, dst + sizeX, m_metaInfo.fillNoValue);
+}
+
 void SegyIO::read(float *dst) {
   if (!isScan) {
     scan();
   }
-  read(dst, 0, m_metaInfo.sizeX, 0, m_metaInfo.sizeY, 0, m_metaInfo.sizeZ);
+  read(dst, 0, shape(0), 0, m_metaInfo.sizeY, 0, m_metaInfo.sizeZ);
 }
 
 void SegyIO::read_inline_slice(float *dst, int iZ) {
   if (!isScan) {
     scan();
   }
-  read(dst, 0, m_metaInfo.sizeX, 0, m_metaInfo.sizeY, iZ, iZ + 1);
+  read(dst, 0, shape(0), 0, m_metaInfo.sizeY, iZ, iZ + 1);
 }
 
 void SegyIO::read_cross_slice(float *dst, int iY) {
   if (!isScan) {
     scan();
   }
-  read(dst, 0, m_metaInfo.sizeX, iY, iY + 1, 0, m_metaInfo.sizeZ);
+  read(dst, 0, shape(0), iY, iY + 1, 0, m_metaInfo.sizeZ);
 }
 
 void SegyIO::read_time_slice(float *dst, int iX) {
@@ -449,40 +970,323 @@ void SegyIO::read_trace(float *dst, int iY, int iZ) {
   if (!isScan) {
     scan();
   }
-  read(dst, 0, m_metaInfo.sizeX, iY, iY + 1, iZ, iZ + 1);
+  read(dst, 0, shape(0), iY, iY + 1, iZ, iZ + 1);
+}
+
+SampleStats SegyIO::read_with_stats(float *dst, int startX, int endX,
+                                    int startY, int endY, int startZ,
+                                    int endZ) {
+  SampleStats stats;
+  m_stats = &stats;
+  try {
+    read(dst, startX, endX, startY, endY, startZ, endZ);
+  } catch (...) {
+    m_stats = nullptr;
+    throw;
+  }
+  m_stats = nullptr;
+  return stats;
+}
+
+SampleStats SegyIO::read_with_stats(float *dst) {
+  if (!isScan) {
+    scan();
+  }
+  return read_with_stats(dst, 0, shape(0), 0, m_metaInfo.sizeY, 0,
+                         m_metaInfo.sizeZ);
 }
 
 void SegyIO::tofile(const std::string &binary_out_name) {
   if (!isScan) {
     scan();
   }
-  uint64_t need_size = static_cast<uint64_t>(m_metaInfo.sizeX) *
-                       m_metaInfo.sizeY * m_metaInfo.sizeZ * sizeof(float);
-  int fd = open(binary_out_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 00644);
-  for (int i = 0; i < int(need_size / kMaxLSeekSize) + 1; i++) {
-    uint64_t move_point = need_size > kMaxLSeekSize ? kMaxLSeekSize : need_size;
-    if (lseek(fd, move_point - 1, SEEK_END) < 0) {
-      throw std::runtime_error("create file failed");
+  prepareTransform();
+  int sizeX = shape(0);
+  uint64_t need_size = static_cast<uint64_t>(sizeX) * m_metaInfo.sizeY *
+                       m_metaInfo.sizeZ * sizeof(float);
+  // the holes read as zeros, so only a zero fill value can be left out
+  uint32_t fill_bits;
+  memcpy(&fill_bits, &m_metaInfo.fillNoValue, sizeof(fill_bits));
+  bool sparse = m_sparse && fill_bits == 0;
+  if (m_sparse && !sparse) {
+    fmt::print("[Warning]: a sparse output needs the fill value 0, write "
+               "all blocks\n");
+  }
+  int fd = create_file(binary_out_name, need_size, sparse);
+  m_skipped = 0;
+
+  // the memory map touches every page, write them by the pipeline
+  if (m_writeMode == WriteMode::Pipeline ||
+      (sparse && m_writeMode == WriteMode::MMap)) {
+    try {
+      tofile_pipeline(fd, sparse);
+    } catch (...) {
+      close(fd);
+      throw;
     }
-    if (write(fd, "", 1) < 0) {
-      throw std::runtime_error("create file failed");
+    close(fd);
+    if (m_verbose && sparse) {
+      fmt::print("{:.1f} MB of zeros are left as holes\n",
+                 m_skipped / 1024.0 / 1024.0);
     }
-    if (need_size > kMaxLSeekSize) {
-      need_size -= kMaxLSeekSize;
+    return;
+  }
+
+  if (m_writeMode == WriteMode::Stream) {
+    if (m_metaInfo.data_format != 1 && m_metaInfo.data_format != 5) {
+      close(fd);
+      throw std::runtime_error("Unsuport sample format");
     }
+    try {
+      StreamWriter writer(fd);
+      writer.setSparse(sparse);
+      // decode as many crosslines as one buffer can hold each time
+      uint64_t trace_bytes = sizeX * sizeof(float);
+      int chunk = std::max(static_cast<int>(std::min<uint64_t>(
+                               writer.capacity() / trace_bytes,
+                               static_cast<uint64_t>(m_metaInfo.sizeY))),
+                           1);
+      begin_access(
+          choose_hint(0, sizeX, 0, m_metaInfo.sizeY, 0, m_metaInfo.sizeZ), 0,
+          m_metaInfo.sizeZ);
+      progressbar bar(m_metaInfo.sizeZ);
+      for (int iZ = 0; iZ < m_metaInfo.sizeZ; iZ++) {
+        advance_access(iZ, 0, m_metaInfo.sizeZ);
+        for (int iY = 0; iY < m_metaInfo.sizeY; iY += chunk) {
+          int endY = std::min(iY + chunk, m_metaInfo.sizeY);
+          uint64_t bytes = (endY - iY) * trace_bytes;
+          read_line(reinterpret_cast<float *>(writer.reserve(bytes)), iZ, 0,
+                    sizeX, iY, endY);
+          writer.commit(bytes);
+        }
+        if (m_verbose) {
+          bar.update();
+        }
+      }
+      if (m_verbose) {
+        fmt::print("\n");
+      }
+      writer.close();
+      m_skipped = writer.skipped();
+    } catch (...) {
+      close(fd);
+      throw;
+    }
+    close(fd);
+    if (m_verbose && sparse) {
+      fmt::print("{:.1f} MB of zeros are left as holes\n",
+                 m_skipped / 1024.0 / 1024.0);
+    }
+    return;
   }
 
   std::error_code error;
   mio::mmap_sink rw_mmap = mio::make_mmap_sink(fd, error);
+  close(fd);
   if (error) {
     throw std::runtime_error("mmap fail when write data");
   }
-  close(fd);
   // or need split into serveral chunks?
   read(reinterpret_cast<float *>(rw_mmap.data()));
   rw_mmap.unmap();
 }
 
+// a few inlines in flight of the pipelined tofile()
+struct PipelineBlock {
+  int64_t index;
+  int startZ;
+  int endZ;
+  uint64_t begin; // file offset of `src`
+  const char *src;
+  std::vector<char> raw;
+  std::vector<float> data;
+};
+
+void SegyIO::tofile_pipeline(int fd, bool sparse) {
+  if (m_metaInfo.data_format != 1 && m_metaInfo.data_format != 5) {
+    throw std::runtime_error("Unsuport sample format");
+  }
+  int sizeX = shape(0);
+  int sizeY = m_metaInfo.sizeY;
+  int sizeZ = m_metaInfo.sizeZ;
+  uint64_t out_line = static_cast<uint64_t>(sizeX) * sizeY * sizeof(float);
+  uint64_t in_line =
+      (trace_offset(m_metaInfo.trace_count) - trace_offset(0)) / sizeZ + 1;
+  bool mapped = backend() == Backend::MMap;
+
+  // the blocks are recycled, so the memory is bounded by nblocks blocks.
+  // Two blocks per decoder keep them busy while the others are read and
+  // written.
+  int workers = m_threads > 0 ? m_threads
+                              : std::max<int>(
+                                    std::thread::hardware_concurrency(), 1);
+  int nblocks = 2 * workers + 2;
+  uint64_t block_line = out_line + (mapped ? 0 : in_line);
+  uint64_t block_size =
+      std::min<uint64_t>(m_memoryBudget / nblocks, kPipelineBlockSize);
+  int lines = static_cast<int>(std::max<uint64_t>(
+      std::min<uint64_t>(block_size / block_line, sizeZ), 1));
+  int64_t total = (sizeZ + lines - 1) / lines;
+  nblocks = static_cast<int>(std::min<int64_t>(nblocks, total));
+  workers = std::min(workers, nblocks);
+
+  std::vector<PipelineBlock> blocks(nblocks);
+  BoundedQueue<PipelineBlock *> free_blocks(nblocks);
+  BoundedQueue<PipelineBlock *> read_blocks(nblocks);
+  BoundedQueue<PipelineBlock *> done_blocks(nblocks);
+  for (PipelineBlock &b : blocks) {
+    b.data.resize(static_cast<uint64_t>(lines) * sizeX * sizeY);
+    free_blocks.push(&b);
+  }
+
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  auto fail = [&]() {
+    {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+    free_blocks.close();
+    read_blocks.close();
+    done_blocks.close();
+  };
+
+  // reader: the raw bytes of each block, in order. A mapped file is only
+  // faulted in, the decoders read the mapping.
+  std::thread reader([&]() {
+    try {
+      static const uint64_t page = sysconf(_SC_PAGESIZE);
+      for (int64_t k = 0; k < total; k++) {
+        PipelineBlock *b;
+        if (!free_blocks.pop(b)) {
+          return;
+        }
+        b->index = k;
+        b->startZ = static_cast<int>(k * lines);
+        b->endZ = std::min(b->startZ + lines, sizeZ);
+        uint64_t end, tmp;
+        line_bytes(b->startZ, b->begin, tmp);
+        line_bytes(b->endZ - 1, tmp, end);
+        uint64_t size = end - b->begin;
+        if (mapped) {
+          b->src = m_source.data() + b->begin;
+          advise_range(b->begin, end, MADV_WILLNEED);
+          volatile char touch = 0;
+          for (uint64_t i = 0; i < size; i += page) {
+            touch += b->src[i];
+          }
+          (void)touch;
+        } else {
+          b->raw.resize(size);
+          m_storage->fetch_many(&b->begin, &size, 1, b->raw.data(), 0);
+          b->src = b->raw.data();
+        }
+        if (!read_blocks.push(b)) {
+          return;
+        }
+      }
+      read_blocks.close();
+    } catch (...) {
+      fail();
+    }
+  });
+
+  // decoders, the last one to finish closes done_blocks
+  std::atomic<int> running(workers);
+  std::vector<std::thread> decoders;
+  for (int i = 0; i < workers; i++) {
+    decoders.emplace_back([&]() {
+      try {
+        PipelineBlock *b;
+        while (read_blocks.pop(b)) {
+          for (int iZ = b->startZ; iZ < b->endZ; iZ++) {
+            read_line(b->data.data() +
+                          static_cast<uint64_t>(iZ - b->startZ) * sizeX * sizeY,
+                      iZ, 0, sizeX, 0, sizeY, b->src, b->begin);
+          }
+          if (!done_blocks.push(b)) {
+            break;
+          }
+        }
+      } catch (...) {
+        fail();
+      }
+      if (--running == 0) {
+        done_blocks.close();
+      }
+    });
+  }
+
+  // writer: the blocks are written in order, straight from the blocks
+  // unless O_DIRECT needs the aligned buffers of StreamWriter
+  progressbar bar(sizeZ);
+  auto time_start = std::chrono::high_resolution_clock::now();
+  try {
+    std::unique_ptr<StreamWriter> writer;
+    if (m_directIO) {
+      writer.reset(new StreamWriter(fd));
+      writer->setSparse(sparse);
+      if (!writer->setDirect(true)) {
+        fmt::print("[Warning]: O_DIRECT is unsupported by this file system, "
+                   "write through the page cache\n");
+      }
+    }
+    std::map<int64_t, PipelineBlock *> ready;
+    int64_t next = 0;
+    PipelineBlock *b;
+    while (next < total && done_blocks.pop(b)) {
+      ready[b->index] = b;
+      while (!ready.empty() && ready.begin()->first == next) {
+        b = ready.begin()->second;
+        ready.erase(ready.begin());
+        const char *src = reinterpret_cast<const char *>(b->data.data());
+        uint64_t bytes = (b->endZ - b->startZ) * out_line;
+        if (writer) {
+          writer->write(src, bytes);
+        } else if (sparse) {
+          m_skipped += pwrite_sparse(fd, src, bytes, b->startZ * out_line);
+        } else {
+          pwrite_full(fd, src, bytes, b->startZ * out_line);
+        }
+        if (m_verbose) {
+          for (int iZ = b->startZ; iZ < b->endZ; iZ++) {
+            bar.update();
+          }
+        }
+        free_blocks.push(b);
+        next++;
+      }
+    }
+    if (writer && next == total) {
+      writer->close();
+      m_skipped = writer->skipped();
+    }
+  } catch (...) {
+    fail();
+  }
+  free_blocks.close();
+  reader.join();
+  for (std::thread &t : decoders) {
+    t.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+  if (!m_verbose) {
+    return;
+  }
+  fmt::print("\n");
+  auto time_end = std::chrono::high_resolution_clock::now();
+  fmt::print("need time: {}s, {} decode threads\n",
+             std::chrono::duration_cast<std::chrono::nanoseconds>(time_end -
+                                                                  time_start)
+                     .count() *
+                 1e-9,
+             workers);
+}
+
 std::string SegyIO::metaInfo() {
   if (!isScan && isReadSegy) {
     scan();
@@ -504,16 +1308,31 @@ std::string SegyIO::metaInfo() {
   std::string dformat = m_metaInfo.data_format == 1
                             ? "4-bytes IBM floating-point"
                             : "4-bytes IEEE floating-point";
+  std::string variable =
+      m_metaInfo.isVariableLength
+          ? "\nVariable length traces, n-time is the longest trace"
+          : "";
+  if (m_metaInfo.is2D) {
+    return fmt::format(
+        "2D line, shape: (n-time, n-trace) = ({}, {})\nsample interval: {}, "
+        "data format code: {}\ntrace key field: {}, first key: {}, last key: "
+        "{}\ntrace interval: {:.1f}, time start: {}\nIs regular file (no "
+        "missing traces): {}{}",
+        shape(0), m_metaInfo.sizeY, sample_interval(), dformat,
+        m_metaInfo.crossline_field, m_metaInfo.min_crossline,
+        m_metaInfo.max_crossline, Y_interval, m_metaInfo.start_time,
+        m_metaInfo.isNormalSegy, variable);
+  }
   return fmt::format(
       "shape: (n-time, n-crossline, n-inline) = ({}, {}, {})\nsample interval: "
       "{}, data format code: {}\ninline "
       "start: {}, crossline start: {}\nX interval: {:.1f}, Y interval: {:.1f}, "
       "time "
-      "start: {}\nIs regular file (no missing traces): {}",
-      m_metaInfo.sizeX, m_metaInfo.sizeY, m_metaInfo.sizeZ,
-      m_metaInfo.sample_interval, dformat, m_metaInfo.min_inline,
+      "start: {}\nIs regular file (no missing traces): {}{}",
+      shape(0), m_metaInfo.sizeY, m_metaInfo.sizeZ, sample_interval(),
+      dformat, m_metaInfo.min_inline,
       m_metaInfo.min_crossline, Y_interval, Z_interval, m_metaInfo.start_time,
-      m_metaInfo.isNormalSegy);
+      m_metaInfo.isNormalSegy, variable);
 }
 
 std::string SegyIO::textual_header() {
@@ -524,7 +1343,7 @@ std::string SegyIO::textual_header() {
   }
   const char *textual_header = nullptr;
   if (isReadSegy) {
-    textual_header = m_source.data();
+    textual_header = file_ptr(0, kTextualHeaderSize);
   } else {
     textual_header = m_sink.data();
   }
@@ -553,73 +1372,94 @@ void SegyIO::create(const std::string &segy_out_name, const float *src) {
     throw std::runtime_error(
         "'create() function only can be used for creating segy file.'");
   }
+  uint64_t trace_size = m_metaInfo.sizeX * sizeof(float) + kTraceHeaderSize;
   uint64_t need_size =
       kTextualHeaderSize + kBinaryHeaderSize +
-      static_cast<uint64_t>(m_metaInfo.sizeY) * m_metaInfo.sizeZ *
-          (m_metaInfo.sizeX * sizeof(float) + kTraceHeaderSize);
-  int fd = open(segy_out_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 00644);
-  // lseek(int, long, ), check whether need size > max number of long
-  for (int i = 0; i < int(need_size / kMaxLSeekSize) + 1; i++) {
-    uint64_t move_point = need_size > kMaxLSeekSize ? kMaxLSeekSize : need_size;
-    if (lseek(fd, move_point - 1, SEEK_END) < 0) {
-      throw std::runtime_error("create file failed");
-    }
-    if (write(fd, "", 1) < 0) {
-      throw std::runtime_error("create file failed");
-    }
-    if (need_size > kMaxLSeekSize) {
-      need_size -= kMaxLSeekSize;
+      static_cast<uint64_t>(m_metaInfo.sizeY) * m_metaInfo.sizeZ * trace_size;
+  int fd = create_file(segy_out_name, need_size);
+
+  TraceHeader trace_header{};
+  initTraceHeader(&trace_header);
+  progressbar bar(m_metaInfo.sizeZ);
+
+  if (m_writeMode != WriteMode::MMap) {
+    try {
+      StreamWriter writer(fd);
+      char header[kTextualHeaderSize + kBinaryHeaderSize];
+      write_textual_header(header, segy_out_name);
+      write_binary_header(header + kTextualHeaderSize);
+      writer.write(header, sizeof(header));
+      for (int iZ = 0; iZ < m_metaInfo.sizeZ; iZ++) {
+        for (int iY = 0; iY < m_metaInfo.sizeY; iY++) {
+          write_trace(writer.reserve(trace_size), &trace_header, src, iY, iZ);
+          writer.commit(trace_size);
+        }
+        if (m_verbose) {
+          bar.update();
+        }
+      }
+      if (m_verbose) {
+        fmt::print("\n");
+      }
+      writer.close();
+    } catch (...) {
+      close(fd);
+      throw;
     }
+    close(fd);
+    return;
   }
 
   std::error_code error;
   mio::mmap_sink rw_mmap = mio::make_mmap_sink(fd, error);
+  close(fd);
   if (error) {
     throw std::runtime_error("mmap fail when write data");
   }
-  close(fd);
 
   write_textual_header(rw_mmap.data(), segy_out_name);
   write_binary_header(rw_mmap.data() + kTextualHeaderSize);
-  TraceHeader trace_header{};
-  initTraceHeader(&trace_header);
-  char *dst = rw_mmap.data() + kTextualHeaderSize + kBinaryHeaderSize;
-  char *dstline = dst;
-
-  progressbar bar(m_metaInfo.sizeZ);
+  char *dstline = rw_mmap.data() + kTextualHeaderSize + kBinaryHeaderSize;
 
-  int trace_size = m_metaInfo.sizeX * sizeof(float) + kTraceHeaderSize;
   // #pragma omp parallel for
   for (int iZ = 0; iZ < m_metaInfo.sizeZ; iZ++) {
     for (int iY = 0; iY < m_metaInfo.sizeY; iY++) {
-      // write header
-      int64_t x = iY * m_metaInfo.Y_interval + 5200;
-      int64_t y = iZ * m_metaInfo.Z_interval + 5200;
-      write_trace_header(dstline, &trace_header, iY + m_metaInfo.min_crossline,
-                         iZ + m_metaInfo.min_inline, x, y);
-
-      // copy data
-      float *dstdata = reinterpret_cast<float *>(dstline + kTraceHeaderSize);
-      const float *srcline =
-          src + static_cast<uint64_t>(iY) * m_metaInfo.sizeX +
-          static_cast<uint64_t>(iZ) * m_metaInfo.sizeX * m_metaInfo.sizeY;
-      memcpy(dstdata, srcline, m_metaInfo.sizeX * sizeof(float));
-      for (int iX = 0; iX < m_metaInfo.sizeX; iX++) {
-        if (m_metaInfo.data_format == 1) {
-          dstdata[iX] = ieee_to_ibm(dstdata[iX], true);
-        }
-        dstdata[iX] = swap_endian(dstdata[iX]);
-      }
-
+      write_trace(dstline, &trace_header, src, iY, iZ);
       dstline += trace_size;
     }
     // #pragma omp critical
-    bar.update();
+    if (m_verbose) {
+      bar.update();
+    }
+  }
+  if (m_verbose) {
+    fmt::print("\n");
   }
-  fmt::print("\n");
   rw_mmap.unmap();
 }
 
+void SegyIO::write_trace(char *dst, TraceHeader *trace_header,
+                         const float *src, int iY, int iZ) {
+  // write header
+  int64_t x = iY * m_metaInfo.Y_interval + 5200;
+  int64_t y = iZ * m_metaInfo.Z_interval + 5200;
+  write_trace_header(dst, trace_header, iY + m_metaInfo.min_crossline,
+                     iZ + m_metaInfo.min_inline, x, y);
+
+  // copy data
+  float *dstdata = reinterpret_cast<float *>(dst + kTraceHeaderSize);
+  const float *srcline =
+      src + static_cast<uint64_t>(iY) * m_metaInfo.sizeX +
+      static_cast<uint64_t>(iZ) * m_metaInfo.sizeX * m_metaInfo.sizeY;
+  memcpy(dstdata, srcline, m_metaInfo.sizeX * sizeof(float));
+  for (int iX = 0; iX < m_metaInfo.sizeX; iX++) {
+    if (m_metaInfo.data_format == 1) {
+      dstdata[iX] = ieee_to_ibm(dstdata[iX], true);
+    }
+    dstdata[iX] = swap_endian(dstdata[iX]);
+  }
+}
+
 void SegyIO::create(const std::string &segy_out_name) {
   if (isReadSegy) {
     throw std::runtime_error("Now is read segy mode, cannot create a segy");
@@ -799,29 +1639,41 @@ void SegyIO::write_trace_header(char *dst, TraceHeader *trace_header,
 }
 
 void SegyIO::close_file() {
+  m_storage.reset();
   if (m_source.is_mapped()) {
     m_source.unmap();
   }
+  if (m_sink.is_mapped()) {
+    m_sink.unmap();
+  }
 }
 
 void SegyIO::collect(float *data, int *header) {
-  const char *source = m_source.data() + kTextualHeaderSize + kBinaryHeaderSize;
-  int32_t trace_size = m_metaInfo.sizeX * sizeof(float) + kTraceHeaderSize;
+  if (m_accessHint != AccessHint::Normal &&
+      m_accessHint != AccessHint::Random) {
+    // one pass over all traces
+    advise_range(0, m_source.mapped_length(), MADV_SEQUENTIAL);
+  }
   progressbar bar(100);
-  for (int i = 0; i < m_metaInfo.trace_count; i++) {
-    if (i % (m_metaInfo.trace_count / 100) == 0) {
+  int64_t step = m_metaInfo.trace_count / 100 > 0 ? m_metaInfo.trace_count / 100
+                                                  : 1;
+  for (int64_t i = 0; i < m_metaInfo.trace_count; i++) {
+    if (m_verbose && i % step == 0) {
       bar.update();
     }
-    get_TraceInfo(source + i * trace_size,
-                  *reinterpret_cast<TraceInfo *>(header));
-    memcpy(data, source + kTraceHeaderSize, m_metaInfo.sizeX * sizeof(float));
-    for (int j = 0; j < m_metaInfo.sizeX; j++) {
+    const char *source = trace_ptr(i);
+    get_TraceInfo(source, *reinterpret_cast<TraceInfo *>(header));
+    int count = is_dead(i) ? 0 : trace_samples(i);
+    count = count > m_metaInfo.sizeX ? m_metaInfo.sizeX : count;
+    memcpy(data, source + kTraceHeaderSize, count * sizeof(float));
+    for (int j = 0; j < count; j++) {
       if (m_metaInfo.data_format == 1) {
         data[j] = ibm_to_ieee(data[j], true);
       } else {
         data[j] = swap_endian(data[j]);
       }
     }
+    std::fill(data + count, data + m_metaInfo.sizeX, m_metaInfo.fillNoValue);
     data += m_metaInfo.sizeX;
     header += 4;
   }
@@ -838,14 +1690,46 @@ void read(const std::string &segy_name, float *dst, int iline, int xline) {
 
 void tofile(const std::string &segy_name, const std::string &out_name,
             int iline, int xline) {
+  if (file_compression(segy_name) != Compression::None) {
+    // one sequential pass, the file is decompressed on the fly
+    SegyStream stream(segy_name);
+    stream.setInlineLocation(iline);
+    stream.setCrosslineLocation(xline);
+    stream.tofile(out_name);
+    return;
+  }
   SegyIO segy_data(segy_name);
   segy_data.setInlineLocation(iline);
   segy_data.setCrosslineLocation(xline);
+  segy_data.setWriteMode(WriteMode::Pipeline);
   segy_data.scan();
   segy_data.tofile(out_name);
   segy_data.close_file();
 }
 
+void read_binary(const std::string &binary_name, float *dst, int sizeX,
+                 int sizeY, int sizeZ) {
+  int fd = open(binary_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open binary file");
+  }
+  uint64_t size =
+      static_cast<uint64_t>(sizeX) * sizeY * sizeZ * sizeof(float);
+  off_t file_size = lseek(fd, 0, SEEK_END);
+  if (file_size < 0 || static_cast<uint64_t>(file_size) != size) {
+    close(fd);
+    throw std::runtime_error(
+        "invalid shape. n-inline * n-crossline * n-time * 4 != file size");
+  }
+  try {
+    pread_sparse(fd, reinterpret_cast<char *>(dst), size, 0);
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+  close(fd);
+}
+
 void read_ignore_header(const std::string &segy_name, float *dst, int sizeX,
                         int sizeY, int sizeZ, int format) {
   SegyIO segy_data(segy_name);
@@ -869,6 +1753,19 @@ void create_by_sharing_header(const std::string &segy_name,
                               const std::string &header_segy, const float *src,
                               int sizeX, int sizeY, int sizeZ, int iline,
                               int xline) {
+  create_by_sharing_header(std::vector<std::string>{segy_name}, header_segy,
+                           std::vector<const float *>{src}, sizeX, sizeY,
+                           sizeZ, iline, xline, 1);
+}
+
+void create_by_sharing_header(const std::vector<std::string> &segy_names,
+                              const std::string &header_segy,
+                              const std::vector<const float *> &srcs,
+                              int sizeX, int sizeY, int sizeZ, int iline,
+                              int xline, int threads) {
+  if (segy_names.size() != srcs.size()) {
+    throw std::runtime_error("The numbers of outputs and arrays differ");
+  }
   SegyIO header(header_segy);
   header.setInlineLocation(iline);
   header.setCrosslineLocation(xline);
@@ -876,7 +1773,17 @@ void create_by_sharing_header(const std::string &segy_name,
   auto line_info = header.line_info();
   auto meta_info = header.get_metaInfo();
   auto trace_count = header.trace_count();
-  header.close_file();
+  // the headers are copied from the mapping scanned above
+  const char *source = header.file_data();
+  if (source == nullptr) {
+    throw std::runtime_error(
+        "Don't support sharing the header of a compressed segy file");
+  }
+
+  if (meta_info.isVariableLength) {
+    throw std::runtime_error("Don't support sharing the header of a segy file "
+                             "with variable length traces");
+  }
 
   if (meta_info.sizeY != sizeY || meta_info.sizeZ != sizeZ ||
       meta_info.sizeX != sizeX) {
@@ -886,85 +1793,105 @@ void create_by_sharing_header(const std::string &segy_name,
         sizeX));
   }
 
-  uint64_t need_size = kTextualHeaderSize + kBinaryHeaderSize +
-                       trace_count * (sizeX * sizeof(float) + kTraceHeaderSize);
-  int fd = open(segy_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 00644);
-  // lseek(int, long, ), check whether need size > max number of long
-  for (int i = 0; i < int(need_size / kMaxLSeekSize) + 1; i++) {
-    uint64_t move_point = need_size > kMaxLSeekSize ? kMaxLSeekSize : need_size;
-    if (lseek(fd, move_point - 1, SEEK_END) < 0) {
-      throw std::runtime_error("create file failed");
-    }
-    if (write(fd, "", 1) < 0) {
-      throw std::runtime_error("create file failed");
-    }
-    if (need_size > kMaxLSeekSize) {
-      need_size -= kMaxLSeekSize;
-    }
-  }
-
   std::error_code error;
-  mio::mmap_sink rw_mmap = mio::make_mmap_sink(fd, error);
-  if (error) {
-    throw std::runtime_error("mmap fail when write data");
-  }
-  close(fd);
-
-  mio::mmap_source m_source;
-  m_source.map(header_segy, error);
-  if (error) {
-    throw std::runtime_error("Cannot mmap segy file");
+  uint64_t trace_bytes = sizeX * sizeof(float) + kTraceHeaderSize;
+  uint64_t need_size =
+      kTextualHeaderSize + kBinaryHeaderSize + trace_count * trace_bytes;
+  int noutput = static_cast<int>(segy_names.size());
+  std::vector<mio::mmap_sink> outputs(noutput);
+  for (int k = 0; k < noutput; k++) {
+    int fd = create_file(segy_names[k], need_size);
+    outputs[k] = mio::make_mmap_sink(fd, error);
+    close(fd);
+    if (error) {
+      throw std::runtime_error("mmap fail when write data");
+    }
+    // copy textual header and binary header
+    memcpy(outputs[k].data(), source, kTextualHeaderSize + kBinaryHeaderSize);
   }
 
-  // copy textual header and binary header
-  std::copy(m_source.begin(),
-            m_source.begin() + kTextualHeaderSize + kBinaryHeaderSize,
-            rw_mmap.begin());
-
-  // trace header and data
-  progressbar bar(sizeZ);
-  int64_t trace_size = sizeX + kTraceHeaderSize / 4;
-  for (int iz = 0; iz < sizeZ; iz++) {
-    bar.update();
-    int64_t trace_loc = kTextualHeaderSize + kBinaryHeaderSize +
-                        trace_size * 4 * line_info[iz].trace_start;
-
-    const float *srcopy = src + iz * sizeY * sizeX;
-
-    const float *m_src =
-        reinterpret_cast<const float *>(m_source.data() + trace_loc);
-    float *m_dst = reinterpret_cast<float *>(rw_mmap.data() + trace_loc);
-
-    for (int iy = 0; iy < line_info[iz].count; iy++) {
-      int srct = iy;
-      if (line_info[iz].count != sizeY) {
-        const int *tmp = reinterpret_cast<const int *>(m_src);
-        srct = swap_endian(
-                   tmp[iy * trace_size + (meta_info.crossline_field - 1) / 4]) -
-               meta_info.min_crossline;
-      }
-
-      // copy trace header
-      std::copy(m_src + iy * trace_size,
-                m_src + iy * trace_size + kTraceHeaderSize / 4,
-                m_dst + iy * trace_size);
-
-      // copy data
-      float *t_dst = m_dst + iy * trace_size + kTraceHeaderSize / 4;
-      std::copy(srcopy + srct * sizeX, srcopy + srct * sizeX + sizeX, t_dst);
-      // convert each value to big endian and its format
-      for (int ix = 0; ix < sizeX; ix++) {
-        if (meta_info.data_format == 1) {
-          t_dst[ix] = ieee_to_ibm(t_dst[ix], true);
+  // The lines of all the outputs are shared by the workers, each line of
+  // the header segy is copied to every output while it's in the cache. The
+  // headers and samples of kShareChunk bytes of traces are copied by one
+  // memcpy, then the samples are encoded over it.
+  int64_t chunk = std::max<int64_t>(kShareChunk / trace_bytes, 1);
+  int64_t ntask = static_cast<int64_t>(sizeZ) * noutput;
+  int workers = threads > 0
+                    ? threads
+                    : std::max<int>(std::thread::hardware_concurrency(), 1);
+  workers = static_cast<int>(std::min<int64_t>(workers, ntask));
+  std::atomic<int64_t> next(0);
+  std::mutex bar_mutex;
+  std::mutex error_mutex;
+  std::exception_ptr failure;
+  std::atomic<bool> failed(false);
+  progressbar bar(ntask);
+
+  auto work = [&]() {
+    try {
+      int64_t task;
+      while (!failed && (task = next.fetch_add(1)) < ntask) {
+        int iz = static_cast<int>(task / noutput);
+        int k = static_cast<int>(task % noutput);
+        uint64_t trace_loc = kTextualHeaderSize + kBinaryHeaderSize +
+                             trace_bytes * line_info[iz].trace_start;
+        const char *m_src = source + trace_loc;
+        char *m_dst = outputs[k].data() + trace_loc;
+        const float *srcopy =
+            srcs[k] + static_cast<uint64_t>(iz) * sizeY * sizeX;
+        int64_t count = line_info[iz].count;
+        for (int64_t first = 0; first < count; first += chunk) {
+          int64_t last = std::min(first + chunk, count);
+          memcpy(m_dst + first * trace_bytes, m_src + first * trace_bytes,
+                 (last - first) * trace_bytes);
+          for (int64_t iy = first; iy < last; iy++) {
+            int64_t srct = iy;
+            if (count != sizeY) {
+              srct = swap_endian(*reinterpret_cast<const int32_t *>(
+                         m_src + iy * trace_bytes +
+                         meta_info.crossline_field - 1)) -
+                     meta_info.min_crossline;
+            }
+            if (srct < 0 || srct >= sizeY) {
+              // a bad crossline key, the trace is filled with zeros
+              memset(m_dst + iy * trace_bytes + kTraceHeaderSize, 0,
+                     sizeX * sizeof(float));
+              continue;
+            }
+            encode_samples(m_dst + iy * trace_bytes + kTraceHeaderSize,
+                           srcopy + srct * sizeX, sizeX,
+                           meta_info.data_format);
+          }
         }
-        t_dst[ix] = swap_endian(t_dst[ix]);
+        std::lock_guard<std::mutex> lock(bar_mutex);
+        bar.update();
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!failure) {
+        failure = std::current_exception();
       }
+      failed = true;
     }
+  };
+
+  std::vector<std::thread> pool;
+  for (int i = 1; i < workers; i++) {
+    pool.emplace_back(work);
+  }
+  work();
+  for (std::thread &t : pool) {
+    t.join();
   }
   fmt::print("\n");
+  if (failure) {
+    std::rethrow_exception(failure);
+  }
 
-  m_source.unmap();
-  rw_mmap.unmap();
+  header.close_file();
+  for (mio::mmap_sink &output : outputs) {
+    output.unmap();
+  }
 }
 
 } // namespace segy
@@ -0,0 +1,194 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: stats.cpp
+** @Time: 2026/10/19 23:02:45
+** @Version: 1.0
+** @Description : single pass statistics of the samples read
+*********************************************************************/
+
+#include "stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace segy {
+
+// the samples are taken in blocks of kLanes, each lane keeps its own
+// partial results
+const int kLanes = 16;
+// the float lanes only sum up this many samples, then they are added to
+// the double totals
+const size_t kFlushSize = kLanes * 256;
+
+// float bits -> unsigned key of the same order
+static inline uint32_t order_key(float v) {
+  uint32_t bits;
+  memcpy(&bits, &v, sizeof(bits));
+  return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+static inline float key_value(uint32_t key) {
+  uint32_t bits = (key & 0x80000000u) ? (key & 0x7FFFFFFFu) : ~key;
+  float v;
+  memcpy(&v, &bits, sizeof(v));
+  return v;
+}
+
+SampleStats::SampleStats()
+    : m_min(std::numeric_limits<float>::infinity()),
+      m_max(-std::numeric_limits<float>::infinity()), m_hist(kStatsBins, 0) {}
+
+void SampleStats::add(const float *data, size_t n) {
+  size_t i = 0;
+  while (i + kLanes <= n) {
+    size_t end = i + kFlushSize < n ? i + kFlushSize : n;
+    float lo[kLanes];
+    float hi[kLanes];
+    float sum[kLanes];
+    float sum2[kLanes];
+    float valid[kLanes];
+#ifdef __SSE2__
+    // The compilers don't vectorize the min and max of floats without
+    // -ffast-math (the NaN order). minps and maxps return the second
+    // operand when one is NaN, so the NaN samples are skipped.
+    const int kVectors = kLanes / 4;
+    __m128 vlo[kVectors], vhi[kVectors], vsum[kVectors], vsum2[kVectors],
+        vvalid[kVectors];
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (int k = 0; k < kVectors; k++) {
+      vlo[k] = _mm_set1_ps(m_min);
+      vhi[k] = _mm_set1_ps(m_max);
+      vsum[k] = _mm_setzero_ps();
+      vsum2[k] = _mm_setzero_ps();
+      vvalid[k] = _mm_setzero_ps();
+    }
+    for (; i + kLanes <= end; i += kLanes) {
+      for (int k = 0; k < kVectors; k++) {
+        __m128 v = _mm_loadu_ps(data + i + 4 * k);
+        __m128 ok = _mm_cmpeq_ps(v, v);
+        __m128 x = _mm_and_ps(v, ok);
+        vlo[k] = _mm_min_ps(v, vlo[k]);
+        vhi[k] = _mm_max_ps(v, vhi[k]);
+        vsum[k] = _mm_add_ps(vsum[k], x);
+        vsum2[k] = _mm_add_ps(vsum2[k], _mm_mul_ps(x, x));
+        vvalid[k] = _mm_add_ps(vvalid[k], _mm_and_ps(ok, one));
+      }
+    }
+    for (int k = 0; k < kVectors; k++) {
+      _mm_storeu_ps(lo + 4 * k, vlo[k]);
+      _mm_storeu_ps(hi + 4 * k, vhi[k]);
+      _mm_storeu_ps(sum + 4 * k, vsum[k]);
+      _mm_storeu_ps(sum2 + 4 * k, vsum2[k]);
+      _mm_storeu_ps(valid + 4 * k, vvalid[k]);
+    }
+#else
+    for (int k = 0; k < kLanes; k++) {
+      lo[k] = m_min;
+      hi[k] = m_max;
+      sum[k] = 0;
+      sum2[k] = 0;
+      valid[k] = 0;
+    }
+    for (; i + kLanes <= end; i += kLanes) {
+      for (int k = 0; k < kLanes; k++) {
+        // the comparisons with NaN are false, it's neither min nor max
+        float v = data[i + k];
+        bool ok = v == v;
+        float x = ok ? v : 0.0f;
+        lo[k] = v < lo[k] ? v : lo[k];
+        hi[k] = v > hi[k] ? v : hi[k];
+        sum[k] += x;
+        sum2[k] += x * x;
+        valid[k] += ok ? 1.0f : 0.0f;
+      }
+    }
+#endif
+    for (int k = 0; k < kLanes; k++) {
+      m_min = lo[k] < m_min ? lo[k] : m_min;
+      m_max = hi[k] > m_max ? hi[k] : m_max;
+      m_sum += sum[k];
+      m_sum2 += sum2[k];
+      m_count += static_cast<int64_t>(valid[k]);
+    }
+  }
+  for (; i < n; i++) {
+    float v = data[i];
+    if (v == v) {
+      m_min = v < m_min ? v : m_min;
+      m_max = v > m_max ? v : m_max;
+      m_sum += v;
+      m_sum2 += static_cast<double>(v) * v;
+      m_count++;
+    }
+  }
+
+  // a NaN sample adds 0 to some bin, no branch
+  uint64_t *hist = m_hist.data();
+  for (i = 0; i < n; i++) {
+    hist[order_key(data[i]) >> (32 - kStatsBinBits)] += data[i] == data[i];
+  }
+}
+
+void SampleStats::merge(const SampleStats &other) {
+  m_count += other.m_count;
+  m_min = other.m_min < m_min ? other.m_min : m_min;
+  m_max = other.m_max > m_max ? other.m_max : m_max;
+  m_sum += other.m_sum;
+  m_sum2 += other.m_sum2;
+  for (int b = 0; b < kStatsBins; b++) {
+    m_hist[b] += other.m_hist[b];
+  }
+}
+
+double SampleStats::mean() const {
+  return m_count > 0 ? m_sum / m_count : std::nan("");
+}
+
+double SampleStats::std() const {
+  if (m_count == 0) {
+    return std::nan("");
+  }
+  double mean = m_sum / m_count;
+  double var = m_sum2 / m_count - mean * mean;
+  return std::sqrt(var > 0 ? var : 0);
+}
+
+float SampleStats::percentile(double p) const {
+  if (p < 0 || p > 100) {
+    throw std::runtime_error("percentile must be in [0, 100]");
+  }
+  if (m_count == 0) {
+    return std::nanf("");
+  }
+  // as numpy's linear method, between the samples of rank floor(rank) and
+  // floor(rank) + 1, each one is placed evenly within its bin
+  double rank = p / 100 * (m_count - 1);
+  uint64_t k = static_cast<uint64_t>(rank);
+  double value[2];
+  uint64_t below = 0;
+  int b = 0;
+  for (int i = 0; i < 2; i++) {
+    uint64_t r = std::min<uint64_t>(k + i, m_count - 1);
+    while (below + m_hist[b] <= r) {
+      below += m_hist[b];
+      b++;
+    }
+    uint32_t first = static_cast<uint32_t>(b) << (32 - kStatsBinBits);
+    double lo = std::max(key_value(first), m_min);
+    double hi = std::min(
+        key_value(first | ((1u << (32 - kStatsBinBits)) - 1)), m_max);
+    value[i] = lo + (hi - lo) * (r - below + 0.5) / m_hist[b];
+  }
+  return static_cast<float>(value[0] + (rank - k) * (value[1] - value[0]));
+}
+
+} // namespace segy
@@ -0,0 +1,340 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: storage.cpp
+** @Time: 2026/10/19 16:40:12
+** @Version: 1.0
+** @Description : storage backends for reading the trace data
+*********************************************************************/
+
+#include "storage.h"
+
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+// io_uring is used through the raw system calls, so there is no dependency
+// on liburing. IORING_FEAT_RW_CUR_POS comes with IORING_OP_READ (Linux 5.6).
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(IORING_FEAT_RW_CUR_POS)
+#define CIGSEGY_IO_URING
+#endif
+#endif
+#endif
+
+namespace segy {
+
+const char *MMapStorage::fetch(uint64_t offset, uint64_t /*size*/) {
+  return m_data + offset;
+}
+
+void MMapStorage::fetch_many(const uint64_t *offsets, const uint64_t *sizes,
+                             size_t n, char *dst, uint64_t stride) {
+  for (size_t i = 0; i < n; i++) {
+    memcpy(dst + i * stride, m_data + offsets[i], sizes[i]);
+  }
+}
+
+PReadStorage::PReadStorage(const std::string &name) {
+  m_fd = open(name.c_str(), O_RDONLY);
+  if (m_fd < 0) {
+    throw std::runtime_error("Cannot open segy file");
+  }
+}
+
+PReadStorage::~PReadStorage() { close(m_fd); }
+
+char *PReadStorage::buffer(uint64_t size) {
+  if (m_buffer.size() < size) {
+    m_buffer.resize(size);
+  }
+  return m_buffer.data();
+}
+
+void PReadStorage::read_full(char *dst, uint64_t size, uint64_t offset) {
+  while (size > 0) {
+    ssize_t n = pread(m_fd, dst, size, offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      throw std::runtime_error(std::string("read file failed: ") +
+                               strerror(errno));
+    }
+    if (n == 0) {
+      throw std::runtime_error("read file failed: unexpected end of file");
+    }
+    dst += n;
+    size -= n;
+    offset += n;
+  }
+}
+
+const char *PReadStorage::fetch(uint64_t offset, uint64_t size) {
+  char *dst = buffer(size);
+  read_full(dst, size, offset);
+  return dst;
+}
+
+void PReadStorage::fetch_many(const uint64_t *offsets, const uint64_t *sizes,
+                              size_t n, char *dst, uint64_t stride) {
+  for (size_t i = 0; i < n; i++) {
+    read_full(dst + i * stride, sizes[i], offsets[i]);
+  }
+}
+
+#ifdef CIGSEGY_IO_URING
+
+// Keeps up to kIOQueueDepth reads of at most kIOBlockSize bytes in flight.
+// Short reads and failed requests are finished with pread.
+class IOUringStorage : public PReadStorage {
+public:
+  explicit IOUringStorage(const std::string &name);
+  ~IOUringStorage() override;
+  Backend backend() const override { return Backend::IOUring; }
+  const char *fetch(uint64_t offset, uint64_t size) override;
+  void fetch_many(const uint64_t *offsets, const uint64_t *sizes, size_t n,
+                  char *dst, uint64_t stride) override;
+
+private:
+  struct Job {
+    uint64_t offset;
+    uint64_t size;
+    char *dst;
+  };
+
+  int m_ring;
+  unsigned m_entries;
+  void *m_sqPtr;
+  void *m_cqPtr;
+  size_t m_sqLen;
+  size_t m_cqLen;
+  io_uring_sqe *m_sqes;
+  size_t m_sqesLen;
+  unsigned *m_sqTail;
+  unsigned *m_sqMask;
+  unsigned *m_sqArray;
+  unsigned *m_cqHead;
+  unsigned *m_cqTail;
+  unsigned *m_cqMask;
+  io_uring_cqe *m_cqes;
+  std::vector<Job> m_jobs;
+
+  void unmap();
+  // queue the read of [offset, offset + size) in pieces of kIOBlockSize
+  void add_jobs(uint64_t offset, uint64_t size, char *dst);
+  void run();
+};
+
+IOUringStorage::IOUringStorage(const std::string &name)
+    : PReadStorage(name), m_sqPtr(MAP_FAILED), m_cqPtr(MAP_FAILED),
+      m_sqes(static_cast<io_uring_sqe *>(MAP_FAILED)) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  m_ring = syscall(__NR_io_uring_setup, kIOQueueDepth, &params);
+  if (m_ring < 0) {
+    throw std::runtime_error(std::string("io_uring_setup failed: ") +
+                             strerror(errno));
+  }
+  m_entries = params.sq_entries;
+  m_sqLen = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  m_cqLen = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single) {
+    m_sqLen = m_cqLen = m_sqLen > m_cqLen ? m_sqLen : m_cqLen;
+  }
+  m_sqesLen = params.sq_entries * sizeof(io_uring_sqe);
+
+  m_sqPtr = mmap(nullptr, m_sqLen, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQ_RING);
+  m_cqPtr = single ? m_sqPtr
+                   : mmap(nullptr, m_cqLen, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, m_ring,
+                          IORING_OFF_CQ_RING);
+  m_sqes = static_cast<io_uring_sqe *>(
+      mmap(nullptr, m_sqesLen, PROT_READ | PROT_WRITE,
+           MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQES));
+  if (m_sqPtr == MAP_FAILED || m_cqPtr == MAP_FAILED ||
+      m_sqes == MAP_FAILED) {
+    unmap();
+    close(m_ring);
+    throw std::runtime_error("mmap of the io_uring rings failed");
+  }
+
+  char *sq = static_cast<char *>(m_sqPtr);
+  char *cq = static_cast<char *>(m_cqPtr);
+  m_sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  m_sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  m_sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  m_cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  m_cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  m_cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  m_cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+}
+
+IOUringStorage::~IOUringStorage() {
+  unmap();
+  close(m_ring);
+}
+
+void IOUringStorage::unmap() {
+  if (m_sqes != MAP_FAILED) {
+    munmap(m_sqes, m_sqesLen);
+  }
+  if (m_cqPtr != MAP_FAILED && m_cqPtr != m_sqPtr) {
+    munmap(m_cqPtr, m_cqLen);
+  }
+  if (m_sqPtr != MAP_FAILED) {
+    munmap(m_sqPtr, m_sqLen);
+  }
+}
+
+void IOUringStorage::add_jobs(uint64_t offset, uint64_t size, char *dst) {
+  for (uint64_t done = 0; done < size; done += kIOBlockSize) {
+    uint64_t len = size - done < kIOBlockSize ? size - done : kIOBlockSize;
+    m_jobs.push_back({offset + done, len, dst + done});
+  }
+}
+
+const char *IOUringStorage::fetch(uint64_t offset, uint64_t size) {
+  char *dst = buffer(size);
+  m_jobs.clear();
+  add_jobs(offset, size, dst);
+  run();
+  return dst;
+}
+
+void IOUringStorage::fetch_many(const uint64_t *offsets,
+                                const uint64_t *sizes, size_t n, char *dst,
+                                uint64_t stride) {
+  m_jobs.clear();
+  for (size_t i = 0; i < n; i++) {
+    add_jobs(offsets[i], sizes[i], dst + i * stride);
+  }
+  run();
+}
+
+void IOUringStorage::run() {
+  size_t next = 0;
+  size_t inflight = 0;
+  unsigned unsubmitted = 0;
+  size_t njobs = m_jobs.size();
+  // The first error is thrown once no read is in flight, the kernel writes
+  // into the buffers of the jobs until their completions are reaped, and
+  // the completions left in the ring would be taken for the next jobs.
+  std::exception_ptr error;
+  while ((!error && next < njobs) || inflight > 0) {
+    // fill the submission queue
+    unsigned tail = *m_sqTail;
+    while (!error && next < njobs && inflight < m_entries) {
+      unsigned index = tail & *m_sqMask;
+      io_uring_sqe *sqe = &m_sqes[index];
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = IORING_OP_READ;
+      sqe->fd = m_fd;
+      sqe->off = m_jobs[next].offset;
+      sqe->addr = reinterpret_cast<uint64_t>(m_jobs[next].dst);
+      // at most kIOBlockSize, see add_jobs()
+      sqe->len = static_cast<uint32_t>(m_jobs[next].size);
+      sqe->user_data = next;
+      m_sqArray[index] = index;
+      tail++;
+      next++;
+      inflight++;
+      unsubmitted++;
+    }
+    __atomic_store_n(m_sqTail, tail, __ATOMIC_RELEASE);
+
+    int ret = syscall(__NR_io_uring_enter, m_ring, unsubmitted, 1,
+                      IORING_ENTER_GETEVENTS, nullptr, 0);
+    bool failed = ret < 0 && errno != EINTR && errno != EAGAIN &&
+                  errno != EBUSY;
+    if (failed) {
+      if (!error) {
+        error = std::make_exception_ptr(std::runtime_error(
+            std::string("io_uring_enter failed: ") + strerror(errno)));
+      }
+      // the reads the kernel hasn't taken are withdrawn
+      __atomic_store_n(m_sqTail, tail - unsubmitted, __ATOMIC_RELEASE);
+      inflight -= unsubmitted;
+      unsubmitted = 0;
+    }
+    if (ret > 0) {
+      unsubmitted -= ret;
+    }
+
+    // reap the completions
+    unsigned head = *m_cqHead;
+    unsigned cq_tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+    if (failed && head == cq_tail && inflight > 0) {
+      // nothing to reap and the ring can't wait for the rest, e.g., it
+      // was closed under us
+      break;
+    }
+    for (; head != cq_tail; head++) {
+      const io_uring_cqe &cqe = m_cqes[head & *m_cqMask];
+      Job &job = m_jobs[cqe.user_data];
+      uint64_t got = cqe.res > 0 ? cqe.res : 0;
+      inflight--;
+      if (got < job.size && !error) {
+        try {
+          read_full(job.dst + got, job.size - got, job.offset + got);
+        } catch (...) {
+          error = std::current_exception();
+        }
+      }
+    }
+    __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+#endif
+
+std::unique_ptr<Storage> open_storage(Backend backend, const std::string &name,
+                                      const char *data,
+                                      std::string *fallback) {
+  std::unique_ptr<Storage> storage;
+  if (backend == Backend::Zstd) {
+    throw std::runtime_error("The Zstd backend is chosen automatically for "
+                             "zstd compressed files only");
+  }
+  if (backend == Backend::IOUring) {
+    std::string reason;
+#ifdef CIGSEGY_IO_URING
+    try {
+      storage.reset(new IOUringStorage(name));
+      return storage;
+    } catch (const std::exception &e) {
+      reason = fmt::format("io_uring is unavailable ({})", e.what());
+    }
+#else
+    reason = "io_uring is not supported by this build";
+#endif
+    if (fallback != nullptr) {
+      *fallback = reason;
+    }
+    backend = Backend::PRead;
+  }
+  if (backend == Backend::PRead) {
+    storage.reset(new PReadStorage(name));
+  } else {
+    storage.reset(new MMapStorage(data));
+  }
+  return storage;
+}
+
+} // namespace segy
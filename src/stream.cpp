@@ -0,0 +1,356 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: stream.cpp
+** @Time: 2026/10/19 19:05:48
+** @Version: 1.0
+** @Description : read segy sequentially from pipes and other streams
+*********************************************************************/
+
+#include "stream.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#include "compress.h"
+#include "output.h"
+
+namespace segy {
+
+FdSource::~FdSource() {
+  if (m_own) {
+    close(m_fd);
+  }
+}
+
+size_t FdSource::read(char *dst, size_t n) {
+  while (true) {
+    ssize_t got = ::read(m_fd, dst, n);
+    if (got >= 0) {
+      return got;
+    }
+    if (errno != EINTR) {
+      throw std::runtime_error(std::string("read stream failed: ") +
+                               strerror(errno));
+    }
+  }
+}
+
+static std::unique_ptr<ByteSource> open_source(const std::string &name) {
+  if (name == "-") {
+    return std::unique_ptr<ByteSource>(new FdSource(STDIN_FILENO, false));
+  }
+  int fd = open(name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Cannot open segy file");
+  }
+  return std::unique_ptr<ByteSource>(new FdSource(fd, true));
+}
+
+SegyStream::SegyStream(int fd)
+    : m_source(open_decompressed(
+          std::unique_ptr<ByteSource>(new FdSource(fd, false)))) {
+  readHeaders();
+}
+
+SegyStream::SegyStream(const std::string &name)
+    : m_source(open_decompressed(open_source(name))) {
+  readHeaders();
+}
+
+SegyStream::SegyStream(std::unique_ptr<ByteSource> source)
+    : m_source(open_decompressed(std::move(source))) {
+  readHeaders();
+}
+
+void SegyStream::readHeaders() {
+  m_buffer.resize(kStreamReadSize);
+  if (read_exact(m_header, sizeof(m_header)) != sizeof(m_header)) {
+    throw std::runtime_error("The stream is too short for a segy file");
+  }
+  const auto *binary_header =
+      reinterpret_cast<const BinaryHeader *>(m_header + kTextualHeaderSize);
+  m_metaInfo.data_format = swap_endian(binary_header->data_format);
+  m_metaInfo.sizeX = swap_endian(binary_header->trace_length);
+  m_metaInfo.sample_interval = swap_endian(binary_header->sample_interval);
+  int revision = static_cast<unsigned char>(binary_header->major_version);
+  m_metaInfo.isVariableLength =
+      revision >= 2 && swap_endian(binary_header->fixed_length_trace) == 0;
+  if (m_metaInfo.data_format != 1 && m_metaInfo.data_format != 5) {
+    throw std::runtime_error("Unsuport sample format");
+  }
+  m_metaInfo.inline_field = kDefaultInlineField;
+  m_metaInfo.crossline_field = kDefaultCrosslineField;
+  m_metaInfo.X_field = kDefaultXField;
+  m_metaInfo.Y_field = kDefaultYField;
+  m_metaInfo.isNormalSegy = true;
+}
+
+void SegyStream::setInlineLocation(int loc) {
+  if (loc <= 0 || loc > kTraceHeaderSize - 3) {
+    throw std::runtime_error("Invalid location (must in [1, 237])");
+  }
+  m_metaInfo.inline_field = loc;
+}
+
+void SegyStream::setCrosslineLocation(int loc) {
+  if (loc <= 0 || loc > kTraceHeaderSize - 3) {
+    throw std::runtime_error("Invalid location (must in [1, 237])");
+  }
+  m_metaInfo.crossline_field = loc;
+}
+
+void SegyStream::setFillNoValue(float noValue) {
+  m_metaInfo.fillNoValue = noValue;
+}
+
+void SegyStream::setCrosslineRange(int min_crossline, int max_crossline) {
+  if (min_crossline > max_crossline) {
+    throw std::runtime_error("min_crossline must not exceed max_crossline");
+  }
+  m_metaInfo.min_crossline = min_crossline;
+  m_metaInfo.max_crossline = max_crossline;
+  m_hasRange = true;
+}
+
+std::string SegyStream::textual_header() {
+  char out[kTextualHeaderSize + kTextualRows];
+  bool isEBCDIC = isTextInEBCDICFormat(m_header, kTextualHeaderSize);
+  for (int iRow = 0; iRow < kTextualRows; iRow++) {
+    int offset = iRow * kTextualColumns;
+    for (int iCol = 0; iCol < kTextualColumns; iCol++) {
+      char c = m_header[iCol + offset];
+      out[iCol + offset + iRow] = isEBCDIC ? getASCIIfromEBCDIC(c) : c;
+    }
+    out[(iRow + 1) * (kTextualColumns + 1) - 1] =
+        iRow < kTextualRows - 1 ? '\n' : '\0';
+  }
+  return std::string(out);
+}
+
+size_t SegyStream::read_exact(char *dst, size_t n) {
+  size_t done = 0;
+  while (done < n) {
+    if (m_pos == m_len) {
+      m_pos = 0;
+      m_len = m_source->read(m_buffer.data(), m_buffer.size());
+      if (m_len == 0) {
+        break;
+      }
+    }
+    size_t len = std::min(n - done, m_len - m_pos);
+    memcpy(dst + done, m_buffer.data() + m_pos, len);
+    m_pos += len;
+    done += len;
+  }
+  return done;
+}
+
+bool SegyStream::read_trace(std::vector<char> &trace) {
+  trace.resize(kTraceHeaderSize);
+  size_t got = read_exact(trace.data(), kTraceHeaderSize);
+  if (got == 0) {
+    return false;
+  }
+  if (got != kTraceHeaderSize) {
+    throw std::runtime_error("The stream ends in the middle of a trace");
+  }
+  size_t count = m_metaInfo.sizeX;
+  if (m_metaInfo.isVariableLength) {
+    count = static_cast<uint16_t>(swap_endian(*reinterpret_cast<int16_t *>(
+        &trace[kTSampleCountField - 1])));
+  }
+  trace.resize(kTraceHeaderSize + count * sizeof(float));
+  if (read_exact(trace.data() + kTraceHeaderSize, count * sizeof(float)) !=
+      count * sizeof(float)) {
+    throw std::runtime_error("The stream ends in the middle of a trace");
+  }
+  return true;
+}
+
+bool SegyStream::next_line(StreamLine &line) {
+  line.crosslines.clear();
+  line.data.clear();
+  if (!m_hasPending) {
+    if (m_started || !read_trace(m_pending)) {
+      return false;
+    }
+    m_started = true;
+    m_hasPending = true;
+    m_metaInfo.start_time = swap_endian(
+        *reinterpret_cast<const int16_t *>(&m_pending[kTStartTimeField - 1]));
+    m_metaInfo.scalar = swap_endian(
+        *reinterpret_cast<const int16_t *>(&m_pending[kTScalarField - 1]));
+  }
+
+  line.inline_num = field(m_pending, m_metaInfo.inline_field);
+  if (m_metaInfo.trace_count > 0 &&
+      line.inline_num <= m_metaInfo.max_inline) {
+    throw std::runtime_error(fmt::format(
+        "The traces are not sorted by inline ({} after {}), maybe the inline "
+        "location is wrong, use 'setInlineLocation(loc)' to set",
+        line.inline_num, m_metaInfo.max_inline));
+  }
+
+  int sizeX = m_metaInfo.sizeX;
+  do {
+    line.crosslines.push_back(field(m_pending, m_metaInfo.crossline_field));
+    size_t offset = line.data.size();
+    line.data.resize(offset + sizeX, m_metaInfo.fillNoValue);
+    float *dst = line.data.data() + offset;
+    int count = (m_pending.size() - kTraceHeaderSize) / sizeof(float);
+    if (count > sizeX) {
+      if (m_longTraces++ == 0) {
+        fmt::print("[Warning]: trace {} has {} samples, more than the {} of "
+                   "the binary header, the later samples are dropped.\n",
+                   m_metaInfo.trace_count, count, sizeX);
+      }
+      count = sizeX;
+    }
+    memcpy(dst, &m_pending[kTraceHeaderSize], count * sizeof(float));
+    for (int iX = 0; iX < count; iX++) {
+      if (m_metaInfo.data_format == 1) {
+        dst[iX] = ibm_to_ieee(dst[iX], true);
+      } else {
+        dst[iX] = swap_endian(dst[iX]);
+      }
+    }
+    m_metaInfo.trace_count++;
+
+    if (!read_trace(m_pending)) {
+      m_hasPending = false;
+      break;
+    }
+  } while (field(m_pending, m_metaInfo.inline_field) == line.inline_num);
+
+  if (m_metaInfo.sizeZ == 0) {
+    m_metaInfo.min_inline = line.inline_num;
+  }
+  m_metaInfo.max_inline = line.inline_num;
+  m_metaInfo.sizeZ = m_metaInfo.max_inline - m_metaInfo.min_inline + 1;
+  return true;
+}
+
+void SegyStream::tofile(const std::string &binary_out_name) {
+  // the crossline range of each written line
+  struct Layout {
+    int min_crossline;
+    int sizeY;
+    uint64_t offset;
+  };
+  std::vector<Layout> layout;
+  uint64_t trace_bytes = m_metaInfo.sizeX * sizeof(float);
+  int min_crossline = m_metaInfo.min_crossline;
+  int max_crossline = m_metaInfo.max_crossline;
+  bool has_range = m_hasRange;
+  int64_t dropped = 0;
+  uint64_t offset = 0;
+
+  int fd = create_file(binary_out_name, 0);
+  try {
+    StreamWriter writer(fd);
+    StreamLine line;
+    std::vector<float> out;
+    while (next_line(line)) {
+      // a range set by the user is kept, the traces out of it are dropped
+      if (!m_hasRange) {
+        auto range = std::minmax_element(line.crosslines.begin(),
+                                         line.crosslines.end());
+        if (!has_range) {
+          min_crossline = *range.first;
+          max_crossline = *range.second;
+          has_range = true;
+        }
+        min_crossline = std::min(min_crossline, *range.first);
+        max_crossline = std::max(max_crossline, *range.second);
+      }
+      int sizeY = max_crossline - min_crossline + 1;
+
+      // the missing inlines before this one, and this one
+      int first = layout.empty() ? line.inline_num
+                                 : m_metaInfo.min_inline + layout.size();
+      for (int il = first; il <= line.inline_num; il++) {
+        out.assign(static_cast<uint64_t>(sizeY) * m_metaInfo.sizeX,
+                   m_metaInfo.fillNoValue);
+        if (il == line.inline_num) {
+          for (size_t i = 0; i < line.crosslines.size(); i++) {
+            int iY = line.crosslines[i] - min_crossline;
+            if (iY < 0 || iY >= sizeY) {
+              dropped++;
+              continue;
+            }
+            std::copy(line.data.begin() + i * m_metaInfo.sizeX,
+                      line.data.begin() + (i + 1) * m_metaInfo.sizeX,
+                      out.begin() + static_cast<uint64_t>(iY) *
+                                        m_metaInfo.sizeX);
+          }
+        }
+        writer.write(reinterpret_cast<const char *>(out.data()),
+                     out.size() * sizeof(float));
+        layout.push_back({min_crossline, sizeY, offset});
+        offset += sizeY * trace_bytes;
+      }
+    }
+    writer.close();
+
+    if (layout.empty()) {
+      throw std::runtime_error("No trace in the stream");
+    }
+
+    // A later line extended the crossline range, move the lines to their
+    // final places. The lines only move forward, so going from the last
+    // one to the first one never overwrites a line that isn't moved yet.
+    int sizeY = max_crossline - min_crossline + 1;
+    uint64_t line_bytes = sizeY * trace_bytes;
+    bool moved = false;
+    for (int64_t i = layout.size() - 1; i >= 0; i--) {
+      const Layout &l = layout[i];
+      if (l.min_crossline == min_crossline && l.sizeY == sizeY &&
+          l.offset == i * line_bytes) {
+        continue;
+      }
+      if (!moved) {
+        fmt::print("The crossline range grew to [{}, {}], rearranging the "
+                   "written lines\n",
+                   min_crossline, max_crossline);
+        moved = true;
+      }
+      out.assign(static_cast<uint64_t>(sizeY) * m_metaInfo.sizeX,
+                 m_metaInfo.fillNoValue);
+      pread_full(fd,
+                 reinterpret_cast<char *>(
+                     out.data() + static_cast<uint64_t>(l.min_crossline -
+                                                        min_crossline) *
+                                      m_metaInfo.sizeX),
+                 l.sizeY * trace_bytes, l.offset);
+      pwrite_full(fd, reinterpret_cast<const char *>(out.data()), line_bytes,
+                  i * line_bytes);
+    }
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+  close(fd);
+  if (dropped > 0) {
+    fmt::print("[Warning]: {} traces out of the crossline range [{}, {}] "
+               "were dropped.\n",
+               dropped, min_crossline, max_crossline);
+  }
+
+  m_metaInfo.min_crossline = min_crossline;
+  m_metaInfo.max_crossline = max_crossline;
+  m_metaInfo.sizeY = max_crossline - min_crossline + 1;
+  m_metaInfo.isNormalSegy =
+      m_metaInfo.trace_count ==
+      static_cast<int64_t>(m_metaInfo.sizeY) * m_metaInfo.sizeZ;
+}
+
+} // namespace segy
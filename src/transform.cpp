@@ -0,0 +1,162 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: transform.cpp
+** @Time: 2026/10/19 23:41:20
+** @Version: 1.0
+** @Description : clipping and scaling applied while decoding
+*********************************************************************/
+
+#include "transform.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "segy.h"
+
+namespace segy {
+
+void clip_samples(float *data, int n, float clip) {
+  int i = 0;
+#ifdef __SSE2__
+  // the compilers don't vectorize the float min and max themselves. They
+  // return their second operand if one is NaN, so NaN passes through as in
+  // the scalar tail.
+  const __m128 hi = _mm_set1_ps(clip);
+  const __m128 lo = _mm_set1_ps(-clip);
+  for (; i + 4 <= n; i += 4) {
+    __m128 v = _mm_loadu_ps(data + i);
+    _mm_storeu_ps(data + i, _mm_max_ps(lo, _mm_min_ps(hi, v)));
+  }
+#endif
+  for (; i < n; i++) {
+    data[i] = data[i] > clip ? clip : (data[i] < -clip ? -clip : data[i]);
+  }
+}
+
+static inline void scale_samples(float *data, int n, float gain) {
+  for (int i = 0; i < n; i++) {
+    data[i] *= gain;
+  }
+}
+
+void agc_samples(float *data, int n, int window, std::vector<double> &scratch) {
+  // running sums of the squares, the window is cut at the ends of the trace
+  scratch.resize(n + 1);
+  scratch[0] = 0;
+  for (int i = 0; i < n; i++) {
+    scratch[i + 1] = scratch[i] + static_cast<double>(data[i]) * data[i];
+  }
+  int half = window / 2;
+  for (int i = 0; i < n; i++) {
+    int lo = std::max(i - half, 0);
+    int hi = std::min(i - half + window, n);
+    double mean2 = (scratch[hi] - scratch[lo]) / (hi - lo);
+    if (mean2 > 0) {
+      data[i] = static_cast<float>(data[i] / std::sqrt(mean2));
+    }
+  }
+}
+
+double SegyIO::zone_rms(int64_t first, int64_t last) {
+  // weighted by the window lengths, the empty windows are left out
+  const ZoneMap &map = m_zoneMap;
+  double sum2 = 0;
+  double count = 0;
+  for (int64_t itrace = first; itrace < last; itrace++) {
+    uint64_t base = static_cast<uint64_t>(itrace) * map.nwindows;
+    for (int iw = 0; iw < map.nwindows; iw++) {
+      if (map.peak(base + iw) == 0) {
+        continue;
+      }
+      int len = std::min(map.window, map.sizeX - iw * map.window);
+      double rms = map.rms[base + iw];
+      sum2 += rms * rms * len;
+      count += len;
+    }
+  }
+  return count > 0 ? std::sqrt(sum2 / count) : 0;
+}
+
+void SegyIO::prepareTransform() {
+  if (m_transformReady) {
+    return;
+  }
+  const Transform &t = m_transform;
+  if (t.scaling == Scaling::AGC && t.agc_window < 1) {
+    throw std::runtime_error("Scaling::AGC needs agc_window >= 1");
+  }
+  m_clip = 0;
+  if (t.clip_percentile > 0) {
+    m_clip = clip_estimate(t.clip_percentile);
+  } else if (t.clip > 0) {
+    m_clip = t.clip;
+  }
+
+  m_gain = t.scale;
+  m_traceGain.clear();
+  if (t.scaling == Scaling::Global && t.scale == 0) {
+    requireZoneMap();
+    double rms = zone_rms(0, m_metaInfo.trace_count);
+    m_gain = rms > 0 ? static_cast<float>(1 / rms) : 1;
+  } else if (t.scaling == Scaling::Inline) {
+    requireZoneMap();
+    m_traceGain.assign(m_metaInfo.trace_count, 1);
+    for (int iZ = 0; iZ < m_metaInfo.sizeZ; iZ++) {
+      int64_t first = static_cast<int64_t>(iZ) * m_metaInfo.sizeY;
+      int64_t last = first + m_metaInfo.sizeY;
+      if (!m_metaInfo.isNormalSegy) {
+        first = m_lineInfo[iZ].trace_start;
+        last = m_lineInfo[iZ].trace_end + 1;
+      }
+      double rms = zone_rms(first, last);
+      if (rms > 0) {
+        std::fill(m_traceGain.begin() + first, m_traceGain.begin() + last,
+                  static_cast<float>(1 / rms));
+      }
+    }
+  }
+  m_hasTransform = m_clip > 0 || t.scaling != Scaling::Off;
+  m_transformReady = true;
+}
+
+void SegyIO::transform_trace(float *dst, int64_t itrace, int count) {
+  if (m_clip > 0) {
+    clip_samples(dst, count, m_clip);
+  }
+  switch (m_transform.scaling) {
+  case Scaling::Off:
+    break;
+  case Scaling::Global:
+    scale_samples(dst, count, m_gain);
+    break;
+  case Scaling::Inline:
+    scale_samples(dst, count, m_traceGain[itrace]);
+    break;
+  case Scaling::TraceRMS: {
+    double sum2 = 0;
+    for (int i = 0; i < count; i++) {
+      sum2 += static_cast<double>(dst[i]) * dst[i];
+    }
+    if (sum2 > 0) {
+      float gain = static_cast<float>(1 / std::sqrt(sum2 / count));
+      scale_samples(dst, count, gain);
+    }
+    break;
+  }
+  case Scaling::AGC: {
+    // one per decoding thread of the pipelined tofile()
+    static thread_local std::vector<double> scratch;
+    agc_samples(dst, count, m_transform.agc_window, scratch);
+    break;
+  }
+  }
+}
+
+} // namespace segy
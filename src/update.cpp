@@ -0,0 +1,143 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: update.cpp
+** @Time: 2026/10/20 04:48:53
+** @Version: 1.0
+** @Description : update the samples of a segy file in place
+*********************************************************************/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+#include "output.h"
+#include "segy.h"
+#include "zonemap.h"
+
+namespace segy {
+
+void SegyIO::write(const float *src, int startX, int endX, int startY,
+                   int endY, int startZ, int endZ) {
+  update(src, 0, startX, endX, startY, endY, startZ, endZ);
+}
+
+void SegyIO::fill(float value, int startX, int endX, int startY, int endY,
+                  int startZ, int endZ) {
+  update(nullptr, value, startX, endX, startY, endY, startZ, endZ);
+}
+
+void SegyIO::update(const float *src, float value, int startX, int endX,
+                    int startY, int endY, int startZ, int endZ) {
+  if (!isReadSegy) {
+    throw std::runtime_error(
+        "'write()' function only used in reading segy mode");
+  }
+  if (!isScan) {
+    scan();
+  }
+  if (m_compressed) {
+    throw std::runtime_error("A compressed segy file can't be updated");
+  }
+  if (!m_resampler.empty()) {
+    throw std::runtime_error(
+        "The resampled traces can't be written, call 'setResample(0)'");
+  }
+  if (m_metaInfo.data_format != 1 && m_metaInfo.data_format != 5) {
+    throw std::runtime_error("Unsuport sample format");
+  }
+  if (startX >= endX || startY >= endY || startZ >= endZ) {
+    throw std::runtime_error("Index 'end' must large than 'start'");
+  }
+  if (startX < 0 || endX > m_metaInfo.sizeX || startY < 0 ||
+      endY > m_metaInfo.sizeY || startZ < 0 || endZ > m_metaInfo.sizeZ) {
+    throw std::runtime_error("Index out of range");
+  }
+  if (!m_sink.is_mapped()) {
+    std::error_code error;
+    m_sink.map(m_segyName, error);
+    if (error) {
+      throw std::runtime_error("Cannot open the segy file for writing");
+    }
+  }
+
+  // The samples are encoded straight into the shared writable map of the
+  // file, so the reads (of any backend) see them at once. The bytes of the
+  // headers and of the other samples are never written.
+  int sizeX = endX - startX;
+  std::vector<float> constant(src == nullptr ? sizeX : 0, value);
+  // the bytes written, synced at the end
+  uint64_t begin = m_fileSize;
+  uint64_t end = 0;
+  for (int iZ = startZ; iZ < endZ; iZ++) {
+    for (int iY = startY; iY < endY; iY++) {
+      int64_t itrace = trace_at(iZ, iY);
+      if (itrace < 0) {
+        continue;
+      }
+      // the samples past the end of a short trace are dropped
+      int count = std::min(trace_samples(itrace), endX) - startX;
+      if (count <= 0) {
+        continue;
+      }
+      const float *samples =
+          src == nullptr
+              ? constant.data()
+              : src + (static_cast<int64_t>(iZ - startZ) * (endY - startY) +
+                       (iY - startY)) *
+                          sizeX;
+      uint64_t offset =
+          trace_offset(itrace) + kTraceHeaderSize + startX * sizeof(float);
+      encode_samples(m_sink.data() + offset, samples, count,
+                     m_metaInfo.data_format);
+      begin = std::min(begin, offset);
+      end = std::max(end, offset + count * sizeof(float));
+      if (m_detectDead) {
+        update_dead(itrace);
+      }
+    }
+  }
+
+  // the zone map and what is derived from it are stale
+  m_zoneMap = ZoneMap();
+  unlink((m_segyName + kZoneMapSuffix).c_str());
+  m_transformReady = false;
+
+  // The edit is durable when this returns, and a failed write back (e.g.,
+  // no space left) is reported here instead of being lost.
+  if (begin < end) {
+    uint64_t page = sysconf(_SC_PAGESIZE);
+    begin -= begin % page;
+    if (msync(m_sink.data() + begin, end - begin, MS_SYNC) != 0) {
+      throw std::runtime_error(std::string("sync the segy file failed: ") +
+                               strerror(errno));
+    }
+  }
+}
+
+void SegyIO::update_dead(int64_t itrace) {
+  const char *src = m_sink.data() + trace_offset(itrace);
+  int16_t code = swap_endian(
+      *reinterpret_cast<const int16_t *>(src + kTTraceIDField - 1));
+  bool dead = code == 2 || is_zero(src + kTraceHeaderSize,
+                                   trace_samples(itrace) * sizeof(float));
+  if (dead == is_dead(itrace)) {
+    return;
+  }
+  if (m_deadTraces.empty()) {
+    m_deadTraces.assign((m_metaInfo.trace_count + 63) / 64, 0);
+  }
+  m_deadTraces[itrace >> 6] ^= uint64_t(1) << (itrace & 63);
+  m_deadCount += dead ? 1 : -1;
+  if (m_deadCount == 0) {
+    m_deadTraces.clear();
+  }
+}
+
+} // namespace segy
@@ -0,0 +1,191 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: writer.cpp
+** @Time: 2026/10/20 04:05:26
+** @Version: 1.0
+** @Description : create a segy file one block of inlines at a time
+*********************************************************************/
+
+#include "writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include "output.h"
+
+namespace segy {
+
+SegyWriter::SegyWriter(int sizeX, int sizeY, int sizeZ)
+    : m_segy(sizeX, sizeY, sizeZ) {
+  if (sizeX < 1 || sizeY < 1 || sizeZ < 1) {
+    throw std::runtime_error("The shape must be positive");
+  }
+}
+
+SegyWriter::~SegyWriter() {
+  if (m_fd >= 0) {
+    try {
+      close();
+    } catch (const std::exception &e) {
+      fmt::print("[Warning]: {}, when closing the segy file.\n", e.what());
+    }
+  }
+}
+
+void SegyWriter::check_closed() {
+  if (m_fd >= 0) {
+    throw std::runtime_error("The geometry is set before 'open()'");
+  }
+}
+
+void SegyWriter::setSampleInterval(int interval) {
+  check_closed();
+  m_segy.setSampleInterval(interval);
+}
+
+void SegyWriter::setDataFormatCode(int format) {
+  check_closed();
+  m_segy.setDataFormatCode(format);
+}
+
+void SegyWriter::setStartTime(int start_time) {
+  check_closed();
+  m_segy.setStartTime(start_time);
+}
+
+void SegyWriter::setXInterval(float dz) {
+  check_closed();
+  m_segy.setXInterval(dz);
+}
+
+void SegyWriter::setYInterval(float dy) {
+  check_closed();
+  m_segy.setYInterval(dy);
+}
+
+void SegyWriter::setMinInline(int in) {
+  check_closed();
+  m_segy.setMinInline(in);
+}
+
+void SegyWriter::setMinCrossline(int cross) {
+  check_closed();
+  m_segy.setMinCrossline(cross);
+}
+
+void SegyWriter::open(const std::string &segy_out_name) {
+  if (m_fd >= 0) {
+    throw std::runtime_error("The segy file is already opened");
+  }
+  const MetaInfo &meta = m_segy.m_metaInfo;
+  uint64_t trace_size = meta.sizeX * sizeof(float) + kTraceHeaderSize;
+  uint64_t need_size =
+      kTextualHeaderSize + kBinaryHeaderSize +
+      static_cast<uint64_t>(meta.sizeY) * meta.sizeZ * trace_size;
+  int fd = create_file(segy_out_name, need_size);
+  try {
+    char header[kTextualHeaderSize + kBinaryHeaderSize];
+    m_segy.write_textual_header(header, segy_out_name);
+    m_segy.write_binary_header(header + kTextualHeaderSize);
+    pwrite_full(fd, header, sizeof(header), 0);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  m_segy.initTraceHeader(&m_traceHeader);
+  m_written.assign(meta.sizeZ, 0);
+  m_count = 0;
+  m_fd = fd;
+}
+
+void SegyWriter::encode_line(char *dst, const float *src, int iZ,
+                             TraceHeader &header) {
+  const MetaInfo &meta = m_segy.m_metaInfo;
+  uint64_t trace_size = meta.sizeX * sizeof(float) + kTraceHeaderSize;
+  for (int iY = 0; iY < meta.sizeY; iY++) {
+    // the same headers as SegyIO::create()
+    int64_t x = iY * meta.Y_interval + 5200;
+    int64_t y = iZ * meta.Z_interval + 5200;
+    m_segy.write_trace_header(dst, &header, iY + meta.min_crossline,
+                              iZ + meta.min_inline, x, y);
+    if (src != nullptr) {
+      encode_samples(dst + kTraceHeaderSize,
+                     src + static_cast<uint64_t>(iY) * meta.sizeX, meta.sizeX,
+                     meta.data_format);
+    } else {
+      memset(dst + kTraceHeaderSize, 0, meta.sizeX * sizeof(float));
+    }
+    dst += trace_size;
+  }
+}
+
+void SegyWriter::write_lines(const float *src, int startZ, int count) {
+  if (m_fd < 0) {
+    throw std::runtime_error("The segy file is not opened, call 'open()'");
+  }
+  const MetaInfo &meta = m_segy.m_metaInfo;
+  if (count < 1 || startZ < 0 || startZ + count > meta.sizeZ) {
+    throw std::runtime_error("Index out of range");
+  }
+  // the lines are encoded into a buffer of up to kStreamBufferSize bytes,
+  // then written by one pwrite. Each thread has its own buffer and header.
+  uint64_t trace_size = meta.sizeX * sizeof(float) + kTraceHeaderSize;
+  uint64_t line_size = meta.sizeY * trace_size;
+  uint64_t line_samples = static_cast<uint64_t>(meta.sizeY) * meta.sizeX;
+  int step = static_cast<int>(std::max<uint64_t>(
+      std::min<uint64_t>(kStreamBufferSize / line_size, count), 1));
+  std::vector<char> buffer(step * line_size);
+  TraceHeader header = m_traceHeader;
+  for (int i = 0; i < count; i += step) {
+    int n = std::min(step, count - i);
+    for (int k = 0; k < n; k++) {
+      encode_line(buffer.data() + k * line_size,
+                  src == nullptr ? nullptr : src + (i + k) * line_samples,
+                  startZ + i + k, header);
+    }
+    pwrite_full(m_fd, buffer.data(), n * line_size,
+                kTextualHeaderSize + kBinaryHeaderSize +
+                    (startZ + i) * line_size);
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (int iZ = startZ; iZ < startZ + count; iZ++) {
+    m_count += m_written[iZ] == 0;
+    m_written[iZ] = 1;
+  }
+}
+
+int SegyWriter::lines_written() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_count;
+}
+
+void SegyWriter::close() {
+  if (m_fd < 0) {
+    return;
+  }
+  int missing = m_segy.m_metaInfo.sizeZ - lines_written();
+  if (missing > 0) {
+    fmt::print("[Warning]: {} inlines were not written, they are zeros.\n",
+               missing);
+    for (int iZ = 0; iZ < m_segy.m_metaInfo.sizeZ; iZ++) {
+      if (m_written[iZ] == 0) {
+        write_lines(nullptr, iZ, 1);
+      }
+    }
+  }
+  int fd = m_fd;
+  m_fd = -1;
+  if (::close(fd) != 0) {
+    throw std::runtime_error("close the segy file failed");
+  }
+}
+
+} // namespace segy
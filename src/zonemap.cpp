@@ -0,0 +1,329 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: zonemap.cpp
+** @Time: 2026/10/19 22:14:06
+** @Version: 1.0
+** @Description : per-trace amplitude zone map, persisted as .zmap
+*********************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <mutex>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#include "output.h"
+#include "segy.h"
+
+namespace segy {
+
+const char kZoneMapMagic[8] = {'C', 'I', 'G', 'Z', 'M', 'A', 'P', '2'};
+
+// the header of a .zmap file, followed by the min, max and rms arrays in
+// the byte order of the machine that wrote it
+struct ZoneMapHeader {
+  char magic[8];
+  int64_t trace_count;
+  uint64_t file_size;
+  int64_t mtime;
+  int32_t sizeX;
+  int32_t window;
+  int32_t nwindows;
+  int32_t detect_dead;
+};
+
+bool load_zonemap(const std::string &name, ZoneMap &map) {
+  int fd = open(name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  ZoneMapHeader header;
+  bool ok = fstat(fd, &st) == 0 &&
+            static_cast<uint64_t>(st.st_size) >= sizeof(header);
+  try {
+    if (ok) {
+      pread_full(fd, reinterpret_cast<char *>(&header), sizeof(header), 0);
+      uint64_t n = static_cast<uint64_t>(header.trace_count) * header.nwindows;
+      ok = memcmp(header.magic, kZoneMapMagic, sizeof(kZoneMapMagic)) == 0 &&
+           header.trace_count >= 0 && header.nwindows >= 0 &&
+           static_cast<uint64_t>(st.st_size) ==
+               sizeof(header) + 3 * n * sizeof(float);
+      if (ok) {
+        map.trace_count = header.trace_count;
+        map.sizeX = header.sizeX;
+        map.window = header.window;
+        map.nwindows = header.nwindows;
+        map.detect_dead = header.detect_dead != 0;
+        map.file_size = header.file_size;
+        map.mtime = header.mtime;
+        map.min.resize(n);
+        map.max.resize(n);
+        map.rms.resize(n);
+        uint64_t offset = sizeof(header);
+        for (std::vector<float> *v : {&map.min, &map.max, &map.rms}) {
+          pread_full(fd, reinterpret_cast<char *>(v->data()),
+                     n * sizeof(float), offset);
+          offset += n * sizeof(float);
+        }
+      }
+    }
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+  close(fd);
+  return ok;
+}
+
+void save_zonemap(const std::string &name, const ZoneMap &map) {
+  ZoneMapHeader header{};
+  memcpy(header.magic, kZoneMapMagic, sizeof(kZoneMapMagic));
+  header.trace_count = map.trace_count;
+  header.file_size = map.file_size;
+  header.mtime = map.mtime;
+  header.sizeX = map.sizeX;
+  header.window = map.window;
+  header.nwindows = map.nwindows;
+  header.detect_dead = map.detect_dead ? 1 : 0;
+
+  // written aside and renamed, a reader never sees a partial map
+  std::string tmp = name + ".tmp";
+  uint64_t n = map.min.size();
+  int fd = create_file(tmp, sizeof(header) + 3 * n * sizeof(float));
+  try {
+    pwrite_full(fd, reinterpret_cast<const char *>(&header), sizeof(header),
+                0);
+    uint64_t offset = sizeof(header);
+    for (const std::vector<float> *v : {&map.min, &map.max, &map.rms}) {
+      pwrite_full(fd, reinterpret_cast<const char *>(v->data()),
+                  n * sizeof(float), offset);
+      offset += n * sizeof(float);
+    }
+  } catch (...) {
+    close(fd);
+    unlink(tmp.c_str());
+    throw;
+  }
+  close(fd);
+  if (rename(tmp.c_str(), name.c_str()) != 0) {
+    unlink(tmp.c_str());
+    throw std::runtime_error("Cannot save the zone map: " + name);
+  }
+}
+
+void SegyIO::buildZoneMap(int window) {
+  if (!isReadSegy) {
+    throw std::runtime_error(
+        "'buildZoneMap()' function only used in reading segy mode.");
+  }
+  if (m_metaInfo.data_format != 1 && m_metaInfo.data_format != 5) {
+    throw std::runtime_error("Unsuport sample format");
+  }
+  // the dead traces are found by scan()
+  if (m_detectDead && !isScan) {
+    scan();
+  }
+  int sizeX = m_metaInfo.sizeX;
+  int64_t trace_count = m_metaInfo.trace_count;
+  if (window <= 0 || window > sizeX) {
+    window = sizeX;
+  }
+  int nwindows = (sizeX + window - 1) / window;
+
+  struct stat st;
+  int64_t mtime = stat(m_segyName.c_str(), &st) == 0 ? st.st_mtime : 0;
+  std::string name = m_segyName + kZoneMapSuffix;
+  ZoneMap map;
+  if (load_zonemap(name, map) && map.trace_count == trace_count &&
+      map.sizeX == sizeX && map.window == window &&
+      map.detect_dead == m_detectDead && map.file_size == m_fileSize &&
+      map.mtime == mtime) {
+    m_zoneMap = std::move(map);
+    return;
+  }
+
+  auto time_start = std::chrono::high_resolution_clock::now();
+  map.trace_count = trace_count;
+  map.sizeX = sizeX;
+  map.window = window;
+  map.nwindows = nwindows;
+  map.detect_dead = m_detectDead;
+  map.file_size = m_fileSize;
+  map.mtime = mtime;
+  uint64_t n = static_cast<uint64_t>(trace_count) * nwindows;
+  map.min.assign(n, 0);
+  map.max.assign(n, 0);
+  map.rms.assign(n, 0);
+
+  // The workers take chunks of consecutive traces. The mapped file is
+  // shared by all of them, the other backends return a buffer that is only
+  // valid until the next read, so the chunk is copied out under a lock.
+  bool mapped = backend() == Backend::MMap;
+  int workers = m_threads > 0
+                    ? m_threads
+                    : std::max<int>(std::thread::hardware_concurrency(), 1);
+  workers = static_cast<int>(std::min<int64_t>(
+      workers, (trace_count + kZoneMapChunk - 1) / kZoneMapChunk));
+  std::atomic<int64_t> next(0);
+  std::mutex fetch_mutex;
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  std::atomic<bool> failed(false);
+
+  auto work = [&]() {
+    try {
+      std::vector<char> raw;
+      std::vector<float> trace(sizeX);
+      int64_t first;
+      while (!failed &&
+             (first = next.fetch_add(kZoneMapChunk)) < trace_count) {
+        int64_t last = std::min(first + kZoneMapChunk, trace_count);
+        uint64_t begin = trace_offset(first);
+        const char *src = m_source.data() + begin;
+        if (!mapped) {
+          uint64_t size = trace_offset(last) - begin;
+          raw.resize(size);
+          std::lock_guard<std::mutex> lock(fetch_mutex);
+          memcpy(raw.data(), m_storage->fetch(begin, size), size);
+          src = raw.data();
+        }
+        for (int64_t itrace = first; itrace < last; itrace++) {
+          int count = is_dead(itrace) ? 0 : trace_samples(itrace);
+          count = count > sizeX ? sizeX : count;
+          memcpy(trace.data(),
+                 src + (trace_offset(itrace) - begin) + kTraceHeaderSize,
+                 count * sizeof(float));
+          if (m_metaInfo.data_format == 1) {
+            for (int iX = 0; iX < count; iX++) {
+              trace[iX] = ibm_to_ieee(trace[iX], true);
+            }
+          } else {
+            for (int iX = 0; iX < count; iX++) {
+              trace[iX] = swap_endian(trace[iX]);
+            }
+          }
+          uint64_t base = static_cast<uint64_t>(itrace) * nwindows;
+          for (int iw = 0; iw * window < count; iw++) {
+            const float *w = trace.data() + iw * window;
+            int len = std::min(window, count - iw * window);
+            float lo = w[0];
+            float hi = w[0];
+            double sum2 = 0;
+            for (int i = 0; i < len; i++) {
+              lo = w[i] < lo ? w[i] : lo;
+              hi = w[i] > hi ? w[i] : hi;
+              sum2 += static_cast<double>(w[i]) * w[i];
+            }
+            map.min[base + iw] = lo;
+            map.max[base + iw] = hi;
+            map.rms[base + iw] = std::sqrt(sum2 / len);
+          }
+        }
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+      failed = true;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < workers; i++) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (std::thread &t : threads) {
+    t.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+
+  try {
+    save_zonemap(name, map);
+  } catch (const std::exception &e) {
+    fmt::print("[Warning]: {}, the zone map is only kept in memory.\n",
+               e.what());
+  }
+  m_zoneMap = std::move(map);
+
+  if (m_verbose) {
+    auto time_end = std::chrono::high_resolution_clock::now();
+    fmt::print("zone map of {} traces ({} windows each), need time: {}s\n",
+               trace_count, nwindows,
+               std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   time_end - time_start)
+                       .count() *
+                   1e-9);
+  }
+}
+
+void SegyIO::requireZoneMap() {
+  // built with the default window unless one was built before, rebuilt
+  // when the traces changed (e.g., set_size()) or the dead traces did
+  if (m_zoneMap.empty() || m_zoneMap.trace_count != m_metaInfo.trace_count ||
+      m_zoneMap.sizeX != m_metaInfo.sizeX ||
+      m_zoneMap.detect_dead != m_detectDead) {
+    buildZoneMap(m_zoneMap.window);
+  }
+}
+
+std::vector<int64_t> SegyIO::traces_exceeding(float threshold, int startX,
+                                              int endX) {
+  requireZoneMap();
+  if (startX < 0 || endX > m_zoneMap.sizeX || startX >= endX) {
+    throw std::runtime_error("Index out of range");
+  }
+  int first = startX / m_zoneMap.window;
+  int last = (endX - 1) / m_zoneMap.window;
+  std::vector<int64_t> out;
+  for (int64_t itrace = 0; itrace < m_zoneMap.trace_count; itrace++) {
+    uint64_t base = static_cast<uint64_t>(itrace) * m_zoneMap.nwindows;
+    for (int iw = first; iw <= last; iw++) {
+      if (m_zoneMap.peak(base + iw) > threshold) {
+        out.push_back(itrace);
+        break;
+      }
+    }
+  }
+  return out;
+}
+
+float SegyIO::clip_estimate(float percentile) {
+  if (percentile < 0 || percentile > 100) {
+    throw std::runtime_error("percentile must be in [0, 100]");
+  }
+  requireZoneMap();
+  // the empty windows (dead traces) would pull the estimate to zero
+  std::vector<float> peaks;
+  peaks.reserve(m_zoneMap.min.size());
+  for (size_t i = 0; i < m_zoneMap.min.size(); i++) {
+    float peak = m_zoneMap.peak(i);
+    if (peak > 0) {
+      peaks.push_back(peak);
+    }
+  }
+  if (peaks.empty()) {
+    return 0;
+  }
+  size_t k = static_cast<size_t>(percentile / 100 * (peaks.size() - 1) + 0.5);
+  std::nth_element(peaks.begin(), peaks.begin() + k, peaks.end());
+  return peaks[k];
+}
+
+} // namespace segy
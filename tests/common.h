@@ -0,0 +1,274 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: common.h
+** @Time: 2026/10/20 06:10:12
+** @Version: 1.0
+** @Description : checks and synthetic segy files for the tests
+*********************************************************************/
+
+#ifndef CIG_TEST_COMMON_H
+#define CIG_TEST_COMMON_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "segy.h"
+
+namespace test {
+
+static int failures = 0;
+
+// a failed check is reported and counted, the test goes on
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      std::printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);              \
+      test::failures++;                                                        \
+    }                                                                          \
+  } while (0)
+
+// passes if `expr` throws std::exception
+#define CHECK_THROWS(expr)                                                     \
+  do {                                                                         \
+    bool thrown = false;                                                       \
+    try {                                                                      \
+      expr;                                                                    \
+    } catch (const std::exception &) {                                         \
+      thrown = true;                                                           \
+    }                                                                          \
+    if (!thrown) {                                                             \
+      std::printf("FAIL %s:%d: %s doesn't throw\n", __FILE__, __LINE__,       \
+                  #expr);                                                      \
+      test::failures++;                                                        \
+    }                                                                          \
+  } while (0)
+
+inline int report() {
+  std::printf(failures ? "%d checks failed\n" : "all checks passed\n",
+              failures);
+  return failures ? 1 : 0;
+}
+
+// the sample x of trace (z, y) of the synthetic volumes, exact in both
+// IEEE and IBM floats
+inline float value(int z, int y, int x) { return z * 10000 + y * 100 + x; }
+
+// the keys and samples of one trace of a synthetic file
+struct Trace {
+  int inline_num = 0;
+  int crossline_num = 0;
+  int32_t x = 0;
+  int32_t y = 0;
+  int16_t code = 1; // trace identification code, 2 is dead
+  std::vector<float> samples;
+};
+
+// the binary header of a synthetic file
+struct Layout {
+  int sizeX = 0;
+  int format = 5;         // 1: IBM, 5: IEEE
+  int interval = 2000;    // us
+  int16_t start_time = 0; // ms
+  bool variable = false;  // rev 2, traces of their own lengths
+};
+
+template <typename T> inline void put(char *dst, T v) {
+  v = segy::swap_endian(v);
+  memcpy(dst, &v, sizeof(T));
+}
+
+template <typename T> inline void put_le(std::string &out, T v, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    out += static_cast<char>((static_cast<uint64_t>(v) >> (8 * i)) & 0xFF);
+  }
+}
+
+// IBM float of `v`, written independently of the library
+inline uint32_t to_ibm(float v) {
+  if (v == 0) {
+    return 0;
+  }
+  uint32_t sign = v < 0 ? 0x80000000u : 0;
+  double m = std::fabs(v);
+  int e = 64;
+  while (m >= 1) {
+    m /= 16;
+    e++;
+  }
+  while (m < 1.0 / 16) {
+    m *= 16;
+    e--;
+  }
+  return sign | (static_cast<uint32_t>(e) << 24) |
+         static_cast<uint32_t>(m * (1 << 24));
+}
+
+inline std::string encode_trace(const Trace &t, const Layout &layout) {
+  std::string out(segy::kTraceHeaderSize + t.samples.size() * 4, '\0');
+  char *h = &out[0];
+  put<int32_t>(h + segy::kDefaultInlineField - 1, t.inline_num);
+  put<int32_t>(h + segy::kDefaultCrosslineField - 1, t.crossline_num);
+  put<int32_t>(h + segy::kDefaultCDPField - 1, t.crossline_num);
+  put<int32_t>(h + segy::kDefaultXField - 1, t.x);
+  put<int32_t>(h + segy::kDefaultYField - 1, t.y);
+  put<int16_t>(h + segy::kTScalarField - 1, -100);
+  put<int16_t>(h + segy::kTTraceIDField - 1, t.code);
+  put<int16_t>(h + segy::kTStartTimeField - 1, layout.start_time);
+  put<int16_t>(h + segy::kTSampleCountField - 1,
+               static_cast<int16_t>(t.samples.size()));
+  put<int16_t>(h + segy::kTSampleIntervalField - 1,
+               static_cast<int16_t>(layout.interval));
+  char *s = h + segy::kTraceHeaderSize;
+  for (size_t i = 0; i < t.samples.size(); i++) {
+    if (layout.format == 1) {
+      put<uint32_t>(s + 4 * i, to_ibm(t.samples[i]));
+    } else {
+      put<float>(s + 4 * i, t.samples[i]);
+    }
+  }
+  return out;
+}
+
+inline std::string encode_headers(const Layout &layout) {
+  std::string out(segy::kTextualHeaderSize + segy::kBinaryHeaderSize, '\0');
+  memset(&out[0], 0x40, segy::kTextualHeaderSize); // EBCDIC spaces
+  char *b = &out[segy::kTextualHeaderSize];
+  put<int16_t>(b + segy::kBSampleIntervalField - 1,
+               static_cast<int16_t>(layout.interval));
+  put<int16_t>(b + segy::kBSampleCountField - 1,
+               static_cast<int16_t>(layout.sizeX));
+  put<int16_t>(b + segy::kBSampleFormatField - 1,
+               static_cast<int16_t>(layout.format));
+  if (layout.variable) {
+    b[segy::kBRevisionField - 1] = 2;
+    put<int16_t>(b + segy::kBFixedLengthField - 1, 0);
+  }
+  return out;
+}
+
+inline void write_file(const std::string &name, const std::string &bytes) {
+  std::ofstream f(name, std::ios::binary | std::ios::trunc);
+  f.write(bytes.data(), bytes.size());
+}
+
+inline std::string read_file(const std::string &name) {
+  std::ifstream f(name, std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(f)),
+                     std::istreambuf_iterator<char>());
+}
+
+inline void write_segy(const std::string &name, const Layout &layout,
+                       const std::vector<Trace> &traces) {
+  std::string bytes = encode_headers(layout);
+  for (const Trace &t : traces) {
+    bytes += encode_trace(t, layout);
+  }
+  write_file(name, bytes);
+}
+
+// a zstd frame of raw blocks, with its content size
+inline std::string zstd_frame(const std::string &data) {
+  std::string out;
+  put_le(out, 0xFD2FB528u, 4);
+  out += static_cast<char>(0xE0); // single segment, 8 bytes content size
+  put_le(out, data.size(), 8);
+  size_t pos = 0;
+  do {
+    size_t n = std::min<size_t>(data.size() - pos, 128 * 1024);
+    bool last = pos + n == data.size();
+    put_le(out, (n << 3) | (last ? 1 : 0), 3);
+    out += data.substr(pos, n);
+    pos += n;
+  } while (pos < data.size());
+  return out;
+}
+
+// nz inlines (from 100) x ny crosslines (from 10) x nx samples of value(),
+// without the traces in `missing`. The trace (z, y) of a variable length
+// file has nx - (z + y) % 3 samples. X and Y are 25 m apart.
+inline std::vector<Trace>
+volume_traces(int nz, int ny, int nx,
+              const std::set<std::pair<int, int>> &missing = {},
+              bool variable = false) {
+  std::vector<Trace> traces;
+  for (int z = 0; z < nz; z++) {
+    for (int y = 0; y < ny; y++) {
+      if (missing.count(std::make_pair(z, y))) {
+        continue;
+      }
+      Trace t;
+      t.inline_num = 100 + z;
+      t.crossline_num = 10 + y;
+      t.x = 1000 + y * 2500;
+      t.y = 2000 + z * 2500;
+      int n = nx - (variable ? (z + y) % 3 : 0);
+      for (int x = 0; x < n; x++) {
+        t.samples.push_back(value(z, y, x));
+      }
+      traces.push_back(t);
+    }
+  }
+  return traces;
+}
+
+inline void write_volume(const std::string &name, int nz, int ny, int nx,
+                         const std::set<std::pair<int, int>> &missing = {},
+                         bool variable = false, int format = 5) {
+  Layout layout;
+  layout.sizeX = nx;
+  layout.format = format;
+  layout.variable = variable;
+  write_segy(name, layout, volume_traces(nz, ny, nx, missing, variable));
+}
+
+// what SegyIO::read() returns for a volume of write_volume()
+inline std::vector<float>
+expected_volume(int nz, int ny, int nx,
+                const std::set<std::pair<int, int>> &missing, bool variable,
+                float fill) {
+  std::vector<float> out(static_cast<size_t>(nz) * ny * nx, fill);
+  for (int z = 0; z < nz; z++) {
+    for (int y = 0; y < ny; y++) {
+      if (missing.count(std::make_pair(z, y))) {
+        continue;
+      }
+      int n = nx - (variable ? (z + y) % 3 : 0);
+      for (int x = 0; x < n; x++) {
+        out[(static_cast<size_t>(z) * ny + y) * nx + x] = value(z, y, x);
+      }
+    }
+  }
+  return out;
+}
+
+// scan() and read() the whole volume
+inline std::vector<float> read_all(segy::SegyIO &segy) {
+  segy.scan();
+  std::vector<float> out(static_cast<size_t>(segy.shape(0)) * segy.shape(1) *
+                         segy.shape(2));
+  segy.read(out.data());
+  return out;
+}
+
+inline std::vector<float> read_floats(const std::string &name) {
+  std::string bytes = read_file(name);
+  std::vector<float> out(bytes.size() / sizeof(float));
+  memcpy(out.data(), bytes.data(), out.size() * sizeof(float));
+  return out;
+}
+
+} // namespace test
+
+#endif
@@ -0,0 +1,62 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_access_hint.cpp
+** @Time: 2026/10/20 08:15:53
+** @Version: 1.0
+** @Description : the access hints don't change what is read
+*********************************************************************/
+
+#include <algorithm>
+
+#include "common.h"
+
+namespace {
+
+const float kFill = -1;
+
+void test_hints(const std::string &name, const std::vector<float> &expected,
+                int nz, int ny, int nx) {
+  for (auto hint : {segy::AccessHint::Auto, segy::AccessHint::Normal,
+                    segy::AccessHint::Sequential, segy::AccessHint::Stream,
+                    segy::AccessHint::Random}) {
+    segy::SegyIO segy(name);
+    segy.setVerbose(false);
+    segy.setFillNoValue(kFill);
+    segy.setAccessHint(hint);
+    CHECK(test::read_all(segy) == expected);
+
+    std::vector<float> slice(ny * nz);
+    segy.read_time_slice(slice.data(), 2);
+    bool ok = true;
+    for (int i = 0; i < ny * nz; i++) {
+      ok &= slice[i] == expected[i * nx + 2];
+    }
+    CHECK(ok);
+
+    // the lines read again after Stream dropped them from the page cache
+    std::vector<float> line(ny * nx);
+    segy.read(line.data(), 0, nx, 0, ny, nz - 1, nz);
+    CHECK(std::equal(line.begin(), line.end(),
+                     expected.end() - line.size()));
+
+    segy.tofile("out.bin");
+    CHECK(test::read_floats("out.bin") == expected);
+  }
+}
+
+} // namespace
+
+int main() {
+  std::set<std::pair<int, int>> missing = {{1, 0}, {1, 1}, {2, 7}, {4, 3}};
+  test::write_volume("irregular.sgy", 12, 8, 9, missing);
+  test_hints("irregular.sgy",
+             test::expected_volume(12, 8, 9, missing, false, kFill), 12, 8,
+             9);
+  test::write_volume("variable.sgy", 12, 5, 9, {}, true);
+  test_hints("variable.sgy", test::expected_volume(12, 5, 9, {}, true, kFill),
+             12, 5, 9);
+  return test::report();
+}
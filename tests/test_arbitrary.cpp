@@ -0,0 +1,140 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_arbitrary.cpp
+** @Time: 2026/10/20 11:58:40
+** @Version: 1.0
+** @Description : traces along an arbitrary line
+*********************************************************************/
+
+#include <algorithm>
+
+#include "common.h"
+
+namespace {
+
+bool same(float a, float b) { return (a != a && b != b) || a == b; }
+
+void test_file(const std::string &name, segy::Backend backend) {
+  segy::SegyIO segy(name, backend);
+  segy.setVerbose(false);
+  segy.setFillNoValue(NAN);
+  std::vector<float> v = test::read_all(segy);
+  int nx = segy.shape(0), ny = segy.shape(1), nz = segy.shape(2);
+  auto at = [&](int z, int y, int x) {
+    return v[(static_cast<size_t>(z) * ny + y) * nx + x];
+  };
+  segy::MetaInfo meta = segy.get_metaInfo();
+  double i0 = meta.min_inline, x0 = meta.min_crossline;
+
+  // along inline 2, then a diagonal to inline 5
+  double points[] = {i0 + 2, x0, i0 + 2, x0 + ny - 1, i0 + 5, x0 + ny - 1};
+  std::vector<double> path = segy.arbitrary_path(points, 3);
+  CHECK(path.size() == 2 * static_cast<size_t>(ny - 1 + 3 + 1));
+  CHECK(path.front() == points[0] && path.back() == points[5]);
+  size_t np = path.size() / 2;
+  std::vector<float> line(np * nx);
+  segy.read_arbitrary_line(line.data(), path.data(), np,
+                           segy::Interpolation::Nearest, 0, nx);
+  bool ok = true;
+  for (size_t p = 0; p < np; p++) {
+    int z = static_cast<int>(path[2 * p] - i0);
+    int y = static_cast<int>(path[2 * p + 1] - x0);
+    for (int x = 0; x < nx; x++) {
+      ok &= same(line[p * nx + x], at(z, y, x));
+    }
+  }
+  CHECK(ok);
+
+  // the path along a whole inline is the inline
+  double inline2[] = {i0 + 2, x0, i0 + 2, x0 + ny - 1};
+  path = segy.arbitrary_path(inline2, 2);
+  std::vector<float> slice(ny * nx);
+  segy.read_arbitrary_line(slice.data(), path.data(), ny,
+                           segy::Interpolation::Bilinear, 0, nx);
+  CHECK(path.size() == 2 * static_cast<size_t>(ny) &&
+        std::equal(slice.begin(), slice.end(), v.begin() + 2 * ny * nx, same));
+
+  // half way between the inlines, a quarter between the crosslines, the
+  // missing traces are left out of the weights
+  std::vector<double> mid;
+  for (int z = 0; z + 1 < nz; z++) {
+    mid.push_back(i0 + z + 0.5);
+    mid.push_back(x0 + 1.25);
+  }
+  std::vector<float> bilinear(mid.size() / 2 * 3);
+  segy.read_arbitrary_line(bilinear.data(), mid.data(), mid.size() / 2,
+                           segy::Interpolation::Bilinear, 2, 5);
+  ok = true;
+  for (int z = 0; z + 1 < nz; z++) {
+    double weights[4] = {0.375, 0.375, 0.125, 0.125};
+    int zz[4] = {z, z + 1, z, z + 1};
+    int yy[4] = {1, 1, 2, 2};
+    for (int x = 0; x < 3; x++) {
+      double sum = 0, weight = 0;
+      for (int k = 0; k < 4; k++) {
+        float e = at(zz[k], yy[k], x + 2);
+        if (e == e) {
+          sum += weights[k] * e;
+          weight += weights[k];
+        }
+      }
+      float g = bilinear[z * 3 + x];
+      ok &= weight == 0 ? g != g
+                        : std::fabs(g - sum / weight) <
+                              1e-3 * std::fabs(sum / weight) + 1e-3;
+    }
+  }
+  CHECK(ok);
+
+  // the world coordinates of the traces give the same line
+  path = segy.arbitrary_path(points, 3);
+  std::vector<double> xy;
+  for (size_t p = 0; p < np; p++) {
+    double X, Y;
+    segy.line_to_coord(path[2 * p], path[2 * p + 1], X, Y);
+    xy.push_back(X);
+    xy.push_back(Y);
+  }
+  std::vector<double> world = segy.arbitrary_path(xy.data(), np, true, 2);
+  CHECK(world.size() == path.size());
+  std::vector<float> again(np * nx);
+  segy.read_arbitrary_line(again.data(), world.data(), np,
+                           segy::Interpolation::Nearest, 0, nx);
+  CHECK(std::equal(again.begin(), again.end(), line.begin(), same));
+
+  // outside of the survey
+  double outside[] = {i0 - 5, x0 - 5, i0 + nz + 3, x0 + 1};
+  std::vector<float> out(2 * nx, 0);
+  segy.read_arbitrary_line(out.data(), outside, 2,
+                           segy::Interpolation::Bilinear, 0, nx);
+  ok = true;
+  for (float f : out) {
+    ok &= f != f;
+  }
+  CHECK(ok);
+
+  CHECK_THROWS(segy.arbitrary_path(points, 0));
+  CHECK_THROWS(segy.arbitrary_path(points, 3, false, 0));
+  CHECK_THROWS(segy.read_arbitrary_line(out.data(), points, 1,
+                                        segy::Interpolation::Nearest, 0,
+                                        nx + 1));
+  CHECK_THROWS(segy.read_arbitrary_line(out.data(), points, 1,
+                                        segy::Interpolation::Nearest, 3, 3));
+}
+
+} // namespace
+
+int main() {
+  test::write_volume("regular.sgy", 8, 7, 11);
+  std::set<std::pair<int, int>> missing = {{0, 1}, {2, 2}, {3, 6}, {5, 0}};
+  test::write_volume("irregular.sgy", 8, 7, 11, missing, false, 1);
+  for (const char *name : {"regular.sgy", "irregular.sgy"}) {
+    for (segy::Backend backend : {segy::Backend::MMap, segy::Backend::PRead}) {
+      test_file(name, backend);
+    }
+  }
+  return test::report();
+}
@@ -0,0 +1,136 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_backend.cpp
+** @Time: 2026/10/20 08:27:10
+** @Version: 1.0
+** @Description : the pread and io_uring backends read as the mmap one
+*********************************************************************/
+
+#include "common.h"
+#include "storage.h"
+
+namespace {
+
+const float kFill = -1;
+const segy::Backend kBackends[] = {segy::Backend::PRead,
+                                   segy::Backend::IOUring};
+
+// ranges larger than kIOBlockSize at unaligned offsets, and small ones
+void test_storage() {
+  std::string bytes(5 * segy::kIOBlockSize + 123, 0);
+  for (size_t i = 0; i < bytes.size(); i++) {
+    bytes[i] = static_cast<char>(i * 2654435761u >> 13);
+  }
+  test::write_file("bytes.bin", bytes);
+
+  for (segy::Backend backend : kBackends) {
+    std::string fallback;
+    std::unique_ptr<segy::Storage> storage =
+        segy::open_storage(backend, "bytes.bin", bytes.data(), &fallback);
+    // io_uring may be unavailable here, then pread is used and told
+    CHECK(storage->backend() == backend ||
+          (storage->backend() == segy::Backend::PRead && !fallback.empty()));
+
+    uint64_t size = 3 * segy::kIOBlockSize + 17;
+    const char *p = storage->fetch(1001, size);
+    CHECK(memcmp(p, bytes.data() + 1001, size) == 0);
+    p = storage->fetch(7, 5);
+    CHECK(memcmp(p, bytes.data() + 7, 5) == 0);
+
+    uint64_t offsets[] = {3, 2 * segy::kIOBlockSize - 5, 100, 0};
+    uint64_t sizes[] = {3 * segy::kIOBlockSize + 1, 10, 0,
+                        segy::kIOBlockSize};
+    uint64_t stride = 3 * segy::kIOBlockSize + 8;
+    std::string dst(4 * stride, 'x');
+    storage->fetch_many(offsets, sizes, 4, &dst[0], stride);
+    bool ok = true;
+    for (int i = 0; i < 4; i++) {
+      ok &= memcmp(&dst[i * stride], bytes.data() + offsets[i], sizes[i]) == 0;
+      ok &= dst[i * stride + sizes[i]] == 'x';
+    }
+    CHECK(ok);
+
+    // a range past the end among many blocks in flight, the next reads
+    // don't see the completions of the failed one
+    std::vector<uint64_t> many(64), lengths(64, segy::kIOBlockSize);
+    for (size_t i = 0; i < many.size(); i++) {
+      many[i] = (i * 7 % 4) * segy::kIOBlockSize + i;
+    }
+    many[5] = bytes.size() - 10;
+    std::string wide(many.size() * segy::kIOBlockSize, 'x');
+    CHECK_THROWS(storage->fetch_many(many.data(), lengths.data(), many.size(),
+                                     &wide[0], segy::kIOBlockSize));
+    for (int k = 0; k < 3; k++) {
+      p = storage->fetch(1001, size);
+      CHECK(memcmp(p, bytes.data() + 1001, size) == 0);
+    }
+  }
+  CHECK_THROWS(segy::open_storage(segy::Backend::Zstd, "bytes.bin",
+                                  bytes.data()));
+}
+
+// reads of each backend equal the ones of mmap
+void test_segy(const std::string &name, bool line2d) {
+  segy::SegyIO mapped(name);
+  mapped.setVerbose(false);
+  mapped.setFillNoValue(kFill);
+  if (line2d) {
+    mapped.setLine2D();
+  }
+  std::vector<float> expected = test::read_all(mapped);
+  int nx = mapped.shape(0), ny = mapped.shape(1), nz = mapped.shape(2);
+  std::vector<float> slice(ny * nz);
+  mapped.read_time_slice(slice.data(), 1);
+
+  for (segy::Backend backend : kBackends) {
+    segy::SegyIO segy(name, backend);
+    segy.setVerbose(false);
+    segy.setFillNoValue(kFill);
+    if (line2d) {
+      segy.setLine2D();
+    }
+    CHECK(test::read_all(segy) == expected);
+    CHECK(segy.backend() != segy::Backend::MMap);
+
+    std::vector<float> got(slice.size());
+    segy.read_time_slice(got.data(), 1);
+    CHECK(got == slice);
+
+    // the last samples of two crosslines of the last line
+    std::vector<float> patch(2 * 3);
+    segy.read(patch.data(), nx - 3, nx, 2, 4, nz - 1, nz);
+    bool ok = true;
+    for (int y = 0; y < 2; y++) {
+      for (int x = 0; x < 3; x++) {
+        ok &= patch[y * 3 + x] ==
+              expected[((nz - 1) * ny + y + 2) * nx + nx - 3 + x];
+      }
+    }
+    CHECK(ok);
+
+    segy.setWriteMode(segy::WriteMode::Stream);
+    segy.tofile("out.bin");
+    CHECK(test::read_floats("out.bin") == expected);
+  }
+}
+
+} // namespace
+
+int main() {
+  test_storage();
+
+  std::set<std::pair<int, int>> missing = {{1, 0}, {2, 7}, {3, 3}, {3, 4}};
+  test::write_volume("irregular.sgy", 12, 8, 9, missing);
+  test_segy("irregular.sgy", false);
+  test::write_volume("variable.sgy", 12, 5, 9, {}, true);
+  test_segy("variable.sgy", false);
+  test::write_volume("line.sgy", 1, 300, 6, {{0, 3}, {0, 100}}, false, 1);
+  test_segy("line.sgy", true);
+  // lines of 2 MB, read in several blocks
+  test::write_volume("long.sgy", 3, 40, 13000);
+  test_segy("long.sgy", false);
+  return test::report();
+}
@@ -0,0 +1,158 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_compressed.cpp
+** @Time: 2026/10/20 09:03:26
+** @Version: 1.0
+** @Description : reads of gzip and zstd compressed segy
+*********************************************************************/
+
+#include "common.h"
+#include "compress.h"
+
+namespace {
+
+const float kFill = -1;
+
+uint32_t crc32(const std::string &data) {
+  uint32_t crc = 0xFFFFFFFFu;
+  for (unsigned char c : data) {
+    crc ^= c;
+    for (int k = 0; k < 8; k++) {
+      crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+// a gzip member of stored (uncompressed) deflate blocks
+std::string gzip_member(const std::string &data) {
+  std::string out("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+  size_t pos = 0;
+  do {
+    size_t n = std::min<size_t>(data.size() - pos, 65535);
+    out += static_cast<char>(pos + n == data.size() ? 1 : 0);
+    test::put_le(out, n, 2);
+    test::put_le(out, ~n & 0xFFFF, 2);
+    out += data.substr(pos, n);
+    pos += n;
+  } while (pos < data.size());
+  test::put_le(out, crc32(data), 4);
+  test::put_le(out, data.size() & 0xFFFFFFFFu, 4);
+  return out;
+}
+
+// frames of `chunk` bytes, with the seek table of the zstd seekable format
+std::string zstd_frames(const std::string &data, size_t chunk, bool table) {
+  std::string out, entries;
+  int count = 0;
+  for (size_t pos = 0; pos < data.size(); pos += chunk) {
+    std::string part = data.substr(pos, chunk);
+    std::string frame = test::zstd_frame(part);
+    test::put_le(entries, frame.size(), 4);
+    test::put_le(entries, part.size(), 4);
+    out += frame;
+    count++;
+  }
+  if (table) {
+    test::put_le(out, 0x184D2A5Eu, 4);
+    test::put_le(out, entries.size() + 9, 4);
+    out += entries;
+    test::put_le(out, count, 4);
+    out += '\0';
+    test::put_le(out, 0x8F92EAB1u, 4);
+  }
+  return out;
+}
+
+void test_file(const std::string &base, int nz, int ny, int nx) {
+  std::string plain = test::read_file(base + ".sgy");
+  std::string names[] = {base + ".sgy.gz", base + ".1.zst", base + ".m.zst",
+                         base + ".s.zst"};
+  // two gzip members, one zstd frame, frames cut in the middle of traces
+  // without and with a seek table
+  test::write_file(names[0], gzip_member(plain.substr(0, plain.size() / 3)) +
+                                 gzip_member(plain.substr(plain.size() / 3)));
+  test::write_file(names[1], test::zstd_frame(plain));
+  test::write_file(names[2], zstd_frames(plain, 5000, false));
+  test::write_file(names[3], zstd_frames(plain, 5000, true));
+
+  segy::SegyIO ref(base + ".sgy");
+  ref.setVerbose(false);
+  ref.setFillNoValue(kFill);
+  std::vector<float> expected = test::read_all(ref);
+  std::vector<float> slice(ny * nz);
+  ref.read_time_slice(slice.data(), 1);
+  // what segy::tofile() writes, with the default fill value
+  segy::SegyIO plain_segy(base + ".sgy");
+  plain_segy.setVerbose(false);
+  plain_segy.tofile("plain.bin");
+  std::string plain_out = test::read_file("plain.bin");
+
+  CHECK(segy::file_compression(names[0]) == segy::Compression::Gzip);
+#ifdef CIGSEGY_ZLIB
+  segy::tofile(names[0], "out.bin");
+  CHECK(test::read_file("out.bin") == plain_out);
+#else
+  CHECK_THROWS(segy::tofile(names[0], "out.bin"));
+#endif
+  // gzip can't be read at random
+  CHECK_THROWS(segy::SegyIO segy(names[0]));
+
+  for (int i = 1; i < 4; i++) {
+    CHECK(segy::file_compression(names[i]) == segy::Compression::Zstd);
+#ifdef CIGSEGY_ZSTD
+    segy::tofile(names[i], "out.bin");
+    CHECK(test::read_file("out.bin") == plain_out);
+
+    segy::SegyIO segy(names[i]);
+    segy.setVerbose(false);
+    segy.setFillNoValue(kFill);
+    CHECK(test::read_all(segy) == expected);
+    CHECK(segy.backend() == segy::Backend::Zstd);
+    CHECK(segy.file_data() == nullptr);
+    CHECK(segy.textual_header() == ref.textual_header());
+
+    std::vector<float> got(slice.size());
+    segy.read_time_slice(got.data(), 1);
+    CHECK(got == slice);
+
+    std::vector<float> patch(2 * 3 * nx);
+    segy.read(patch.data(), 0, nx, 1, 3, 2, 5);
+    bool ok = true;
+    for (int z = 0; z < 3; z++) {
+      for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < nx; x++) {
+          ok &= patch[(z * 2 + y) * nx + x] ==
+                expected[((z + 2) * ny + y + 1) * nx + x];
+        }
+      }
+    }
+    CHECK(ok);
+
+    int64_t count = ref.trace_count();
+    std::vector<float> data(count * nx), ref_data(count * nx);
+    std::vector<int> header(count * 4), ref_header(count * 4);
+    segy.collect(data.data(), header.data());
+    ref.collect(ref_data.data(), ref_header.data());
+    CHECK(data == ref_data && header == ref_header);
+#else
+    CHECK_THROWS(segy::SegyIO segy(names[i]));
+#endif
+  }
+}
+
+} // namespace
+
+int main() {
+  test::write_volume("regular.sgy", 12, 7, 11);
+  test_file("regular", 12, 7, 11);
+  std::set<std::pair<int, int>> missing = {{1, 0}, {2, 7}, {3, 3}, {4, 7}};
+  test::write_volume("irregular.sgy", 12, 8, 9, missing);
+  test_file("irregular", 12, 8, 9);
+  test::write_volume("variable.sgy", 12, 5, 9, {}, true);
+  test_file("variable", 12, 5, 9);
+  return test::report();
+}
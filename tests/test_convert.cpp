@@ -0,0 +1,230 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_convert.cpp
+** @Time: 2026/10/20 11:12:08
+** @Version: 1.0
+** @Description : float16, bfloat16 and quantized reads
+*********************************************************************/
+
+#include <algorithm>
+
+#include "common.h"
+#include "convert.h"
+
+namespace {
+
+bool is_nan(float v) { return v != v; }
+
+float half_to_float(uint16_t h) {
+  int e = (h >> 10) & 0x1F, m = h & 0x3FF;
+  float v;
+  if (e == 0) {
+    v = std::ldexp(static_cast<float>(m), -24);
+  } else if (e == 31) {
+    v = m ? NAN : INFINITY;
+  } else {
+    v = std::ldexp(static_cast<float>(m | 0x400), e - 25);
+  }
+  return (h & 0x8000) ? -v : v;
+}
+
+std::vector<float> samples() {
+  std::vector<float> src;
+  for (int i = 0; i < 4000; i++) {
+    double m = static_cast<double>((i * 2654435761u) % 100000) - 50000;
+    src.push_back(static_cast<float>(std::ldexp(m, i % 40 - 30) / 7));
+  }
+  src[10] = NAN;
+  src[11] = INFINITY;
+  src[12] = -0.0f;
+  src[13] = 65504;  // the largest half
+  src[14] = 65520;  // rounds to infinity
+  src[15] = 1e-8f;  // subnormal half
+  src[16] = 2.98e-8f;
+  return src;
+}
+
+// every conversion from two offsets, the SIMD body and the tail
+void test_convert_samples() {
+  std::vector<float> src = samples();
+  for (int off : {0, 3}) {
+    size_t n = src.size() - off;
+    const float *s = src.data() + off;
+
+    // float16: the nearest half
+    std::vector<uint16_t> h(n);
+    segy::convert_samples(s, h.data(), n, segy::DType::Float16);
+    bool ok = true;
+    for (size_t i = 0; i < n; i++) {
+      float x = s[i], y = half_to_float(h[i]);
+      if (is_nan(x)) {
+        ok &= is_nan(y);
+      } else if (std::fabs(x) >= 65520) {
+        ok &= std::isinf(y) && (x < 0) == (y < 0);
+      } else {
+        float up = half_to_float(h[i] + 1), down = half_to_float(h[i] - 1);
+        ok &= std::fabs(y - x) <= std::fabs(up - x);
+        ok &= (h[i] & 0x7FFF) == 0 || std::fabs(y - x) <= std::fabs(down - x);
+      }
+    }
+    CHECK(ok);
+
+    // bfloat16: within half a unit of 8 bits of mantissa
+    std::vector<uint16_t> b(n);
+    segy::convert_samples(s, b.data(), n, segy::DType::BFloat16);
+    ok = true;
+    for (size_t i = 0; i < n; i++) {
+      uint32_t bits = static_cast<uint32_t>(b[i]) << 16;
+      float y;
+      memcpy(&y, &bits, 4);
+      float x = s[i];
+      if (is_nan(x) || std::isinf(x)) {
+        ok &= is_nan(x) ? is_nan(y) : y == x;
+      } else {
+        ok &= std::fabs(y - x) <= std::fabs(x) / 256 + 1e-38f;
+      }
+    }
+    CHECK(ok);
+
+    // quantized, saturated, NaN as 0
+    for (segy::DType dtype : {segy::DType::Int16, segy::DType::Int8}) {
+      float top = segy::dtype_max(dtype), scale = 3.7f;
+      std::vector<int16_t> q16(n);
+      std::vector<int8_t> q8(n);
+      bool wide = dtype == segy::DType::Int16;
+      segy::convert_samples(s, wide ? static_cast<void *>(q16.data())
+                                    : static_cast<void *>(q8.data()),
+                            n, dtype, scale);
+      ok = true;
+      for (size_t i = 0; i < n; i++) {
+        int got = wide ? q16[i] : q8[i];
+        float e = is_nan(s[i]) ? 0
+                               : std::nearbyint(std::min(
+                                     std::max(s[i] / scale, -top), top));
+        ok &= std::fabs(got - e) <= 1;
+        ok &= is_nan(s[i]) || std::fabs(s[i] / scale) >= top - 1 ||
+              std::fabs(got * scale - s[i]) <= scale / 2 * 1.001f;
+      }
+      CHECK(ok);
+    }
+  }
+}
+
+void test_read_as(const std::string &name) {
+  segy::SegyIO segy(name);
+  segy.setVerbose(false);
+  segy.setFillNoValue(NAN);
+  std::vector<float> raw = test::read_all(segy);
+  int nx = segy.shape(0), ny = segy.shape(1), nz = segy.shape(2);
+  size_t n = raw.size();
+
+  std::vector<float> f(n);
+  CHECK(segy.read_as(f.data(), segy::DType::Float32).empty());
+  CHECK(memcmp(f.data(), raw.data(), n * sizeof(float)) == 0);
+
+  std::vector<uint16_t> h(n), expected_h(n);
+  segy.read_as(h.data(), segy::DType::Float16);
+  segy::convert_samples(raw.data(), expected_h.data(), n,
+                        segy::DType::Float16);
+  CHECK(h == expected_h);
+
+  // one scale for the volume: the peak maps to 127
+  std::vector<int8_t> q(n);
+  std::vector<float> scales = segy.read_as(q.data(), segy::DType::Int8);
+  float peak = 0;
+  for (float v : raw) {
+    peak = is_nan(v) ? peak : std::max(peak, std::fabs(v));
+  }
+  CHECK(scales.size() == 1 && std::fabs(scales[0] - peak / 127) < 1e-6 * peak);
+  bool ok = true;
+  for (size_t i = 0; i < n; i++) {
+    ok &= is_nan(raw[i]) ? q[i] == 0
+                         : std::fabs(q[i] * scales[0] - raw[i]) <=
+                               scales[0] / 2 * 1.001f;
+  }
+  CHECK(ok);
+
+  // a patch takes the scale of the volume
+  std::vector<int8_t> patch(2 * 3 * 4);
+  CHECK(segy.read_as(patch.data(), segy::DType::Int8, false, 2, 6, 1, 4, 3,
+                     5) == scales);
+  ok = true;
+  for (int z = 0; z < 2; z++) {
+    for (int y = 0; y < 3; y++) {
+      for (int x = 0; x < 4; x++) {
+        ok &= patch[(z * 3 + y) * 4 + x] ==
+              q[((z + 3) * ny + y + 1) * nx + x + 2];
+      }
+    }
+  }
+  CHECK(ok);
+
+  // one scale per inline
+  std::vector<int16_t> q16(n);
+  scales = segy.read_as(q16.data(), segy::DType::Int16, true);
+  CHECK(static_cast<int>(scales.size()) == nz);
+  ok = true;
+  size_t line = static_cast<size_t>(nx) * ny;
+  for (int z = 0; z < nz; z++) {
+    float top = 0;
+    for (size_t i = z * line; i < (z + 1) * line; i++) {
+      top = is_nan(raw[i]) ? top : std::max(top, std::fabs(raw[i]));
+      ok &= is_nan(raw[i]) || std::fabs(q16[i] * scales[z] - raw[i]) <=
+                                  scales[z] / 2 * 1.001f;
+    }
+    ok &= std::fabs(scales[z] - top / 32767) <= 1e-6 * top;
+  }
+  CHECK(ok);
+
+  // the scale of the transformed samples
+  segy::Transform t;
+  t.scaling = segy::Scaling::Global;
+  t.scale = 0.5f;
+  t.clip = 40000;
+  segy.setTransform(t);
+  std::vector<float> transformed = test::read_all(segy);
+  scales = segy.read_as(q.data(), segy::DType::Int8);
+  peak = 0;
+  for (float v : transformed) {
+    peak = is_nan(v) ? peak : std::max(peak, std::fabs(v));
+  }
+  CHECK(std::fabs(scales[0] - peak / 127) < 1e-6 * peak);
+  // trace RMS has no scale for the volume, only per inline
+  t.scaling = segy::Scaling::TraceRMS;
+  segy.setTransform(t);
+  CHECK_THROWS(segy.read_as(q.data(), segy::DType::Int8));
+  CHECK(segy.read_as(q.data(), segy::DType::Int8, true).size() ==
+        static_cast<size_t>(nz));
+}
+
+// the per inline scales leave the fill values out
+void test_fill_scales() {
+  std::set<std::pair<int, int>> missing = {{1, 0}, {1, 4}, {3, 2}};
+  test::write_volume("fill.sgy", 5, 6, 7, missing);
+  std::vector<float> scales[2];
+  int i = 0;
+  for (float fill : {0.f, -1e6f}) {
+    segy::SegyIO segy("fill.sgy");
+    segy.setVerbose(false);
+    segy.setFillNoValue(fill);
+    std::vector<int8_t> q(7 * 6 * 5);
+    scales[i++] = segy.read_as(q.data(), segy::DType::Int8, true);
+  }
+  CHECK(scales[0] == scales[1]);
+}
+
+} // namespace
+
+int main() {
+  test_convert_samples();
+  std::set<std::pair<int, int>> missing = {{1, 0}, {2, 7}, {3, 3}, {4, 7}};
+  test::write_volume("irregular.sgy", 12, 8, 9, missing);
+  test_read_as("irregular.sgy");
+  test::write_volume("regular.sgy", 12, 7, 11);
+  test_read_as("regular.sgy");
+  test_fill_scales();
+  return test::report();
+}
@@ -0,0 +1,115 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_crossline_runs.cpp
+** @Time: 2026/10/20 07:30:48
+** @Version: 1.0
+** @Description : reads of irregular lines through their crossline runs
+*********************************************************************/
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "common.h"
+
+namespace {
+
+const float kFill = -7;
+
+// random patches read from `segy` equal the same part of `expected`
+bool check_patches(segy::SegyIO &segy, const std::vector<float> &expected,
+                   int nz, int ny, int nx, int count) {
+  srand(1);
+  bool ok = true;
+  for (int i = 0; i < count; i++) {
+    int z0 = rand() % nz, z1 = z0 + 1 + rand() % (nz - z0);
+    int y0 = rand() % ny, y1 = y0 + 1 + rand() % (ny - y0);
+    int x0 = rand() % nx, x1 = x0 + 1 + rand() % (nx - x0);
+    std::vector<float> patch((z1 - z0) * (y1 - y0) * (x1 - x0));
+    segy.read(patch.data(), x0, x1, y0, y1, z0, z1);
+    size_t k = 0;
+    for (int z = z0; z < z1; z++) {
+      for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+          ok &= patch[k++] == expected[(z * ny + y) * nx + x];
+        }
+      }
+    }
+  }
+  return ok;
+}
+
+// lines missing their first, last or several middle traces
+void test_irregular(int format) {
+  std::set<std::pair<int, int>> missing = {{1, 0}, {1, 1}, {2, 7}, {3, 3},
+                                           {3, 4}, {4, 0}, {4, 7}};
+  test::write_volume("irregular.sgy", 12, 8, 9, missing, false, format);
+  std::vector<float> expected =
+      test::expected_volume(12, 8, 9, missing, false, kFill);
+  segy::SegyIO segy("irregular.sgy");
+  segy.setVerbose(false);
+  segy.setFillNoValue(kFill);
+  CHECK(test::read_all(segy) == expected);
+  CHECK(!segy.get_metaInfo().isNormalSegy);
+  CHECK(check_patches(segy, expected, 12, 8, 9, 200));
+
+  std::vector<float> slice(12 * 8);
+  segy.read_time_slice(slice.data(), 4);
+  bool ok = true;
+  for (int i = 0; i < 12 * 8; i++) {
+    ok &= slice[i] == expected[i * 9 + 4];
+  }
+  CHECK(ok);
+}
+
+// 40% of the traces missing at random, the first line complete
+void test_random() {
+  srand(3);
+  std::set<std::pair<int, int>> missing;
+  for (int z = 1; z < 15; z++) {
+    for (int y = 0; y < 40; y++) {
+      if (rand() % 10 < 4 && !(z == 14 && y == 39)) {
+        missing.insert(std::make_pair(z, y));
+      }
+    }
+  }
+  test::write_volume("random.sgy", 15, 40, 7, missing);
+  std::vector<float> expected =
+      test::expected_volume(15, 40, 7, missing, false, kFill);
+  segy::SegyIO segy("random.sgy");
+  segy.setVerbose(false);
+  segy.setFillNoValue(kFill);
+  CHECK(test::read_all(segy) == expected);
+  CHECK(check_patches(segy, expected, 15, 40, 7, 300));
+}
+
+// the traces of an irregular line aren't sorted by crossline
+void test_unsorted_line() {
+  std::set<std::pair<int, int>> missing = {{2, 3}};
+  std::vector<test::Trace> traces = test::volume_traces(5, 10, 6, missing);
+  // line 2 is traces[20, 29)
+  std::reverse(traces.begin() + 22, traces.begin() + 27);
+  test::Layout layout;
+  layout.sizeX = 6;
+  test::write_segy("unsorted.sgy", layout, traces);
+
+  std::vector<float> expected =
+      test::expected_volume(5, 10, 6, missing, false, kFill);
+  segy::SegyIO segy("unsorted.sgy");
+  segy.setVerbose(false);
+  segy.setFillNoValue(kFill);
+  CHECK(test::read_all(segy) == expected);
+  CHECK(check_patches(segy, expected, 5, 10, 6, 100));
+}
+
+} // namespace
+
+int main() {
+  test_irregular(5);
+  test_irregular(1);
+  test_random();
+  test_unsorted_line();
+  return test::report();
+}
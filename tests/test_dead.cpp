@@ -0,0 +1,125 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_dead.cpp
+** @Time: 2026/10/20 09:58:07
+** @Version: 1.0
+** @Description : dead and zero trace detection
+*********************************************************************/
+
+#include "common.h"
+
+namespace {
+
+const float kFill = -7;
+const int nz = 6, ny = 5, nx = 8;
+
+// 0 live, 1 dead (by the code or all zeros), 2 missing
+int state(int z, int y) {
+  if (z == 1 && y == 2) {
+    return 2;
+  }
+  if ((z == 0 && y == 1) || (z == 3 && y == 4)) {
+    return 1; // trace identification code 2
+  }
+  if ((z == 2 && y == 0) || (z == 4 && y == 3)) {
+    return 1; // all samples zero
+  }
+  return 0;
+}
+
+void write_dead(const std::string &name) {
+  std::vector<test::Trace> traces;
+  for (test::Trace t : test::volume_traces(nz, ny, nx, {{1, 2}})) {
+    int z = t.inline_num - 100, y = t.crossline_num - 10;
+    if ((z == 0 && y == 1) || (z == 3 && y == 4)) {
+      t.code = 2;
+    }
+    for (int x = 0; x < nx; x++) {
+      bool zero = (z == 2 && y == 0) || (z == 4 && y == 3);
+      t.samples[x] = zero ? 0 : test::value(z, y, x) + 1;
+    }
+    traces.push_back(t);
+  }
+  test::Layout layout;
+  layout.sizeX = nx;
+  test::write_segy(name, layout, traces);
+}
+
+void test_detect(segy::Backend backend) {
+  segy::SegyIO segy("dead.sgy", backend);
+  segy.setVerbose(false);
+  segy.setFillNoValue(kFill);
+  segy.setDetectDead(true);
+  std::vector<float> data = test::read_all(segy);
+  CHECK(segy.dead_count() == 4);
+
+  std::vector<uint8_t> mask(ny * nz);
+  segy.dead_mask(mask.data());
+  std::vector<float> slice(ny * nz);
+  segy.read_time_slice(slice.data(), 3);
+  bool ok = true;
+  for (int z = 0; z < nz; z++) {
+    for (int y = 0; y < ny; y++) {
+      int s = state(z, y);
+      ok &= mask[z * ny + y] == s;
+      for (int x = 0; x < nx; x++) {
+        ok &= data[(z * ny + y) * nx + x] ==
+              (s ? kFill : test::value(z, y, x) + 1);
+      }
+      ok &= slice[z * ny + y] == (s ? kFill : test::value(z, y, 3) + 1);
+    }
+  }
+  CHECK(ok);
+
+  // collect() fills the dead traces too, the headers are kept
+  std::vector<float> traces(segy.trace_count() * nx);
+  std::vector<int> headers(segy.trace_count() * 4);
+  segy.collect(traces.data(), headers.data());
+  CHECK(traces[0] == 1 && traces[nx] == kFill);
+  CHECK(headers[4] == 100 && headers[5] == 11);
+
+  segy.tofile("dead.bin");
+  CHECK(test::read_floats("dead.bin") == data);
+
+  // without detection, the samples are read as they are
+  segy::SegyIO raw("dead.sgy", backend);
+  raw.setVerbose(false);
+  std::vector<float> all = test::read_all(raw);
+  CHECK(raw.dead_count() == 0);
+  CHECK(all[nx] == test::value(0, 1, 0) + 1);
+  CHECK(all[(2 * ny) * nx] == 0);
+}
+
+// set_size() skips scan(), the dead traces are found all the same
+void test_set_size() {
+  test::write_volume("regular.sgy", 4, 3, 5);
+  std::string bytes = test::read_file("regular.sgy");
+  // zero the samples of trace 4
+  size_t trace = segy::kTraceHeaderSize + 5 * sizeof(float);
+  memset(&bytes[3600 + 4 * trace + segy::kTraceHeaderSize], 0,
+         5 * sizeof(float));
+  test::write_file("regular.sgy", bytes);
+
+  segy::SegyIO segy("regular.sgy");
+  segy.setVerbose(false);
+  segy.setDetectDead(true);
+  segy.setFillNoValue(kFill);
+  segy.set_size(5, 3, 4);
+  CHECK(segy.dead_count() == 1);
+  std::vector<float> data(5 * 3 * 4);
+  segy.read(data.data());
+  CHECK(data[4 * 5] == kFill && data[3 * 5] == test::value(1, 0, 0));
+}
+
+} // namespace
+
+int main() {
+  write_dead("dead.sgy");
+  test_detect(segy::Backend::MMap);
+  test_detect(segy::Backend::PRead);
+  test_set_size();
+  return test::report();
+}
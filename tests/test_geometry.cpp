@@ -0,0 +1,129 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_geometry.cpp
+** @Time: 2026/10/20 07:46:22
+** @Version: 1.0
+** @Description : survey geometry and world coordinate queries
+*********************************************************************/
+
+#include <cstdlib>
+
+#include "common.h"
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+bool near(double a, double b, double tol = 1e-6) {
+  return std::fabs(a - b) <= tol;
+}
+
+// The crosslines run along azimuth 30 degrees 12.5 m apart, the inlines
+// are 25 m apart, trace (0, 0) is at (500000, 4000000).
+void rotated_coord(int z, int y, double &x, double &yy) {
+  double a = 30 * kPi / 180;
+  x = 500000 + y * 12.5 * std::sin(a) + z * 25 * std::cos(a);
+  yy = 4000000 + y * 12.5 * std::cos(a) - z * 25 * std::sin(a);
+}
+
+// the synthetic volume: X, Y of trace (z, y) are (10 + 25y, 20 + 25z)
+void test_axis_aligned() {
+  std::set<std::pair<int, int>> missing = {{1, 3}, {4, 0}, {7, 39}};
+  test::write_volume("aligned.sgy", 8, 40, 3, missing);
+  segy::SegyIO segy("aligned.sgy");
+  segy.setVerbose(false);
+  segy::Geometry g = segy.geometry();
+  CHECK(g.valid);
+  CHECK(near(g.inline_bin, 25) && near(g.crossline_bin, 25));
+  CHECK(near(g.azimuth, 90));
+  CHECK(near(g.origin_X, 10) && near(g.origin_Y, 20));
+  CHECK(near(g.scalar, 0.01) && g.rms_error < 1e-6);
+
+  double iline, xline, x, y;
+  segy.coord_to_line(10 + 25 * 3, 20 + 25 * 5, iline, xline);
+  CHECK(near(iline, 105) && near(xline, 13));
+  segy.coord_to_line(10 + 25 * 3.5, 20 + 25 * 5.25, iline, xline);
+  CHECK(near(iline, 105.25) && near(xline, 13.5));
+  segy.line_to_coord(105, 13, x, y);
+  CHECK(near(x, 85) && near(y, 145));
+
+  // nearest trace, against all the present traces
+  srand(5);
+  bool ok = true;
+  for (int i = 0; i < 1000; i++) {
+    double qx = -100 + rand() % 1400 + 0.37;
+    double qy = -100 + rand() % 500 + 0.21;
+    segy::TraceInfo t = segy.trace_info(segy.nearest_trace(qx, qy));
+    double got = std::hypot(t.X / 100.0 - qx, t.Y / 100.0 - qy);
+    double best = 1e30;
+    for (int z = 0; z < 8; z++) {
+      for (int yy = 0; yy < 40; yy++) {
+        if (!missing.count(std::make_pair(z, yy))) {
+          best = std::min(best, std::hypot(10 + 25.0 * yy - qx,
+                                           20 + 25.0 * z - qy));
+        }
+      }
+    }
+    ok &= near(got, best);
+  }
+  CHECK(ok);
+}
+
+void test_rotated() {
+  std::vector<test::Trace> traces = test::volume_traces(6, 20, 2);
+  for (test::Trace &t : traces) {
+    double x, y;
+    rotated_coord(t.inline_num - 100, t.crossline_num - 10, x, y);
+    t.x = static_cast<int32_t>(std::lround(x * 100));
+    t.y = static_cast<int32_t>(std::lround(y * 100));
+  }
+  test::Layout layout;
+  layout.sizeX = 2;
+  test::write_segy("rotated.sgy", layout, traces);
+
+  segy::SegyIO segy("rotated.sgy");
+  segy.setVerbose(false);
+  segy::Geometry g = segy.geometry();
+  CHECK(g.valid);
+  CHECK(near(g.inline_bin, 25, 1e-3) && near(g.crossline_bin, 12.5, 1e-3));
+  CHECK(near(g.azimuth, 30, 1e-3));
+  CHECK(near(g.origin_X, 500000, 1e-2) && near(g.origin_Y, 4000000, 1e-2));
+  CHECK(g.rms_error < 1e-2);
+
+  // the round trip of a point between the bins
+  double x, y, iline, xline;
+  rotated_coord(2, 7, x, y);
+  segy.coord_to_line(x, y, iline, xline);
+  CHECK(near(iline, 102, 1e-3) && near(xline, 17, 1e-3));
+  segy.line_to_coord(103.5, 12.25, x, y);
+  segy.coord_to_line(x, y, iline, xline);
+  CHECK(near(iline, 103.5, 1e-9) && near(xline, 12.25, 1e-9));
+
+  rotated_coord(4, 11, x, y);
+  segy::TraceInfo t = segy.trace_info(segy.nearest_trace(x + 1, y - 2));
+  CHECK(t.inline_num == 104 && t.crossline_num == 21);
+}
+
+// a single line has no areal geometry, but the nearest trace works
+void test_line() {
+  test::write_volume("line.sgy", 1, 30, 2);
+  segy::SegyIO segy("line.sgy");
+  segy.setVerbose(false);
+  CHECK(!segy.geometry().valid);
+  double iline, xline;
+  CHECK_THROWS(segy.coord_to_line(0, 0, iline, xline));
+  segy::TraceInfo t = segy.trace_info(segy.nearest_trace(10 + 25 * 17.2, 20));
+  CHECK(t.crossline_num == 27);
+}
+
+} // namespace
+
+int main() {
+  test_axis_aligned();
+  test_rotated();
+  test_line();
+  return test::report();
+}
@@ -0,0 +1,141 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_horizon.cpp
+** @Time: 2026/10/20 12:37:51
+** @Version: 1.0
+** @Description : attribute maps along horizons
+*********************************************************************/
+
+#include <algorithm>
+
+#include "common.h"
+
+namespace {
+
+const segy::HorizonAttr kAttrs[] = {
+    segy::HorizonAttr::Amplitude, segy::HorizonAttr::Mean,
+    segy::HorizonAttr::RMS, segy::HorizonAttr::Max};
+
+// the attribute of the live samples `trace[0:n]` at the sample index `t`
+double attribute(const float *trace, int n, double t, segy::HorizonAttr attr,
+                 int window) {
+  if (!(t >= 0 && t <= n - 1)) {
+    return NAN;
+  }
+  if (attr == segy::HorizonAttr::Amplitude) {
+    int i = static_cast<int>(std::floor(t));
+    return i + 1 < n ? trace[i] + (t - i) * (trace[i + 1] - trace[i])
+                     : trace[i];
+  }
+  int c = static_cast<int>(std::lround(t));
+  double sum = 0, sum2 = 0, peak = -1e30;
+  int count = 0;
+  for (int i = std::max(c - window, 0); i <= std::min(c + window, n - 1);
+       i++) {
+    sum += trace[i];
+    sum2 += static_cast<double>(trace[i]) * trace[i];
+    peak = std::max(peak, static_cast<double>(trace[i]));
+    count++;
+  }
+  if (attr == segy::HorizonAttr::Mean) {
+    return sum / count;
+  }
+  return attr == segy::HorizonAttr::RMS ? std::sqrt(sum2 / count) : peak;
+}
+
+void test_file(const std::string &name, segy::Backend backend, int resample) {
+  segy::SegyIO segy(name, backend);
+  segy.setVerbose(false);
+  segy.setFillNoValue(NAN);
+  segy.scan();
+  if (resample) {
+    segy.setResample(resample);
+  }
+  std::vector<float> vol = test::read_all(segy);
+  int nx = segy.shape(0), ny = segy.shape(1), nz = segy.shape(2);
+  size_t nbins = static_cast<size_t>(nz) * ny;
+
+  // three horizons as sample indices, the last one is absent on a
+  // crossline, the first one is above and below the first two traces
+  int nh = 3;
+  std::vector<float> index(nh * nbins);
+  for (int h = 0; h < nh; h++) {
+    for (size_t b = 0; b < nbins; b++) {
+      int z = b / ny, y = b % ny;
+      index[h * nbins + b] =
+          h == 2 && y == 1 ? NAN
+                           : 0.3f + h * 2.7f + 0.37f * z + 0.21f * y -
+                                 (h == 1 ? 1.5f : 0);
+    }
+  }
+  index[0] = -0.5f;
+  index[1] = nx + 2;
+  // to ms from the start time
+  double dt = segy.sample_interval() / 1000.0;
+  int t0 = segy.get_metaInfo().start_time;
+  std::vector<float> times(index.size());
+  for (size_t i = 0; i < index.size(); i++) {
+    times[i] = static_cast<float>(t0 + index[i] * dt);
+  }
+
+  for (segy::HorizonAttr attr : kAttrs) {
+    int window = 2;
+    std::vector<float> maps(nh * nbins);
+    segy.read_horizons(maps.data(), times.data(), nh, attr, window);
+    bool ok = true;
+    for (int h = 0; h < nh; h++) {
+      for (size_t b = 0; b < nbins; b++) {
+        const float *trace = vol.data() + b * nx;
+        int n = 0;
+        while (n < nx && trace[n] == trace[n]) {
+          n++;
+        }
+        double r = attribute(trace, n, index[h * nbins + b], attr, window);
+        float g = maps[h * nbins + b];
+        ok &= r != r ? g != g : std::fabs(g - r) < 1e-4 * std::fabs(r) + 1e-2;
+      }
+    }
+    CHECK(ok);
+  }
+
+  std::vector<float> map(nbins);
+  CHECK_THROWS(segy.read_horizons(map.data(), times.data(), 0,
+                                  segy::HorizonAttr::Mean));
+  CHECK_THROWS(segy.read_horizons(map.data(), times.data(), 1,
+                                  segy::HorizonAttr::Mean, -1));
+}
+
+} // namespace
+
+int main() {
+  // the horizons are relative to the start time of the traces
+  test::Layout layout;
+  layout.sizeX = 12;
+  layout.start_time = 100;
+  test::write_segy("regular.sgy", layout, test::volume_traces(6, 5, 12));
+  std::set<std::pair<int, int>> missing = {{0, 1}, {2, 2}, {3, 4}};
+  test::write_volume("irregular.sgy", 6, 5, 12, missing, false, 1);
+  test::write_volume("variable.sgy", 6, 5, 12, {}, true);
+  for (const char *name : {"regular.sgy", "irregular.sgy", "variable.sgy"}) {
+    for (int resample : {0, 3000}) {
+      for (segy::Backend backend :
+           {segy::Backend::MMap, segy::Backend::PRead}) {
+        test_file(name, backend, resample);
+      }
+    }
+  }
+
+  // without a sample interval the times can't be converted
+  layout.interval = 0;
+  test::write_segy("nointerval.sgy", layout, test::volume_traces(2, 2, 12));
+  segy::SegyIO segy("nointerval.sgy");
+  segy.setVerbose(false);
+  segy.scan();
+  std::vector<float> times(4, 10), map(4);
+  CHECK_THROWS(segy.read_horizons(map.data(), times.data(), 1,
+                                  segy::HorizonAttr::Amplitude));
+  return test::report();
+}
@@ -0,0 +1,100 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_large.cpp
+** @Time: 2026/10/20 07:12:05
+** @Version: 1.0
+** @Description : more than 10000 crosslines and files over 2 GB
+*********************************************************************/
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "common.h"
+
+namespace {
+
+const float kFill = -1;
+
+// 12005 crosslines, a few traces missing past crossline 10000
+void test_wide() {
+  std::set<std::pair<int, int>> missing = {{1, 11000}, {2, 10001}};
+  test::write_volume("wide.sgy", 3, 12005, 2, missing);
+  segy::SegyIO segy("wide.sgy");
+  segy.setVerbose(false);
+  segy.setFillNoValue(kFill);
+  std::vector<float> data = test::read_all(segy);
+  CHECK(segy.shape(1) == 12005 && segy.shape(2) == 3);
+  CHECK(data == test::expected_volume(3, 12005, 2, missing, false, kFill));
+}
+
+// A sparse file of 2.2 GB: 3 inlines x 6200 crosslines x 30000 samples.
+// Only the trace headers and two traces are written, the rest are holes.
+void test_over_2gb() {
+  const int nz = 3, ny = 6200, nx = 30000;
+  const uint64_t trace_bytes = segy::kTraceHeaderSize + nx * sizeof(float);
+  test::Layout layout;
+  layout.sizeX = nx;
+  std::string headers = test::encode_headers(layout);
+
+  int fd = open("large.sgy", O_RDWR | O_CREAT | O_TRUNC, 0644);
+  CHECK(fd >= 0);
+  CHECK(write(fd, headers.data(), headers.size()) ==
+        static_cast<ssize_t>(headers.size()));
+  std::vector<test::Trace> traces = test::volume_traces(1, 1, 0);
+  for (int z = 0; z < nz; z++) {
+    for (int y = 0; y < ny; y++) {
+      test::Trace t = traces[0];
+      t.inline_num = 100 + z;
+      t.crossline_num = 10 + y;
+      bool full = (z == 2 && y == ny - 1) || (z == 1 && y == 5000);
+      for (int x = 0; full && x < nx; x++) {
+        t.samples.push_back(test::value(z, y, x));
+      }
+      std::string bytes = test::encode_trace(t, layout);
+      // the sample count of the header is the one of the file
+      test::put<int16_t>(&bytes[segy::kTSampleCountField - 1], nx);
+      uint64_t offset = segy::kTextualHeaderSize + segy::kBinaryHeaderSize +
+                        (static_cast<uint64_t>(z) * ny + y) * trace_bytes;
+      CHECK(pwrite(fd, bytes.data(), bytes.size(), offset) ==
+            static_cast<ssize_t>(bytes.size()));
+    }
+  }
+  CHECK(ftruncate(fd, segy::kTextualHeaderSize + segy::kBinaryHeaderSize +
+                          static_cast<uint64_t>(nz) * ny * trace_bytes) == 0);
+  close(fd);
+
+  segy::SegyIO segy("large.sgy");
+  segy.setVerbose(false);
+  segy.scan();
+  CHECK(segy.trace_count() == nz * ny);
+  CHECK(segy.shape(0) == nx && segy.shape(1) == ny && segy.shape(2) == nz);
+
+  // the last trace is past 2 GB
+  std::vector<float> trace(nx);
+  segy.read(trace.data(), 0, nx, ny - 1, ny, 2, 3);
+  bool ok = true;
+  for (int x = 0; x < nx; x++) {
+    ok &= trace[x] == test::value(2, ny - 1, x);
+  }
+  CHECK(ok);
+
+  std::vector<float> slice(static_cast<size_t>(ny) * nz);
+  segy.read_time_slice(slice.data(), nx - 1);
+  CHECK(slice[ny + 5000] == test::value(1, 5000, nx - 1));
+  CHECK(slice[2 * ny + ny - 1] == test::value(2, ny - 1, nx - 1));
+  CHECK(slice[2 * ny + ny - 2] == 0);
+
+  segy.close_file();
+  unlink("large.sgy");
+}
+
+} // namespace
+
+int main() {
+  test_wide();
+  test_over_2gb();
+  return test::report();
+}
@@ -0,0 +1,145 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_line2d.cpp
+** @Time: 2026/10/20 06:51:17
+** @Version: 1.0
+** @Description : 2D lines and 3D files of a single inline
+*********************************************************************/
+
+#include "common.h"
+
+namespace {
+
+const float kFill = -1;
+
+// one line of `count` traces, the CDP (and crossline) of trace i is
+// first + i * step, without the CDPs in `missing`
+std::vector<test::Trace> line_traces(int count, int nx, int first, int step,
+                                     const std::set<int> &missing = {}) {
+  std::vector<test::Trace> traces;
+  std::vector<test::Trace> all = test::volume_traces(1, count, nx);
+  for (int i = 0; i < count; i++) {
+    test::Trace t = all[i];
+    t.inline_num = 0;
+    t.crossline_num = first + i * step;
+    if (!missing.count(t.crossline_num)) {
+      traces.push_back(t);
+    }
+  }
+  return traces;
+}
+
+void write_line(const std::string &name, const std::vector<test::Trace> &t,
+                int nx) {
+  test::Layout layout;
+  layout.sizeX = nx;
+  test::write_segy(name, layout, t);
+}
+
+// CDPs 1..300 by one, three of them missing
+void test_missing_cdp() {
+  write_line("line2d.sgy", line_traces(300, 6, 1, 1, {4, 5, 101}), 6);
+  segy::SegyIO segy("line2d.sgy");
+  segy.setVerbose(false);
+  segy.setLine2D(segy::kDefaultCDPField);
+  segy.setFillNoValue(kFill);
+  std::vector<float> data = test::read_all(segy);
+  CHECK(segy.shape(0) == 6 && segy.shape(1) == 300 && segy.shape(2) == 1);
+  bool ok = true;
+  for (int y = 0; y < 300; y++) {
+    bool missing = y == 3 || y == 4 || y == 100;
+    for (int x = 0; x < 6; x++) {
+      ok &= data[y * 6 + x] == (missing ? kFill : test::value(0, y, x));
+    }
+  }
+  CHECK(ok);
+
+  // a patch around a missing trace
+  std::vector<float> patch(6 * 50);
+  segy.read(patch.data(), 0, 6, 90, 140, 0, 1);
+  CHECK(patch[10 * 6 + 1] == kFill);
+  CHECK(patch[11 * 6 + 2] == test::value(0, 101, 2));
+}
+
+// CDPs by two: one trace for each key, nothing is missing
+void test_step_two() {
+  write_line("step2.sgy", line_traces(40, 5, 1001, 2), 5);
+  segy::SegyIO segy("step2.sgy");
+  segy.setVerbose(false);
+  segy.setLine2D();
+  segy.setFillNoValue(kFill);
+  std::vector<float> data = test::read_all(segy);
+  CHECK(segy.shape(1) == 40 && segy.trace_count() == 40);
+  CHECK(segy.get_metaInfo().isNormalSegy);
+  CHECK(data == test::expected_volume(1, 40, 5, {}, false, kFill));
+  // the traces are 25 m apart, in the unscaled coordinates (cm)
+  CHECK(std::fabs(segy.get_metaInfo().Y_interval - 2500) < 1e-3);
+}
+
+// a corrupt last key would make a line of billions of crosslines, or many
+// times more than the traces: the traces in the file order
+void test_corrupt_key() {
+  for (int key : {2000000000, 1000}) {
+    std::vector<test::Trace> traces = line_traces(20, 4, 1, 1);
+    traces[19].crossline_num = key;
+    write_line("corrupt.sgy", traces, 4);
+    segy::SegyIO segy("corrupt.sgy");
+    segy.setVerbose(false);
+    segy.setLine2D();
+    std::vector<float> data = test::read_all(segy);
+    CHECK(segy.shape(1) == 20);
+    CHECK(data == test::expected_volume(1, 20, 4, {}, false, 0));
+  }
+}
+
+// the keys are not increasing evenly: the traces in the file order
+void test_uneven() {
+  std::vector<test::Trace> traces = line_traces(20, 4, 1, 1);
+  std::swap(traces[6].crossline_num, traces[7].crossline_num);
+  traces[1].crossline_num = 3;
+  traces[19].crossline_num = 30;
+  write_line("uneven.sgy", traces, 4);
+  segy::SegyIO segy("uneven.sgy");
+  segy.setVerbose(false);
+  segy.setLine2D();
+  std::vector<float> data = test::read_all(segy);
+  CHECK(segy.shape(1) == 20);
+  CHECK(data == test::expected_volume(1, 20, 4, {}, false, 0));
+}
+
+// a 3D file of only one inline is found without setLine2D()
+void test_single_inline() {
+  test::write_volume("single.sgy", 1, 25, 7);
+  segy::SegyIO segy("single.sgy");
+  segy.setVerbose(false);
+  std::vector<float> data = test::read_all(segy);
+  CHECK(segy.shape(1) == 25 && segy.shape(2) == 1);
+  CHECK(segy.get_metaInfo().min_inline == 100);
+  CHECK(segy.get_metaInfo().min_crossline == 10);
+  CHECK(data == test::expected_volume(1, 25, 7, {}, false, 0));
+}
+
+// a wrong inline field (all zeros) of a 3D file still throws, it isn't
+// taken as a single line
+void test_wrong_inline_field() {
+  test::write_volume("volume.sgy", 3, 4, 5);
+  segy::SegyIO segy("volume.sgy");
+  segy.setVerbose(false);
+  segy.setInlineLocation(181);
+  CHECK_THROWS(segy.scan());
+}
+
+} // namespace
+
+int main() {
+  test_missing_cdp();
+  test_step_two();
+  test_uneven();
+  test_corrupt_key();
+  test_single_inline();
+  test_wrong_inline_field();
+  return test::report();
+}
@@ -0,0 +1,149 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_multi.cpp
+** @Time: 2026/10/20 13:02:17
+** @Version: 1.0
+** @Description : several segy files read as the channels of one array
+*********************************************************************/
+
+#include "common.h"
+#include "multi.h"
+
+namespace {
+
+bool same(float a, float b) { return (a != a && b != b) || a == b; }
+
+// the volume with the samples s of every trace mapped to 1 - 2 s
+void write_attribute(const std::string &name,
+                     const std::set<std::pair<int, int>> &missing,
+                     bool variable) {
+  std::vector<test::Trace> traces =
+      test::volume_traces(6, 7, 9, missing, variable);
+  for (test::Trace &t : traces) {
+    for (float &s : t.samples) {
+      s = 1 - 2 * s;
+    }
+  }
+  test::Layout layout;
+  layout.sizeX = 9;
+  layout.variable = variable;
+  test::write_segy(name, layout, traces);
+}
+
+std::vector<float> read_volume(const std::string &name) {
+  segy::SegyIO segy(name);
+  segy.setVerbose(false);
+  segy.setFillNoValue(NAN);
+  return test::read_all(segy);
+}
+
+void test_files(const std::string &first, const std::string &second) {
+  std::vector<float> a = read_volume(first);
+  std::vector<float> b = read_volume(second);
+  const std::vector<float> *channels[3] = {&a, &b, &a};
+  int nx = 9, ny = 7, nz = 6;
+  size_t n = a.size();
+  auto expected = [&](int c, int z, int y, int x) {
+    return (*channels[c])[(static_cast<size_t>(z) * ny + y) * nx + x];
+  };
+
+  for (segy::Backend backend : {segy::Backend::MMap, segy::Backend::PRead}) {
+    for (int threads : {1, 3, 0}) {
+      segy::MultiSegy multi({first, second, first}, backend);
+      multi.setFillNoValue(NAN);
+      multi.setThreads(threads);
+      CHECK(multi.count() == 3 && multi.shape(0) == nx &&
+            multi.shape(1) == ny && multi.shape(2) == nz);
+
+      std::vector<float> d(3 * n);
+      multi.read(d.data());
+      bool ok = true;
+      for (int c = 0; c < 3; c++) {
+        for (size_t i = 0; i < n; i++) {
+          ok &= same(d[c * n + i], (*channels[c])[i]);
+        }
+      }
+      CHECK(ok);
+      multi.read(d.data(), true);
+      ok = true;
+      for (int c = 0; c < 3; c++) {
+        for (size_t i = 0; i < n; i++) {
+          ok &= same(d[i * 3 + c], (*channels[c])[i]);
+        }
+      }
+      CHECK(ok);
+
+      // a subvolume, channels last
+      std::vector<float> sub(2 * 3 * 4 * 3);
+      multi.read(sub.data(), 1, 5, 2, 5, 1, 3, true);
+      ok = true;
+      for (int z = 0; z < 2; z++) {
+        for (int y = 0; y < 3; y++) {
+          for (int x = 0; x < 4; x++) {
+            for (int c = 0; c < 3; c++) {
+              ok &= same(sub[((z * 3 + y) * 4 + x) * 3 + c],
+                         expected(c, z + 1, y + 2, x + 1));
+            }
+          }
+        }
+      }
+      CHECK(ok);
+
+      // patches at the corners and inside, in both layouts
+      int starts[] = {0, 0, 0, nz - 2, ny - 3, nx - 4, 1, 2, 3};
+      for (bool channels_last : {false, true}) {
+        std::vector<float> p(3 * 3 * 24);
+        multi.read_patches(p.data(), starts, 3, 4, 3, 2, channels_last);
+        ok = true;
+        for (int q = 0; q < 3; q++) {
+          for (int c = 0; c < 3; c++) {
+            for (int k = 0; k < 24; k++) {
+              int z = k / 12, y = k / 4 % 3, x = k % 4;
+              float g = channels_last ? p[(q * 24 + k) * 3 + c]
+                                      : p[(q * 3 + c) * 24 + k];
+              ok &= same(g, expected(c, z + starts[3 * q],
+                                     y + starts[3 * q + 1],
+                                     x + starts[3 * q + 2]));
+            }
+          }
+        }
+        CHECK(ok);
+      }
+
+      CHECK_THROWS(multi.read(d.data(), 0, nx + 1, 0, ny, 0, nz));
+      CHECK_THROWS(multi.read(d.data(), 2, 2, 0, ny, 0, nz));
+    }
+  }
+}
+
+} // namespace
+
+int main() {
+  std::set<std::pair<int, int>> missing = {{0, 2}, {3, 0}, {5, 6}};
+  test::write_volume("regular.sgy", 6, 7, 9);
+  write_attribute("regular_2.sgy", {}, false);
+  test::write_volume("irregular.sgy", 6, 7, 9, missing);
+  write_attribute("irregular_2.sgy", missing, false);
+  test::write_volume("variable.sgy", 6, 7, 9, {}, true);
+  write_attribute("variable_2.sgy", {}, true);
+  test_files("regular.sgy", "regular_2.sgy");
+  test_files("irregular.sgy", "irregular_2.sgy");
+  test_files("variable.sgy", "variable_2.sgy");
+
+  CHECK_THROWS(segy::MultiSegy(std::vector<std::string>()));
+  // a different geometry
+  CHECK_THROWS(segy::MultiSegy({"regular.sgy", "irregular.sgy"}).scan());
+  // the same size with other keys
+  std::vector<test::Trace> traces = test::volume_traces(6, 7, 9);
+  for (test::Trace &t : traces) {
+    t.inline_num += 1;
+  }
+  test::Layout layout;
+  layout.sizeX = 9;
+  test::write_segy("shifted.sgy", layout, traces);
+  CHECK_THROWS(segy::MultiSegy({"regular.sgy", "shifted.sgy"}).scan());
+  return test::report();
+}
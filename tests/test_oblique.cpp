@@ -0,0 +1,146 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_oblique.cpp
+** @Time: 2026/10/20 12:16:03
+** @Version: 1.0
+** @Description : trilinear interpolation on oblique grids
+*********************************************************************/
+
+#include <algorithm>
+
+#include "common.h"
+
+namespace {
+
+bool same(float a, float b) { return (a != a && b != b) || a == b; }
+
+void set_grid(segy::ObliqueGrid &grid, const double *origin, const double *u,
+              const double *v, const double *w, int nu, int nv, int nw) {
+  for (int d = 0; d < 3; d++) {
+    grid.origin[d] = origin[d];
+    grid.u[d] = u[d];
+    grid.v[d] = v[d];
+    grid.w[d] = w[d];
+  }
+  grid.nu = nu;
+  grid.nv = nv;
+  grid.nw = nw;
+}
+
+void test_file(const std::string &name, segy::Backend backend) {
+  segy::SegyIO segy(name, backend);
+  segy.setVerbose(false);
+  segy.setFillNoValue(NAN);
+  std::vector<float> vol = test::read_all(segy);
+  int nx = segy.shape(0), ny = segy.shape(1), nz = segy.shape(2);
+  auto at = [&](int z, int y, int x) {
+    return vol[(static_cast<size_t>(z) * ny + y) * nx + x];
+  };
+  segy::MetaInfo meta = segy.get_metaInfo();
+  double i0 = meta.min_inline, x0 = meta.min_crossline;
+
+  // trilinear interpolation at (z, y, x) from the first index, the missing
+  // traces are left out of the weights
+  auto expected = [&](double z, double y, double x) -> double {
+    if (!(x >= 0 && x <= nx - 1)) {
+      return NAN;
+    }
+    int iz = static_cast<int>(std::floor(z));
+    int iy = static_cast<int>(std::floor(y));
+    int ix = static_cast<int>(std::floor(x));
+    double fz = z - iz, fy = y - iy, fx = x - ix;
+    double sum = 0, weight = 0;
+    for (int c = 0; c < 4; c++) {
+      int zz = iz + c / 2, yy = iy + c % 2;
+      double wc = (c / 2 ? fz : 1 - fz) * (c % 2 ? fy : 1 - fy);
+      if (wc <= 0 || zz < 0 || zz >= nz || yy < 0 || yy >= ny) {
+        continue;
+      }
+      float e = at(zz, yy, ix);
+      if (e != e) {
+        continue;
+      }
+      sum += wc * (ix + 1 < nx ? e + fx * (at(zz, yy, ix + 1) - e) : e);
+      weight += wc;
+    }
+    return weight > 0 ? sum / weight : NAN;
+  };
+
+  // on the bins and samples, the grid is a subvolume
+  segy::ObliqueGrid grid;
+  double origin[3] = {i0 + 1, x0 + 2, 3};
+  double u[3] = {1, 0, 0}, v[3] = {0, 1, 0}, w[3] = {0, 0, 1};
+  set_grid(grid, origin, u, v, w, 4, 3, 5);
+  std::vector<float> sub(4 * 3 * 5), got(4 * 3 * 5);
+  segy.read(sub.data(), 3, 8, 2, 5, 1, 5);
+  segy.read_oblique(got.data(), grid);
+  CHECK(std::equal(got.begin(), got.end(), sub.begin(), same));
+
+  for (int kind = 0; kind < 3; kind++) {
+    double angle = 0.6;
+    double o[3] = {i0 + 1.3, x0 + 0.4, 1.5};
+    double gu[3] = {std::cos(angle), std::sin(angle), 0};
+    double gv[3] = {-std::sin(angle), std::cos(angle), 0};
+    double gw[3] = {0, 0, 0.75};
+    if (kind == 1) {
+      // a dipping time axis
+      gw[0] = 0.2;
+      gw[1] = 0.1;
+      gw[2] = 0.5;
+    } else if (kind == 2) {
+      // partly outside of the survey and the traces
+      gu[2] = 0.3;
+      gv[2] = 0.2;
+      gw[2] = 1;
+      o[0] = i0 - 2;
+    }
+    set_grid(grid, o, gu, gv, gw, 6, 5, 9);
+    std::vector<float> d(6 * 5 * 9);
+    segy.read_oblique(d.data(), grid);
+    bool ok = true;
+    int live = 0;
+    for (int i = 0; i < grid.nu; i++) {
+      for (int j = 0; j < grid.nv; j++) {
+        for (int k = 0; k < grid.nw; k++) {
+          double p[3];
+          for (int e = 0; e < 3; e++) {
+            p[e] = o[e] + i * gu[e] + j * gv[e] + k * gw[e];
+          }
+          double r = expected(p[0] - i0, p[1] - x0, p[2]);
+          float g = d[(i * grid.nv + j) * grid.nw + k];
+          ok &= r != r ? g != g : std::fabs(g - r) < 1e-3 * std::fabs(r) + 1e-2;
+          live += r == r;
+        }
+      }
+    }
+    CHECK(ok);
+    CHECK(live > 0);
+  }
+
+  // outside of the survey
+  double far[3] = {i0 - 100, x0, 0};
+  set_grid(grid, far, u, v, w, 2, 2, 2);
+  float outside[8];
+  segy.read_oblique(outside, grid);
+  CHECK(outside[0] != outside[0] && outside[7] != outside[7]);
+
+  set_grid(grid, origin, u, v, w, 2, 0, 2);
+  CHECK_THROWS(segy.read_oblique(outside, grid));
+}
+
+} // namespace
+
+int main() {
+  test::write_volume("regular.sgy", 8, 7, 11);
+  std::set<std::pair<int, int>> missing = {{0, 1}, {2, 2}, {3, 6}, {5, 0}};
+  test::write_volume("irregular.sgy", 8, 7, 11, missing, false, 1);
+  for (const char *name : {"regular.sgy", "irregular.sgy"}) {
+    for (segy::Backend backend : {segy::Backend::MMap, segy::Backend::PRead}) {
+      test_file(name, backend);
+    }
+  }
+  return test::report();
+}
@@ -0,0 +1,116 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_pipeline.cpp
+** @Time: 2026/10/20 09:26:14
+** @Version: 1.0
+** @Description : the pipelined tofile writes what the mmap one does
+*********************************************************************/
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "output.h"
+#include "pipeline.h"
+
+namespace {
+
+const float kFill = -1;
+
+void open_segy(segy::SegyIO &segy, bool line2d) {
+  segy.setVerbose(false);
+  segy.setFillNoValue(kFill);
+  if (line2d) {
+    segy.setLine2D();
+  }
+}
+
+void test_file(const std::string &name, bool line2d = false) {
+  segy::SegyIO ref(name);
+  open_segy(ref, line2d);
+  ref.tofile("mmap.bin");
+  std::string expected = test::read_file("mmap.bin");
+  CHECK(!expected.empty());
+
+  for (auto backend : {segy::Backend::MMap, segy::Backend::PRead,
+                       segy::Backend::IOUring}) {
+    for (int threads : {1, 3, 0}) {
+      // one trace, a few lines and everything in flight
+      for (uint64_t memory : {uint64_t(1), uint64_t(100000),
+                              segy::kPipelineMemory}) {
+        segy::SegyIO segy(name, backend);
+        open_segy(segy, line2d);
+        segy.setWriteMode(segy::WriteMode::Pipeline);
+        segy.setThreads(threads);
+        segy.setMemoryBudget(memory);
+        segy.setDirectIO(threads == 3);
+        segy.tofile("pipeline.bin");
+        bool same = test::read_file("pipeline.bin") == expected;
+        if (!same) {
+          std::printf("%s: backend %d, %d threads, %lu bytes\n", name.c_str(),
+                      static_cast<int>(backend), threads,
+                      static_cast<unsigned long>(memory));
+        }
+        CHECK(same);
+      }
+    }
+  }
+}
+
+// blocks of trace size keep O_DIRECT on up to the unaligned tail
+void test_direct() {
+  int fd = segy::create_file("direct.bin", 0);
+  std::string expected;
+  {
+    segy::StreamWriter writer(fd, 0, 8192);
+    if (!writer.setDirect(true)) {
+      // O_DIRECT is unsupported by this file system
+      close(fd);
+      return;
+    }
+    for (int i = 0; i < 60; i++) {
+      std::string block(segy::kTraceHeaderSize + 4 * (100 + i),
+                        static_cast<char>('a' + i % 26));
+      writer.write(block.data(), block.size());
+      expected += block;
+    }
+    CHECK(fcntl(fd, F_GETFL) & O_DIRECT);
+    writer.close();
+  }
+  close(fd);
+  CHECK(test::read_file("direct.bin") == expected);
+}
+
+} // namespace
+
+int main() {
+  test_direct();
+  std::set<std::pair<int, int>> missing = {{1, 0}, {2, 7}, {3, 3}, {4, 7}};
+  test::write_volume("irregular.sgy", 12, 8, 9, missing);
+  test_file("irregular.sgy");
+  test::write_volume("variable.sgy", 12, 5, 9, {}, true);
+  test_file("variable.sgy");
+  test::write_volume("ibm.sgy", 7, 30, 11, {}, false, 1);
+  test_file("ibm.sgy");
+  test::write_volume("line.sgy", 1, 300, 6, {{0, 3}, {0, 100}});
+  test_file("line.sgy", true);
+  // blocks of many lines
+  test::write_volume("large.sgy", 40, 200, 300, {{5, 0}, {39, 199}});
+  test_file("large.sgy");
+
+  // the shape given by set_size()
+  for (auto mode : {segy::WriteMode::MMap, segy::WriteMode::Pipeline}) {
+    segy::SegyIO segy("ibm.sgy");
+    segy.setVerbose(false);
+    segy.set_size(11, 15, 14);
+    segy.setWriteMode(mode);
+    segy.setMemoryBudget(1);
+    segy.tofile("set_size.bin");
+    CHECK(test::read_floats("set_size.bin") ==
+          test::expected_volume(7, 30, 11, {}, false, 0));
+  }
+  return test::report();
+}
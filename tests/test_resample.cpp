@@ -0,0 +1,182 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_resample.cpp
+** @Time: 2026/10/20 11:34:25
+** @Version: 1.0
+** @Description : time axis resampling fused into the reads
+*********************************************************************/
+
+#include <algorithm>
+
+#include "common.h"
+#include "resample.h"
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+bool is_nan(float v) { return v != v; }
+
+std::vector<float> sine(int n, double f) {
+  std::vector<float> v(n);
+  for (int i = 0; i < n; i++) {
+    v[i] = static_cast<float>(std::sin(2 * kPi * f * i + 0.3));
+  }
+  return v;
+}
+
+// a sine (f cycles per input sample) below the output Nyquist frequency is
+// kept away from the mirrored ends, one above it is filtered out
+void test_sine(int in, int out, double f, double tol) {
+  segy::Resampler r(in, out);
+  int n = 400;
+  std::vector<float> x = sine(n, f);
+  int m = r.out_size(n);
+  std::vector<float> y(m);
+  r.apply(x.data(), 0, n, n, 0, m, y.data());
+  double error = 0;
+  for (int j = m / 8; j < m - m / 8; j++) {
+    double t = static_cast<double>(j) * out / in;
+    double e = f < 0.5 * in / out ? std::sin(2 * kPi * f * t + 0.3) : 0;
+    error = std::max(error, std::fabs(y[j] - e));
+  }
+  CHECK(error <= tol);
+
+  // the output samples of sub-ranges are the same
+  bool ok = true;
+  for (int start : {0, 1, 5, m / 2, m - 3}) {
+    int count = std::min(7, m - start);
+    int first, last;
+    r.input_range(start, count, first, last);
+    int lo = std::max(first - r.half(), 0);
+    int hi = std::min(last + r.half(), n);
+    std::vector<float> z(count);
+    r.apply(x.data() + lo, lo, hi, n, start, count, z.data());
+    for (int k = 0; k < count; k++) {
+      ok &= z[k] == y[start + k];
+    }
+  }
+  CHECK(ok);
+}
+
+// upsampling by 2 keeps the input samples
+void test_upsample() {
+  segy::Resampler r(2000, 1000);
+  std::vector<float> x = sine(50, 0.1);
+  std::vector<float> y(r.out_size(50));
+  r.apply(x.data(), 0, 50, 50, 0, y.size(), y.data());
+  bool ok = y.size() == 99;
+  for (int i = 0; i < 50; i++) {
+    ok &= std::fabs(y[2 * i] - x[i]) < 1e-6;
+  }
+  CHECK(ok);
+}
+
+// reads of the file equal the Resampler on each trace
+void test_file(const std::string &name, int interval) {
+  segy::SegyIO segy(name);
+  segy.setVerbose(false);
+  segy.setFillNoValue(NAN);
+  std::vector<float> raw = test::read_all(segy);
+  int nx0 = segy.shape(0);
+  segy.setResample(interval);
+  segy.setThreads(1);
+  int nx = segy.shape(0), ny = segy.shape(1), nz = segy.shape(2);
+  size_t n = static_cast<size_t>(nx) * ny * nz;
+  segy::Resampler r(2000, interval);
+  CHECK(nx == r.out_size(nx0) && segy.sample_interval() == interval);
+  CHECK(segy.get_metaInfo().sizeX == nx);
+
+  std::vector<float> data(n);
+  segy.read(data.data());
+  bool ok = true;
+  for (size_t t = 0; t < static_cast<size_t>(ny) * nz; t++) {
+    // the samples of the trace, shorter ones end with the fill
+    int len = 0;
+    while (len < nx0 && !is_nan(raw[t * nx0 + len])) {
+      len++;
+    }
+    std::vector<float> expected(nx, NAN);
+    r.apply(raw.data() + t * nx0, 0, len, len, 0, r.out_size(len),
+            expected.data());
+    for (int k = 0; k < nx; k++) {
+      float e = expected[k], g = data[t * nx + k];
+      ok &= is_nan(e) ? is_nan(g)
+                      : std::fabs(g - e) <= 1e-3f * (std::fabs(e) + 1);
+    }
+  }
+  CHECK(ok);
+
+  // more threads and another backend
+  std::vector<float> other(n);
+  segy.setThreads(4);
+  segy.read(other.data());
+  CHECK(memcmp(other.data(), data.data(), n * sizeof(float)) == 0);
+  segy::SegyIO pread(name, segy::Backend::PRead);
+  pread.setVerbose(false);
+  pread.setFillNoValue(NAN);
+  pread.setResample(interval);
+  pread.setThreads(3);
+  pread.read(other.data());
+  CHECK(memcmp(other.data(), data.data(), n * sizeof(float)) == 0);
+
+  // a patch in the middle of the trace
+  int x0 = nx / 3, x1 = std::min(x0 + 5, nx);
+  std::vector<float> patch((x1 - x0) * 2 * 3);
+  segy.read(patch.data(), x0, x1, 1, 3, 2, 5);
+  ok = true;
+  for (int z = 0; z < 3; z++) {
+    for (int y = 0; y < 2; y++) {
+      for (int x = 0; x < x1 - x0; x++) {
+        float e = data[((z + 2) * ny + y + 1) * nx + x + x0];
+        float g = patch[(z * 2 + y) * (x1 - x0) + x];
+        ok &= is_nan(e) ? is_nan(g) : g == e;
+      }
+    }
+  }
+  CHECK(ok);
+
+  segy.setWriteMode(segy::WriteMode::Pipeline);
+  segy.tofile("resample.bin");
+  std::vector<float> out = test::read_floats("resample.bin");
+  CHECK(out.size() == n && memcmp(out.data(), data.data(), n * 4) == 0);
+
+  std::vector<float> slice(ny * nz);
+  segy.read_time_slice(slice.data(), nx - 1);
+  ok = true;
+  for (int t = 0; t < ny * nz; t++) {
+    float e = data[t * nx + nx - 1];
+    ok &= is_nan(e) ? is_nan(slice[t]) : slice[t] == e;
+  }
+  CHECK(ok);
+}
+
+} // namespace
+
+int main() {
+  test_sine(1000, 2000, 0.05, 2e-3);
+  test_sine(2000, 1000, 0.05, 2e-3);
+  test_sine(3000, 2000, 0.07, 2e-3);
+  test_sine(1000, 4000, 0.02, 2e-3);
+  test_sine(1000, 2000, 0.4, 0.02);
+  test_upsample();
+
+  std::set<std::pair<int, int>> missing = {{1, 0}, {2, 7}, {3, 3}};
+  test::write_volume("irregular.sgy", 12, 8, 9, missing);
+  test::write_volume("variable.sgy", 12, 5, 9, {}, true);
+  for (const char *name : {"irregular.sgy", "variable.sgy"}) {
+    for (int interval : {1000, 3000, 4000}) {
+      test_file(name, interval);
+    }
+  }
+
+  segy::SegyIO segy("irregular.sgy");
+  segy.setVerbose(false);
+  CHECK_THROWS(segy.setResample(-1));
+  segy.setResample(2000);
+  CHECK(segy.shape(0) == 9 && segy.sample_interval() == 2000);
+  return test::report();
+}
@@ -0,0 +1,102 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_share.cpp
+** @Time: 2026/10/20 13:25:44
+** @Version: 1.0
+** @Description : segy files created with the headers of another one
+*********************************************************************/
+
+#include "common.h"
+
+namespace {
+
+void test_file(const std::string &name, int format) {
+  segy::SegyIO segy(name);
+  segy.setVerbose(false);
+  segy.setFillNoValue(0);
+  std::vector<float> vol = test::read_all(segy);
+  int nx = segy.shape(0), ny = segy.shape(1), nz = segy.shape(2);
+  int64_t count = segy.trace_count();
+
+  // arrays exact in IBM floats
+  std::vector<std::vector<float>> arrays(3, vol);
+  for (int k = 0; k < 3; k++) {
+    for (float &f : arrays[k]) {
+      f = f * (k + 1) - 7.25f * k;
+    }
+  }
+  segy::create_by_sharing_header("one.sgy", name, arrays[1].data(), nx, ny,
+                                 nz);
+  std::string source = test::read_file(name);
+  std::string one = test::read_file("one.sgy");
+
+  std::vector<std::string> names = {"batch_0.sgy", "batch_1.sgy",
+                                    "batch_2.sgy"};
+  for (int threads : {1, 2, 0}) {
+    segy::create_by_sharing_header(
+        names, name, {arrays[0].data(), arrays[1].data(), arrays[2].data()},
+        nx, ny, nz, segy::kDefaultInlineField, segy::kDefaultCrosslineField,
+        threads);
+    for (int k = 0; k < 3; k++) {
+      segy::SegyIO out(names[k]);
+      out.setVerbose(false);
+      out.setFillNoValue(0);
+      std::vector<float> back = test::read_all(out);
+      // the missing traces aren't written
+      bool ok = true;
+      for (size_t i = 0; i < vol.size(); i++) {
+        ok &= back[i] == arrays[k][i] || (vol[i] == 0 && back[i] == 0);
+      }
+      CHECK(ok);
+      CHECK(out.get_metaInfo().data_format == format);
+
+      // the headers are the ones of the source
+      std::string bytes = test::read_file(names[k]);
+      CHECK(bytes.size() == source.size() &&
+            bytes.compare(0, 3600, source, 0, 3600) == 0);
+      ok = true;
+      uint64_t trace_bytes = segy::kTraceHeaderSize + 4 * nx;
+      for (int64_t t = 0; t < count && ok; t++) {
+        uint64_t offset = 3600 + t * trace_bytes;
+        ok &= bytes.compare(offset, segy::kTraceHeaderSize, source, offset,
+                            segy::kTraceHeaderSize) == 0;
+      }
+      CHECK(ok);
+    }
+    // the same as one at a time
+    CHECK(test::read_file(names[1]) == one);
+  }
+
+  std::vector<const float *> two = {arrays[0].data(), arrays[1].data()};
+  CHECK_THROWS(segy::create_by_sharing_header(names, name, two, nx, ny, nz));
+  CHECK_THROWS(segy::create_by_sharing_header(
+      names, name, {arrays[0].data(), arrays[1].data(), arrays[2].data()},
+      nx + 1, ny, nz));
+}
+
+} // namespace
+
+int main() {
+  test::write_volume("regular.sgy", 7, 6, 13);
+  test_file("regular.sgy", 5);
+  std::set<std::pair<int, int>> missing = {{0, 0}, {2, 5}, {4, 3}, {6, 5}};
+  test::write_volume("irregular.sgy", 7, 6, 13, missing, false, 1);
+  test_file("irregular.sgy", 1);
+
+  // the headers can't be shared from variable length traces, nor from a
+  // compressed file, that has no mapping to copy them from
+  std::vector<float> vol(7 * 6 * 13);
+  test::write_volume("variable.sgy", 7, 6, 13, {}, true);
+  CHECK_THROWS(segy::create_by_sharing_header(
+      std::vector<std::string>{"out.sgy"}, "variable.sgy", {vol.data()}, 13,
+      6, 7));
+  test::write_file("regular.sgy.zst",
+                   test::zstd_frame(test::read_file("regular.sgy")));
+  CHECK_THROWS(segy::create_by_sharing_header(
+      std::vector<std::string>{"out.sgy"}, "regular.sgy.zst", {vol.data()},
+      13, 6, 7));
+  return test::report();
+}
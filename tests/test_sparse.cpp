@@ -0,0 +1,80 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_sparse.cpp
+** @Time: 2026/10/20 09:41:50
+** @Version: 1.0
+** @Description : sparse tofile output of surveys with empty areas
+*********************************************************************/
+
+#include <sys/stat.h>
+
+#include "common.h"
+
+namespace {
+
+const int nz = 20, ny = 60, nx = 200;
+
+long blocks(const std::string &name) {
+  struct stat st;
+  return stat(name.c_str(), &st) == 0 ? static_cast<long>(st.st_blocks) : -1;
+}
+
+void test_modes(const std::set<std::pair<int, int>> &missing) {
+  segy::SegyIO ref("sparse.sgy");
+  ref.setVerbose(false);
+  ref.tofile("dense.bin");
+  std::string expected = test::read_file("dense.bin");
+  CHECK(test::read_floats("dense.bin") ==
+        test::expected_volume(nz, ny, nx, missing, false, 0));
+
+  for (auto mode : {segy::WriteMode::MMap, segy::WriteMode::Stream,
+                    segy::WriteMode::Pipeline}) {
+    for (bool direct : {false, true}) {
+      segy::SegyIO segy("sparse.sgy");
+      segy.setVerbose(false);
+      segy.setWriteMode(mode);
+      segy.setSparse(true);
+      segy.setDirectIO(direct);
+      segy.setMemoryBudget(300000);
+      segy.tofile("sparse.bin");
+      CHECK(test::read_file("sparse.bin") == expected);
+      CHECK(segy.sparse_bytes() > 0);
+      CHECK(blocks("sparse.bin") < blocks("dense.bin") * 0.8);
+
+      // read_binary() skips the holes
+      std::vector<float> data(nx * ny * nz, 5.f);
+      segy::read_binary("sparse.bin", data.data(), nx, ny, nz);
+      CHECK(memcmp(data.data(), expected.data(), expected.size()) == 0);
+    }
+  }
+
+  // the fill value isn't 0: nothing to skip
+  segy::SegyIO segy("sparse.sgy");
+  segy.setVerbose(false);
+  segy.setSparse(true);
+  segy.setFillNoValue(-1);
+  segy.tofile("sparse.bin");
+  CHECK(segy.sparse_bytes() == 0);
+  CHECK(test::read_floats("sparse.bin") ==
+        test::expected_volume(nz, ny, nx, missing, false, -1));
+}
+
+} // namespace
+
+int main() {
+  // inlines 4 to 15 keep only their first crossline
+  std::set<std::pair<int, int>> missing;
+  for (int z = 4; z < 16; z++) {
+    for (int y = 1; y < ny; y++) {
+      missing.insert(std::make_pair(z, y));
+    }
+  }
+  test::write_volume("sparse.sgy", nz, ny, nx, missing);
+  test_modes(missing);
+
+  CHECK_THROWS(segy::read_binary("sparse.bin", nullptr, nx, ny, nz + 1));
+  return test::report();
+}
@@ -0,0 +1,137 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_stats.cpp
+** @Time: 2026/10/20 10:37:12
+** @Version: 1.0
+** @Description : statistics accumulated while reading
+*********************************************************************/
+
+#include <algorithm>
+
+#include "common.h"
+#include "stats.h"
+
+namespace {
+
+// far from the samples, so a counted fill value shows
+const float kFill = 1e6;
+
+float percentile(std::vector<float> v, double p) {
+  std::sort(v.begin(), v.end());
+  double rank = p / 100 * (v.size() - 1);
+  size_t k = static_cast<size_t>(rank);
+  return k + 1 < v.size() ? v[k] + (rank - k) * (v[k + 1] - v[k]) : v[k];
+}
+
+// `stats` are the ones of the samples `live`
+bool same(const segy::SampleStats &stats, const std::vector<float> &live) {
+  double sum = 0, sum2 = 0;
+  for (float v : live) {
+    sum += v;
+    sum2 += static_cast<double>(v) * v;
+  }
+  double mean = sum / live.size();
+  double std = std::sqrt(sum2 / live.size() - mean * mean);
+  bool ok = stats.count() == static_cast<int64_t>(live.size()) &&
+            stats.min() == *std::min_element(live.begin(), live.end()) &&
+            stats.max() == *std::max_element(live.begin(), live.end()) &&
+            std::fabs(stats.mean() - mean) <= 1e-9 * std::fabs(mean) &&
+            std::fabs(stats.std() - std) <= 1e-6 * std;
+  for (double p : {0.0, 1.0, 25.0, 50.0, 99.0, 100.0}) {
+    float e = percentile(live, p);
+    ok &= std::fabs(stats.percentile(p) - e) <= 0.01 * std::fabs(e) + 1e-3;
+  }
+  return ok;
+}
+
+// the samples of `data` that aren't the fill value
+std::vector<float> live_samples(const std::vector<float> &data) {
+  std::vector<float> live;
+  for (float v : data) {
+    if (v != kFill) {
+      live.push_back(v);
+    }
+  }
+  return live;
+}
+
+void test_file(const std::string &name, bool line2d, bool dead) {
+  segy::SegyIO segy(name);
+  segy.setVerbose(false);
+  segy.setFillNoValue(kFill);
+  if (line2d) {
+    segy.setLine2D();
+  }
+  segy.setDetectDead(dead);
+  std::vector<float> expected = test::read_all(segy);
+  std::vector<float> data(expected.size());
+  segy::SampleStats stats = segy.read_with_stats(data.data());
+  CHECK(data == expected);
+  CHECK(same(stats, live_samples(expected)));
+
+  // a patch
+  int nx = segy.shape(0), ny = segy.shape(1), nz = segy.shape(2);
+  int z0 = nz > 1 ? 1 : 0;
+  std::vector<float> patch((nz - z0) * (ny - 1) * 3);
+  stats = segy.read_with_stats(patch.data(), 2, 5, 1, ny, z0, nz);
+  std::vector<float> part;
+  for (int z = z0; z < nz; z++) {
+    for (int y = 1; y < ny; y++) {
+      for (int x = 2; x < 5; x++) {
+        part.push_back(expected[(z * ny + y) * nx + x]);
+      }
+    }
+  }
+  CHECK(patch == part);
+  CHECK(same(stats, live_samples(part)));
+}
+
+void test_accumulate() {
+  std::vector<float> v(100003);
+  for (size_t i = 0; i < v.size(); i++) {
+    v[i] = (i * 7919 % 100003) - 50000.5f;
+  }
+  v[5] = NAN;
+  segy::SampleStats all;
+  all.add(v.data(), v.size());
+  std::vector<float> live(v);
+  live.erase(live.begin() + 5);
+  CHECK(same(all, live));
+
+  // merged halves are the whole
+  segy::SampleStats a, b;
+  a.add(v.data(), 40000);
+  b.add(v.data() + 40000, v.size() - 40000);
+  a.merge(b);
+  CHECK(a.count() == all.count() && a.min() == all.min() &&
+        a.max() == all.max() && a.histogram() == all.histogram());
+  CHECK(std::fabs(a.mean() - all.mean()) < 1e-9);
+
+  segy::SampleStats empty;
+  CHECK(empty.count() == 0);
+}
+
+} // namespace
+
+int main() {
+  std::set<std::pair<int, int>> missing = {{1, 0}, {2, 7}, {3, 3}};
+  test::write_volume("irregular.sgy", 6, 8, 9, missing);
+  test_file("irregular.sgy", false, false);
+  test::write_volume("variable.sgy", 6, 5, 9, {}, true);
+  test_file("variable.sgy", false, false);
+  test::write_volume("line.sgy", 1, 50, 6, {{0, 3}});
+  test_file("line.sgy", true, false);
+
+  std::vector<test::Trace> traces = test::volume_traces(4, 5, 7);
+  traces[3].code = 2;
+  test::Layout layout;
+  layout.sizeX = 7;
+  test::write_segy("dead.sgy", layout, traces);
+  test_file("dead.sgy", false, true);
+
+  test_accumulate();
+  return test::report();
+}
@@ -0,0 +1,171 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_stream.cpp
+** @Time: 2026/10/20 08:44:31
+** @Version: 1.0
+** @Description : sequential reads of segy from pipes
+*********************************************************************/
+
+#include <thread>
+#include <unistd.h>
+
+#include "common.h"
+#include "stream.h"
+
+namespace {
+
+const float kFill = -1;
+
+// a few bytes at a time, to cross the buffer ends anywhere
+class TrickleSource : public segy::ByteSource {
+public:
+  explicit TrickleSource(const std::string &bytes) : m_bytes(bytes) {}
+  size_t read(char *dst, size_t n) override {
+    n = std::min(n, std::min<size_t>(1 + m_pos % 7, m_bytes.size() - m_pos));
+    memcpy(dst, m_bytes.data() + m_pos, n);
+    m_pos += n;
+    return n;
+  }
+
+private:
+  std::string m_bytes;
+  size_t m_pos = 0;
+};
+
+// the output of SegyStream fed by a pipe
+std::string stream_tofile(const std::string &name, int min_crossline = 0,
+                          int max_crossline = 0) {
+  std::string bytes = test::read_file(name);
+  int fds[2];
+  CHECK(pipe(fds) == 0);
+  std::thread writer([&] {
+    for (size_t pos = 0; pos < bytes.size();) {
+      ssize_t n = write(fds[1], bytes.data() + pos, bytes.size() - pos);
+      if (n <= 0) {
+        break;
+      }
+      pos += n;
+    }
+    close(fds[1]);
+  });
+  {
+    segy::SegyStream stream(fds[0]);
+    stream.setFillNoValue(kFill);
+    if (max_crossline > 0) {
+      stream.setCrosslineRange(min_crossline, max_crossline);
+    }
+    stream.tofile("stream.bin");
+  }
+  writer.join();
+  close(fds[0]);
+  return test::read_file("stream.bin");
+}
+
+std::string segy_tofile(const std::string &name) {
+  segy::SegyIO segy(name);
+  segy.setVerbose(false);
+  segy.setFillNoValue(kFill);
+  segy.tofile("segy.bin");
+  return test::read_file("segy.bin");
+}
+
+void test_same_as_segy() {
+  // the first line misses its first traces, the later lines extend the
+  // crossline range and the written lines are rearranged
+  std::set<std::pair<int, int>> missing = {{0, 0}, {0, 1}, {2, 7}, {3, 3}};
+  test::write_volume("irregular.sgy", 6, 8, 9, missing);
+  test::write_volume("variable.sgy", 6, 5, 9, {}, true);
+  test::write_volume("ibm.sgy", 4, 300, 5, {{1, 250}}, false, 1);
+  for (const char *name : {"irregular.sgy", "variable.sgy", "ibm.sgy"}) {
+    std::string expected = segy_tofile(name);
+    CHECK(!expected.empty() && stream_tofile(name) == expected);
+  }
+  CHECK(test::read_floats("stream.bin") ==
+        test::expected_volume(4, 300, 5, {{1, 250}}, false, kFill));
+
+  // trickled bytes, and line by line
+  std::string bytes = test::read_file("irregular.sgy");
+  segy::SegyStream stream(
+      std::unique_ptr<segy::ByteSource>(new TrickleSource(bytes)));
+  segy::StreamLine line;
+  int lines = 0;
+  int64_t traces = 0;
+  bool ok = true;
+  while (stream.next_line(line)) {
+    int z = line.inline_num - 100;
+    for (size_t i = 0; i < line.crosslines.size(); i++) {
+      int y = line.crosslines[i] - 10;
+      ok &= !missing.count(std::make_pair(z, y));
+      for (int x = 0; x < 9; x++) {
+        ok &= line.data[i * 9 + x] == test::value(z, y, x);
+      }
+    }
+    lines++;
+    traces += line.crosslines.size();
+  }
+  CHECK(ok && lines == 6 && traces == 6 * 8 - 4);
+}
+
+// the crossline range set is kept, the traces out of it are dropped
+void test_range() {
+  test::write_volume("regular.sgy", 5, 8, 4);
+  std::string out = stream_tofile("regular.sgy", 12, 13);
+  std::vector<float> expected;
+  for (int z = 0; z < 5; z++) {
+    for (int y = 2; y < 4; y++) {
+      for (int x = 0; x < 4; x++) {
+        expected.push_back(test::value(z, y, x));
+      }
+    }
+  }
+  CHECK(test::read_floats("stream.bin") == expected);
+
+  // a range wider than the traces is filled
+  stream_tofile("regular.sgy", 8, 20);
+  std::vector<float> wide = test::read_floats("stream.bin");
+  CHECK(wide.size() == 5 * 13 * 4);
+  CHECK(wide[0] == kFill && wide[2 * 4 + 1] == test::value(0, 0, 1));
+}
+
+// a trace longer than the binary header tells is cut to it
+void test_long_trace() {
+  test::Layout layout;
+  layout.sizeX = 4;
+  layout.variable = true;
+  std::vector<test::Trace> traces = test::volume_traces(2, 3, 4);
+  traces[4].samples.push_back(-5);
+  traces[4].samples.push_back(-6);
+  test::write_segy("long.sgy", layout, traces);
+  stream_tofile("long.sgy");
+  CHECK(test::read_floats("stream.bin") ==
+        test::expected_volume(2, 3, 4, {}, false, kFill));
+}
+
+void test_errors() {
+  // inlines out of order
+  std::vector<test::Trace> traces = test::volume_traces(3, 2, 3);
+  std::swap(traces[0], traces[5]);
+  test::Layout layout;
+  layout.sizeX = 3;
+  test::write_segy("unsorted.sgy", layout, traces);
+  CHECK_THROWS(segy::SegyStream("unsorted.sgy").tofile("stream.bin"));
+
+  // the stream ends in a trace
+  test::write_volume("truncated.sgy", 3, 2, 3);
+  std::string bytes = test::read_file("truncated.sgy");
+  test::write_file("truncated.sgy", bytes.substr(0, bytes.size() - 5));
+  CHECK_THROWS(segy::SegyStream("truncated.sgy").tofile("stream.bin"));
+}
+
+} // namespace
+
+int main() {
+  test_same_as_segy();
+  test_range();
+  test_long_trace();
+  test_errors();
+  return test::report();
+}
@@ -0,0 +1,200 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_transform.cpp
+** @Time: 2026/10/20 10:55:43
+** @Version: 1.0
+** @Description : clipping and scaling fused into the reads
+*********************************************************************/
+
+#include <algorithm>
+
+#include "common.h"
+#include "transform.h"
+
+namespace {
+
+bool is_nan(float v) { return v != v; }
+
+// NaN where `expected` is NaN, else within a relative `tol`
+bool same(const std::vector<float> &got, const std::vector<float> &expected,
+          float tol = 0) {
+  bool ok = got.size() == expected.size();
+  for (size_t i = 0; ok && i < got.size(); i++) {
+    ok &= is_nan(expected[i])
+              ? is_nan(got[i])
+              : std::fabs(got[i] - expected[i]) <=
+                    tol * (std::fabs(expected[i]) + 1);
+  }
+  return ok;
+}
+
+// RMS of the samples of data[begin, end) that aren't NaN
+double rms(const std::vector<float> &data, size_t begin, size_t end) {
+  double sum2 = 0;
+  size_t n = 0;
+  for (size_t i = begin; i < end; i++) {
+    if (!is_nan(data[i])) {
+      sum2 += static_cast<double>(data[i]) * data[i];
+      n++;
+    }
+  }
+  return std::sqrt(sum2 / n);
+}
+
+// every length, so the SIMD body and the tail are both run
+void test_clip_samples() {
+  for (int n = 0; n < 40; n++) {
+    std::vector<float> v(n + 1);
+    for (int i = 0; i <= n; i++) {
+      v[i] = (i % 5 - 2) * 3.5f;
+    }
+    if (n > 3) {
+      v[3] = NAN;
+      v[1] = INFINITY;
+      v[2] = -INFINITY;
+    }
+    std::vector<float> expected(v);
+    for (float &x : expected) {
+      x = is_nan(x) ? x : std::min(std::max(x, -4.f), 4.f);
+    }
+    // from the second element, unaligned
+    segy::clip_samples(v.data() + 1, n, 4);
+    expected[0] = v[0];
+    CHECK(same(v, expected));
+  }
+}
+
+void test_file(const std::string &name) {
+  segy::SegyIO segy(name);
+  segy.setVerbose(false);
+  segy.setFillNoValue(NAN);
+  std::vector<float> raw = test::read_all(segy);
+  int nx = segy.shape(0), ny = segy.shape(1), nz = segy.shape(2);
+  size_t n = raw.size();
+  std::vector<float> data(n), expected(n);
+  auto run = [&](const segy::Transform &t) {
+    segy.setTransform(t);
+    segy.read(data.data());
+  };
+
+  segy::Transform t;
+  t.clip = 50000;
+  run(t);
+  for (size_t i = 0; i < n; i++) {
+    expected[i] =
+        is_nan(raw[i]) ? raw[i] : std::min(std::max(raw[i], -5e4f), 5e4f);
+  }
+  CHECK(same(data, expected));
+
+  t = segy::Transform();
+  t.scaling = segy::Scaling::Global;
+  t.scale = 2;
+  run(t);
+  for (size_t i = 0; i < n; i++) {
+    expected[i] = raw[i] * 2;
+  }
+  CHECK(same(data, expected));
+  t.scale = 0;
+  run(t);
+  CHECK(std::fabs(rms(data, 0, n) - 1) < 1e-4);
+
+  t = segy::Transform();
+  t.scaling = segy::Scaling::Inline;
+  run(t);
+  bool ok = true;
+  size_t line = static_cast<size_t>(nx) * ny;
+  for (int z = 0; z < nz; z++) {
+    ok &= std::fabs(rms(data, z * line, (z + 1) * line) - 1) < 1e-4;
+  }
+  CHECK(ok);
+
+  // a patch takes the gains of the whole inlines
+  std::vector<float> full(data), patch(2 * 3 * 4);
+  segy.read(patch.data(), 2, 6, 1, 4, 3, 5);
+  ok = true;
+  for (int z = 0; z < 2; z++) {
+    for (int y = 0; y < 3; y++) {
+      for (int x = 0; x < 4; x++) {
+        float e = full[((z + 3) * ny + y + 1) * nx + x + 2];
+        float g = patch[(z * 3 + y) * 4 + x];
+        ok &= is_nan(e) ? is_nan(g) : g == e;
+      }
+    }
+  }
+  CHECK(ok);
+
+  t = segy::Transform();
+  t.scaling = segy::Scaling::TraceRMS;
+  run(t);
+  ok = true;
+  for (size_t i = 0; i < n; i += nx) {
+    ok &= is_nan(data[i]) || std::fabs(rms(data, i, i + nx) - 1) < 1e-4;
+  }
+  CHECK(ok);
+
+  t = segy::Transform();
+  t.scaling = segy::Scaling::AGC;
+  t.agc_window = 4;
+  run(t);
+  for (size_t i = 0; i < n; i += nx) {
+    for (int x = 0; x < nx; x++) {
+      int lo = std::max(x - 2, 0), hi = std::min(x + 2, nx);
+      double g = rms(raw, i + lo, i + hi);
+      expected[i + x] = g > 0 ? raw[i + x] / g : raw[i + x];
+    }
+  }
+  CHECK(same(data, expected, 1e-5f));
+
+  // the pipelined tofile transforms the same way
+  segy.setWriteMode(segy::WriteMode::Pipeline);
+  segy.setThreads(3);
+  segy.tofile("transform.bin");
+  CHECK(same(test::read_floats("transform.bin"), data));
+
+  t = segy::Transform();
+  t.clip_percentile = 100;
+  run(t);
+  CHECK(same(data, raw));
+  t.clip_percentile = 50;
+  run(t);
+  float clip = segy.clip_estimate(50);
+  for (size_t i = 0; i < n; i++) {
+    expected[i] =
+        is_nan(raw[i]) ? raw[i] : std::min(std::max(raw[i], -clip), clip);
+  }
+  CHECK(clip > 0 && same(data, expected));
+}
+
+// NaN samples of the traces pass the clip
+void test_nan_samples() {
+  std::vector<test::Trace> traces = test::volume_traces(2, 3, 9);
+  traces[1].samples[4] = NAN;
+  traces[4].samples[0] = NAN;
+  test::Layout layout;
+  layout.sizeX = 9;
+  test::write_segy("nan.sgy", layout, traces);
+  segy::SegyIO segy("nan.sgy");
+  segy.setVerbose(false);
+  segy::Transform t;
+  t.clip = 5;
+  segy.setTransform(t);
+  std::vector<float> data = test::read_all(segy);
+  CHECK(is_nan(data[9 + 4]) && is_nan(data[4 * 9]));
+  CHECK(data[9 + 3] == 5 && data[0] == 0);
+}
+
+} // namespace
+
+int main() {
+  test_clip_samples();
+  std::set<std::pair<int, int>> missing = {{1, 0}, {2, 7}, {3, 3}, {4, 7}};
+  test::write_volume("irregular.sgy", 12, 8, 9, missing);
+  test_file("irregular.sgy");
+  test::write_volume("regular.sgy", 12, 7, 11);
+  test_file("regular.sgy");
+  test_nan_samples();
+  return test::report();
+}
@@ -0,0 +1,166 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_update.cpp
+** @Time: 2026/10/20 14:12:36
+** @Version: 1.0
+** @Description : in place updates of the samples of a segy file
+*********************************************************************/
+
+#include <algorithm>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "zonemap.h"
+
+namespace {
+
+const float kFill = -1;
+
+std::vector<float> read_fresh(const std::string &name, segy::Backend backend) {
+  segy::SegyIO segy(name, backend);
+  segy.setVerbose(false);
+  segy.setFillNoValue(kFill);
+  return test::read_all(segy);
+}
+
+bool exists(const std::string &name) {
+  struct stat st;
+  return stat(name.c_str(), &st) == 0;
+}
+
+// the trace headers of `bytes`, at the offsets of `segy`
+std::string headers(const std::string &bytes, segy::SegyIO &segy) {
+  std::string out = bytes.substr(0, 3600);
+  uint64_t offset = 3600;
+  for (int64_t t = 0; t < segy.trace_count(); t++) {
+    out += bytes.substr(offset, segy::kTraceHeaderSize);
+    int16_t count;
+    memcpy(&count, &bytes[offset + segy::kTSampleCountField - 1], 2);
+    offset += segy::kTraceHeaderSize + 4 * segy::swap_endian(count);
+  }
+  return out;
+}
+
+void test_file(const std::string &source, segy::Backend backend) {
+  const std::string name = "update.sgy";
+  std::string original = test::read_file(source);
+  test::write_file(name, original);
+  segy::SegyIO segy(name, backend);
+  segy.setVerbose(false);
+  segy.setFillNoValue(kFill);
+  std::vector<float> vol = test::read_all(segy);
+  int nx = segy.shape(0), ny = segy.shape(1);
+
+  // a patch over the ends of the short traces and the missing ones, the
+  // values are exact in IBM floats
+  int x0 = 1, x1 = nx, y0 = 1, y1 = 4, z0 = 1, z1 = 3;
+  std::vector<float> patch((x1 - x0) * (y1 - y0) * (z1 - z0));
+  for (size_t i = 0; i < patch.size(); i++) {
+    patch[i] = -2.f - i * 0.25f;
+  }
+  segy.write(patch.data(), x0, x1, y0, y1, z0, z1);
+  std::vector<float> expected = vol;
+  for (int z = z0; z < z1; z++) {
+    for (int y = y0; y < y1; y++) {
+      for (int x = x0; x < x1; x++) {
+        size_t i = (static_cast<size_t>(z) * ny + y) * nx + x;
+        if (vol[i] != kFill) {
+          expected[i] = patch[((z - z0) * (y1 - y0) + y - y0) * (x1 - x0) +
+                              x - x0];
+        }
+      }
+    }
+  }
+  std::vector<float> back(vol.size());
+  segy.read(back.data());
+  CHECK(back == expected);
+  // another reader sees the new samples, the headers are unchanged
+  CHECK(read_fresh(name, segy::Backend::MMap) == expected);
+  CHECK(read_fresh(name, segy::Backend::PRead) == expected);
+  std::string updated = test::read_file(name);
+  CHECK(updated.size() == original.size() &&
+        headers(updated, segy) == headers(original, segy));
+
+  // zeros make whole traces dead, the samples put back make them live
+  segy.setDetectDead(true);
+  segy.scan();
+  int64_t dead = segy.dead_count();
+  segy.fill(0, 0, nx, 0, 2, 0, 1);
+  std::vector<float> muted(2 * nx);
+  segy.read(muted.data(), 0, nx, 0, 2, 0, 1);
+  CHECK(std::all_of(muted.begin(), muted.end(),
+                    [](float f) { return f == 0 || f == kFill; }));
+  {
+    segy::SegyIO other(name);
+    other.setVerbose(false);
+    other.setDetectDead(true);
+    other.scan();
+    CHECK(other.dead_count() == segy.dead_count());
+    CHECK(segy.dead_count() == dead + 2 - (vol[0] == kFill) -
+                                   (vol[nx] == kFill));
+  }
+  std::vector<float> first(expected.begin(), expected.begin() + 2 * nx);
+  for (float &f : first) {
+    f = f == kFill ? 0 : f;
+  }
+  segy.write(first.data(), 0, nx, 0, 2, 0, 1);
+  CHECK(segy.dead_count() == dead);
+
+  // the zone map is rebuilt with the new samples
+  segy.buildZoneMap();
+  CHECK(exists(name + segy::kZoneMapSuffix));
+  CHECK(segy.traces_exceeding(1e6f, 0, nx).empty());
+  segy.fill(2e6f, 0, 1, 2, 3, 1, 2);
+  CHECK(!exists(name + segy::kZoneMapSuffix));
+  std::vector<int64_t> hot = segy.traces_exceeding(1e6f, 0, nx);
+  CHECK(hot.size() == (vol[(ny + 2) * nx] == kFill ? 0u : 1u));
+
+  // the resampled traces can't be written back
+  segy.setResample(1000);
+  CHECK_THROWS(segy.write(patch.data(), x0, x1, y0, y1, z0, z1));
+  segy.setResample(0);
+  segy.fill(1, 0, 1, 0, 1, 0, 1);
+
+  CHECK_THROWS(segy.write(patch.data(), 0, nx + 1, 0, 1, 0, 1));
+  CHECK_THROWS(segy.write(patch.data(), 0, 1, 0, 1, -1, 1));
+  CHECK_THROWS(segy.fill(0, 2, 2, 0, 1, 0, 1));
+}
+
+} // namespace
+
+int main() {
+  test::write_volume("regular.sgy", 6, 5, 9);
+  std::set<std::pair<int, int>> missing = {{0, 0}, {1, 2}, {2, 3}, {4, 4}};
+  test::write_volume("irregular.sgy", 6, 5, 9, missing, false, 1);
+  test::write_volume("variable.sgy", 6, 5, 9, {}, true);
+  for (const char *name : {"regular.sgy", "irregular.sgy", "variable.sgy"}) {
+    for (segy::Backend backend : {segy::Backend::MMap, segy::Backend::PRead}) {
+      test_file(name, backend);
+    }
+  }
+
+  // a compressed file is read through its frames, there are no samples to
+  // write in place
+  test::write_file("update.sgy.zst",
+                   test::zstd_frame(test::read_file("regular.sgy")));
+  float v = 0;
+  CHECK_THROWS({
+    segy::SegyIO segy("update.sgy.zst");
+    segy.setVerbose(false);
+    segy.write(&v, 0, 1, 0, 1, 0, 1);
+  });
+  // the file can't be written
+  test::write_file("readonly.sgy", test::read_file("regular.sgy"));
+  chmod("readonly.sgy", 0444);
+  if (access("readonly.sgy", W_OK) != 0) {
+    segy::SegyIO segy("readonly.sgy");
+    segy.setVerbose(false);
+    CHECK_THROWS(segy.write(&v, 0, 1, 0, 1, 0, 1));
+  }
+  chmod("readonly.sgy", 0644);
+  return test::report();
+}
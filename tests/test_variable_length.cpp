@@ -0,0 +1,107 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_variable_length.cpp
+** @Time: 2026/10/20 06:24:40
+** @Version: 1.0
+** @Description : traces of different lengths in a rev 2 segy
+*********************************************************************/
+
+#include "common.h"
+
+namespace {
+
+const float kFill = -1;
+
+void test_volume(int format) {
+  std::set<std::pair<int, int>> missing = {{1, 0}, {2, 4}};
+  test::write_volume("variable.sgy", 6, 5, 9, missing, true, format);
+  std::vector<float> expected =
+      test::expected_volume(6, 5, 9, missing, true, kFill);
+
+  segy::SegyIO segy("variable.sgy");
+  segy.setVerbose(false);
+  segy.setFillNoValue(kFill);
+  segy.scan();
+  CHECK(segy.get_metaInfo().isVariableLength);
+  CHECK(segy.shape(0) == 9 && segy.shape(1) == 5 && segy.shape(2) == 6);
+  CHECK(segy.trace_count() == 6 * 5 - 2);
+  CHECK(test::read_all(segy) == expected);
+
+  // a patch starting past the end of the short traces
+  std::vector<float> patch(2 * 3 * 2);
+  segy.read(patch.data(), 7, 9, 1, 4, 2, 4);
+  bool ok = true;
+  for (int z = 0; z < 2; z++) {
+    for (int y = 0; y < 3; y++) {
+      for (int x = 0; x < 2; x++) {
+        ok &= patch[(z * 3 + y) * 2 + x] ==
+              expected[((z + 2) * 5 + y + 1) * 9 + x + 7];
+      }
+    }
+  }
+  CHECK(ok);
+}
+
+// the binary header tells 4 samples, a trace has 7: sizeX is the longest
+void test_longer_than_header() {
+  test::Layout layout;
+  layout.sizeX = 4;
+  layout.variable = true;
+  std::vector<test::Trace> traces = test::volume_traces(2, 3, 7);
+  for (size_t i = 0; i < traces.size(); i++) {
+    if (i != 4) {
+      traces[i].samples.resize(3);
+    }
+  }
+  test::write_segy("longer.sgy", layout, traces);
+
+  segy::SegyIO segy("longer.sgy");
+  segy.setVerbose(false);
+  segy.setFillNoValue(kFill);
+  segy.scan();
+  CHECK(segy.shape(0) == 7);
+  std::vector<float> data = test::read_all(segy);
+  CHECK(data[4 * 7 + 6] == test::value(1, 1, 6));
+  CHECK(data[0 * 7 + 2] == test::value(0, 0, 2) && data[0 * 7 + 3] == kFill);
+}
+
+// a truncated last trace is dropped
+void test_truncated() {
+  test::write_volume("truncated.sgy", 3, 4, 6, {}, true);
+  std::string bytes = test::read_file("truncated.sgy");
+  test::write_file("truncated.sgy", bytes.substr(0, bytes.size() - 8));
+
+  segy::SegyIO segy("truncated.sgy");
+  segy.setVerbose(false);
+  CHECK(segy.trace_count() == 3 * 4 - 1);
+}
+
+// a fixed length file read as variable gives the same samples
+void test_toggle() {
+  test::write_volume("fixed.sgy", 4, 3, 5);
+  segy::SegyIO segy("fixed.sgy");
+  segy.setVerbose(false);
+  std::vector<float> fixed = test::read_all(segy);
+  CHECK(fixed == test::expected_volume(4, 3, 5, {}, false, 0));
+  CHECK(!segy.get_metaInfo().isVariableLength);
+
+  segy.setVariableLength(true);
+  CHECK(segy.get_metaInfo().isVariableLength);
+  CHECK(test::read_all(segy) == fixed);
+  segy.setVariableLength(false);
+  CHECK(test::read_all(segy) == fixed);
+}
+
+} // namespace
+
+int main() {
+  test_volume(5);
+  test_volume(1);
+  test_longer_than_header();
+  test_truncated();
+  test_toggle();
+  return test::report();
+}
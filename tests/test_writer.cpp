@@ -0,0 +1,125 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_writer.cpp
+** @Time: 2026/10/20 13:49:12
+** @Version: 1.0
+** @Description : segy files written one block of inlines at a time
+*********************************************************************/
+
+#include <atomic>
+#include <thread>
+
+#include "common.h"
+#include "writer.h"
+
+namespace {
+
+std::vector<float> make_volume(int nx, int ny, int nz) {
+  std::vector<float> vol(static_cast<size_t>(nx) * ny * nz);
+  for (size_t i = 0; i < vol.size(); i++) {
+    vol[i] = static_cast<float>(i % 100000) * 0.5f - 3;
+  }
+  return vol;
+}
+
+// the blocks [starts[b], starts[b] + counts[b]) in reverse order, taken by
+// `threads` threads
+void write_blocks(int nx, int ny, int nz, int format, int threads,
+                  const std::vector<float> &vol,
+                  const std::vector<int> &starts,
+                  const std::vector<int> &counts) {
+  segy::SegyWriter writer(nx, ny, nz);
+  writer.setDataFormatCode(format);
+  writer.setSampleInterval(4000);
+  writer.setStartTime(8);
+  writer.setMinInline(20);
+  writer.setMinCrossline(5);
+  writer.open("writer.sgy");
+  CHECK(writer.shape(0) == nx && writer.shape(2) == nz);
+  CHECK_THROWS(writer.setSampleInterval(2000));
+  CHECK_THROWS(writer.open("writer.sgy"));
+  std::atomic<int> next(0);
+  auto work = [&]() {
+    size_t b;
+    while ((b = next++) < starts.size()) {
+      writer.write_lines(vol.data() + static_cast<size_t>(starts[b]) * ny * nx,
+                         starts[b], counts[b]);
+    }
+  };
+  std::vector<std::thread> pool;
+  for (int t = 1; t < threads; t++) {
+    pool.emplace_back(work);
+  }
+  work();
+  for (std::thread &t : pool) {
+    t.join();
+  }
+  CHECK(writer.lines_written() == nz);
+  writer.close();
+}
+
+// the file of create() but the creation time in the textual header
+void test_create(int nx, int ny, int nz, const std::vector<int> &starts,
+                 const std::vector<int> &counts) {
+  std::vector<float> vol = make_volume(nx, ny, nz);
+  for (int format : {5, 1}) {
+    segy::SegyIO segy(nx, ny, nz);
+    segy.setVerbose(false);
+    segy.setDataFormatCode(format);
+    segy.setSampleInterval(4000);
+    segy.setStartTime(8);
+    segy.setMinInline(20);
+    segy.setMinCrossline(5);
+    segy.create("create.sgy", vol.data());
+    std::string expected = test::read_file("create.sgy");
+    for (int threads : {1, 3}) {
+      write_blocks(nx, ny, nz, format, threads, vol, starts, counts);
+      std::string got = test::read_file("writer.sgy");
+      CHECK(got.size() == expected.size() &&
+            got.compare(3200, std::string::npos, expected, 3200,
+                        std::string::npos) == 0);
+    }
+  }
+}
+
+} // namespace
+
+int main() {
+  // lines larger than the buffer, a block is written by several pwrite
+  test_create(2200, 2000, 4, {2, 0}, {2, 2});
+  test_create(13, 6, 9, {7, 4, 2, 0}, {2, 3, 2, 2});
+
+  // the lines never written are zeros, a line written twice is counted
+  // once, the file is readable
+  int nx = 13, ny = 6, nz = 9;
+  std::vector<float> vol = make_volume(nx, ny, nz);
+  {
+    segy::SegyWriter writer(nx, ny, nz);
+    CHECK_THROWS(writer.write_lines(vol.data(), 0, 1));
+    writer.open("writer.sgy");
+    writer.write_lines(vol.data() + 3 * ny * nx, 3, 1);
+    writer.write_lines(vol.data() + 3 * ny * nx, 3, 1);
+    writer.write_lines(nullptr, 5, 1);
+    CHECK(writer.lines_written() == 2);
+    CHECK_THROWS(writer.write_lines(vol.data(), 8, 2));
+    CHECK_THROWS(writer.write_lines(vol.data(), -1, 1));
+    CHECK_THROWS(writer.write_lines(vol.data(), 0, 0));
+    // closed by the destructor
+  }
+  segy::SegyIO segy("writer.sgy");
+  segy.setVerbose(false);
+  std::vector<float> back = test::read_all(segy);
+  bool ok = back.size() == vol.size();
+  for (size_t i = 0; i < vol.size() && ok; i++) {
+    ok &= back[i] == (i / (nx * ny) == 3 ? vol[i] : 0.f);
+  }
+  CHECK(ok);
+
+  CHECK_THROWS(segy::SegyWriter(0, ny, nz));
+  segy::SegyWriter writer(nx, ny, nz);
+  CHECK_THROWS(writer.open("missing/writer.sgy"));
+  return test::report();
+}
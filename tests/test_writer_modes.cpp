@@ -0,0 +1,137 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_writer_modes.cpp
+** @Time: 2026/10/20 08:02:39
+** @Version: 1.0
+** @Description : the mmap and the streaming writers give the same files
+*********************************************************************/
+
+#include <unistd.h>
+
+#include "common.h"
+#include "output.h"
+
+namespace {
+
+const float kFill = -1;
+
+std::string tofile(const std::string &name, segy::WriteMode mode) {
+  segy::SegyIO segy(name);
+  segy.setVerbose(false);
+  segy.setFillNoValue(kFill);
+  segy.setWriteMode(mode);
+  segy.tofile("out.bin");
+  return test::read_file("out.bin");
+}
+
+void test_tofile() {
+  std::set<std::pair<int, int>> missing = {{1, 0}, {2, 5}, {3, 3}};
+  test::write_volume("irregular.sgy", 5, 6, 9, missing);
+  test::write_volume("variable.sgy", 5, 6, 9, {}, true);
+  test::write_volume("ibm.sgy", 4, 3, 7, {}, false, 1);
+  for (const char *name : {"irregular.sgy", "variable.sgy", "ibm.sgy"}) {
+    std::string mapped = tofile(name, segy::WriteMode::MMap);
+    std::string streamed = tofile(name, segy::WriteMode::Stream);
+    CHECK(!mapped.empty() && mapped == streamed);
+  }
+  // the samples of tofile() are the ones of read()
+  std::vector<float> data = test::read_floats("out.bin");
+  CHECK(data == test::expected_volume(4, 3, 7, {}, false, kFill));
+}
+
+// create() from memory and from a binary file, read back
+void test_create() {
+  const int nx = 50, ny = 30, nz = 20;
+  std::vector<float> src(nx * ny * nz);
+  for (size_t i = 0; i < src.size(); i++) {
+    src[i] = std::sin(i * 0.1f) * 1000;
+  }
+  test::write_file("src.bin", std::string(reinterpret_cast<char *>(
+                                              src.data()),
+                                          src.size() * sizeof(float)));
+
+  for (int format : {1, 5}) {
+    std::string files[3];
+    for (int i = 0; i < 3; i++) {
+      std::string name = "create" + std::to_string(i) + ".sgy";
+      segy::WriteMode mode =
+          i == 0 ? segy::WriteMode::MMap : segy::WriteMode::Stream;
+      if (i < 2) {
+        segy::SegyIO out(nx, ny, nz);
+        out.setVerbose(false);
+        out.setDataFormatCode(format);
+        out.setWriteMode(mode);
+        out.create(name, src.data());
+      } else {
+        segy::SegyIO out("src.bin", nx, ny, nz);
+        out.setVerbose(false);
+        out.setDataFormatCode(format);
+        out.setWriteMode(mode);
+        out.create(name);
+      }
+      files[i] = test::read_file(name);
+      CHECK(files[i].size() == 3600 + static_cast<size_t>(ny) * nz *
+                                          (240 + nx * sizeof(float)));
+
+      segy::SegyIO in(name);
+      in.setVerbose(false);
+      std::vector<float> back = test::read_all(in);
+      float error = 0;
+      for (size_t k = 0; k < src.size(); k++) {
+        error = std::max(error, std::fabs(back[k] - src[k]));
+      }
+      CHECK(error <= (format == 1 ? 1e-3f : 0.f));
+    }
+    // the textual headers tell the file names
+    CHECK(files[0].substr(3200) == files[1].substr(3200));
+    CHECK(files[0].substr(3200) == files[2].substr(3200));
+  }
+}
+
+// small buffers: many swaps and writes across the buffer ends
+void test_stream_writer() {
+  int fd = segy::create_file("stream.bin", 0);
+  std::string expected;
+  {
+    segy::StreamWriter writer(fd, 0, 4096);
+    std::string big(100000, 0);
+    for (size_t i = 0; i < big.size(); i++) {
+      big[i] = 'a' + i % 26;
+    }
+    writer.write(big.data(), big.size());
+    expected += big;
+    for (int i = 0; i < 3000; i++) {
+      char *p = writer.reserve(7);
+      memcpy(p, "0123456", 7);
+      writer.commit(7);
+      expected += "0123456";
+    }
+    writer.close();
+  }
+  close(fd);
+  CHECK(test::read_file("stream.bin") == expected);
+}
+
+// an output that can't be created throws
+void test_bad_output() {
+  test::write_volume("small.sgy", 2, 3, 4);
+  for (auto mode : {segy::WriteMode::MMap, segy::WriteMode::Stream}) {
+    segy::SegyIO segy("small.sgy");
+    segy.setVerbose(false);
+    segy.setWriteMode(mode);
+    CHECK_THROWS(segy.tofile("no/such/dir/out.bin"));
+  }
+}
+
+} // namespace
+
+int main() {
+  test_tofile();
+  test_create();
+  test_stream_writer();
+  test_bad_output();
+  return test::report();
+}
@@ -0,0 +1,173 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: test_zonemap.cpp
+** @Time: 2026/10/20 10:14:36
+** @Version: 1.0
+** @Description : the per-trace amplitude zone map and its .zmap file
+*********************************************************************/
+
+#include <algorithm>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "common.h"
+#include "zonemap.h"
+
+namespace {
+
+// the zone map of `traces` computed here
+segy::ZoneMap brute_force(const std::vector<test::Trace> &traces, int sizeX,
+                          int window) {
+  segy::ZoneMap map;
+  map.trace_count = traces.size();
+  map.window = window;
+  map.nwindows = (sizeX + window - 1) / window;
+  for (const test::Trace &t : traces) {
+    for (int iw = 0; iw < map.nwindows; iw++) {
+      int begin = iw * window;
+      int end = std::min<int>(begin + window, t.samples.size());
+      float lo = 0, hi = 0;
+      double sum2 = 0;
+      for (int x = begin; x < end; x++) {
+        float v = t.samples[x];
+        lo = x == begin ? v : std::min(lo, v);
+        hi = x == begin ? v : std::max(hi, v);
+        sum2 += static_cast<double>(v) * v;
+      }
+      map.min.push_back(lo);
+      map.max.push_back(hi);
+      map.rms.push_back(end > begin ? std::sqrt(sum2 / (end - begin)) : 0);
+    }
+  }
+  return map;
+}
+
+bool same(const segy::ZoneMap &a, const segy::ZoneMap &b) {
+  bool ok = a.trace_count == b.trace_count && a.nwindows == b.nwindows &&
+            a.min == b.min && a.max == b.max;
+  for (size_t i = 0; ok && i < a.rms.size(); i++) {
+    ok &= std::fabs(a.rms[i] - b.rms[i]) <= 1e-5 * (1 + b.rms[i]);
+  }
+  return ok;
+}
+
+void test_values(const std::string &name,
+                 const std::vector<test::Trace> &traces, int sizeX) {
+  for (auto backend : {segy::Backend::MMap, segy::Backend::PRead}) {
+    for (int threads : {1, 3}) {
+      for (int window : {4, 0}) {
+        unlink((name + segy::kZoneMapSuffix).c_str());
+        segy::SegyIO segy(name, backend);
+        segy.setVerbose(false);
+        segy.setThreads(threads);
+        segy.buildZoneMap(window);
+        const segy::ZoneMap &map = segy.zone_map();
+        segy::ZoneMap expected =
+            brute_force(traces, sizeX, window == 0 ? sizeX : window);
+        CHECK(same(map, expected));
+        CHECK(map.window == (window == 0 ? sizeX : window));
+
+        // the traces exceeding a threshold in samples [5, 7)
+        if (window == 4) {
+          std::vector<int64_t> exceeding;
+          for (size_t i = 0; i < traces.size(); i++) {
+            if (expected.peak(i * expected.nwindows + 1) > 50000) {
+              exceeding.push_back(i);
+            }
+          }
+          CHECK(segy.traces_exceeding(50000, 5, 7) == exceeding);
+          CHECK_THROWS(segy.traces_exceeding(1, 0, sizeX + 1));
+        }
+        float top = *std::max_element(map.max.begin(), map.max.end());
+        CHECK(segy.clip_estimate(100) == top);
+        CHECK(segy.clip_estimate(0) > 0 && segy.clip_estimate(0) <= top);
+        CHECK_THROWS(segy.clip_estimate(101));
+
+        // saved, and loaded by the next reader
+        segy::SegyIO again(name, backend);
+        again.setVerbose(false);
+        again.buildZoneMap(window);
+        CHECK(same(again.zone_map(), map));
+      }
+    }
+  }
+}
+
+// the .zmap file is used while it matches the segy file
+void test_reuse() {
+  test::write_volume("reuse.sgy", 5, 4, 9);
+  std::string zmap = std::string("reuse.sgy") + segy::kZoneMapSuffix;
+  unlink(zmap.c_str());
+  {
+    segy::SegyIO segy("reuse.sgy");
+    segy.setVerbose(false);
+    segy.buildZoneMap(4);
+  }
+  segy::ZoneMap map;
+  CHECK(segy::load_zonemap(zmap, map));
+  map.min[1] = 12345;
+  segy::save_zonemap(zmap, map);
+  {
+    segy::SegyIO segy("reuse.sgy");
+    segy.setVerbose(false);
+    segy.buildZoneMap(4);
+    CHECK(segy.zone_map().min[1] == 12345);
+  }
+  // another window size is built again
+  {
+    segy::SegyIO segy("reuse.sgy");
+    segy.setVerbose(false);
+    segy.buildZoneMap(3);
+    CHECK(segy.zone_map().window == 3 && segy.zone_map().min[1] != 12345);
+  }
+  // a stale map (the segy file is newer) is built again
+  segy::save_zonemap(zmap, map);
+  struct stat st;
+  stat("reuse.sgy", &st);
+  struct utimbuf times = {st.st_atime, st.st_mtime + 10};
+  utime("reuse.sgy", &times);
+  {
+    segy::SegyIO segy("reuse.sgy");
+    segy.setVerbose(false);
+    segy.buildZoneMap(4);
+    CHECK(segy.zone_map().min[1] != 12345);
+  }
+  CHECK(!segy::load_zonemap("reuse.sgy", map));
+}
+
+// the windows of dead traces are zeros only with dead detection, a map
+// built without it isn't reused with it and the other way around
+void test_dead() {
+  std::vector<test::Trace> traces = test::volume_traces(3, 3, 8);
+  traces[1].code = 2;
+  test::Layout layout;
+  layout.sizeX = 8;
+  test::write_segy("dead.sgy", layout, traces);
+  unlink((std::string("dead.sgy") + segy::kZoneMapSuffix).c_str());
+  for (bool detect : {false, true, false}) {
+    segy::SegyIO segy("dead.sgy");
+    segy.setVerbose(false);
+    segy.setDetectDead(detect);
+    segy.buildZoneMap();
+    CHECK(segy.zone_map().detect_dead == detect);
+    CHECK(segy.zone_map().max[1] == (detect ? 0 : test::value(0, 1, 7)));
+    CHECK(segy.zone_map().max[0] == test::value(0, 0, 7));
+  }
+}
+
+} // namespace
+
+int main() {
+  std::set<std::pair<int, int>> missing = {{1, 0}, {2, 5}};
+  test::write_volume("irregular.sgy", 6, 7, 11, missing);
+  test_values("irregular.sgy", test::volume_traces(6, 7, 11, missing), 11);
+  test::write_volume("variable.sgy", 6, 5, 9, {}, true);
+  test_values("variable.sgy", test::volume_traces(6, 5, 9, {}, true), 9);
+  test_reuse();
+  test_dead();
+  return test::report();
+}
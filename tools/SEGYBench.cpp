@@ -0,0 +1,168 @@
+/*********************************************************************
+** Copyright (c) 2022 Roger Lee.
+** Computational and Interpretation Group (CIG),
+** University of Science and Technology of China (USTC).
+**
+** @File: SEGYBench.cpp
+** @Time: 2026/10/19 16:40:12
+** @Version: 1.0
+** @Description : compare the throughput of the storage backends
+*********************************************************************/
+
+#include "cxxopts.hpp"
+#include "segy.h"
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <random>
+#include <stdexcept>
+#include <unistd.h>
+#include <vector>
+
+// at most 256 MB for one read() call
+const uint64_t kChunkSize = 256 * 1024 * 1024;
+
+// evict the file from the page cache, so each run starts cold
+static void drop_cache(const std::string &name) {
+#ifdef POSIX_FADV_DONTNEED
+  int fd = open(name.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+#endif
+}
+
+// returns the bytes of trace data that are read
+static uint64_t run(segy::SegyIO &segyio, const std::string &mode, int count,
+                    std::mt19937 &rng) {
+  int sizeX = segyio.shape(0);
+  int sizeY = segyio.shape(1);
+  int sizeZ = segyio.shape(2);
+  uint64_t trace_bytes = sizeX * sizeof(float) + segy::kTraceHeaderSize;
+  uint64_t line_bytes = static_cast<uint64_t>(sizeX) * sizeY * sizeof(float);
+
+  if (mode == "full") {
+    int lines = static_cast<int>(
+        std::max<uint64_t>(1, std::min<uint64_t>(kChunkSize / line_bytes,
+                                                 sizeZ)));
+    std::vector<float> buffer(line_bytes / sizeof(float) * lines);
+    for (int iZ = 0; iZ < sizeZ; iZ += lines) {
+      int endZ = std::min(iZ + lines, sizeZ);
+      segyio.read(buffer.data(), 0, sizeX, 0, sizeY, iZ, endZ);
+    }
+    return static_cast<uint64_t>(sizeY) * sizeZ * trace_bytes;
+  } else if (mode == "inline") {
+    std::vector<float> buffer(line_bytes / sizeof(float));
+    std::uniform_int_distribution<int> dist(0, sizeZ - 1);
+    for (int i = 0; i < count; i++) {
+      int iZ = dist(rng);
+      segyio.read(buffer.data(), 0, sizeX, 0, sizeY, iZ, iZ + 1);
+    }
+    return static_cast<uint64_t>(count) * sizeY * trace_bytes;
+  } else if (mode == "time") {
+    std::vector<float> buffer(static_cast<uint64_t>(sizeY) * sizeZ);
+    std::uniform_int_distribution<int> dist(0, sizeX - 1);
+    for (int i = 0; i < count; i++) {
+      int iX = dist(rng);
+      segyio.read(buffer.data(), iX, iX + 1, 0, sizeY, 0, sizeZ);
+    }
+    return static_cast<uint64_t>(count) * sizeY * sizeZ * sizeof(float);
+  }
+  throw std::runtime_error(
+      fmt::format("Unknown mode: {}, can be full, inline or time", mode));
+}
+
+int main(int argc, char *argv[]) {
+  cxxopts::Options options(
+      argv[0], fmt::format("{} - compare the throughput of the storage "
+                           "backends (mmap, pread, io_uring)",
+                           argv[0]));
+  options.add_options()("i,input", "input segy file: (Required)",
+                        cxxopts::value<std::string>())(
+      "b,backends", "backends to compare, default is mmap,pread,io_uring",
+      cxxopts::value<std::vector<std::string>>())(
+      "m,mode",
+      "full: read the whole volume, inline: random inline slices, time: "
+      "random time slices, default is full",
+      cxxopts::value<std::string>())(
+      "n,count", "number of slices of inline/time mode, default is 16",
+      cxxopts::value<int>())("r,repeat", "runs of each backend, default is 3",
+                             cxxopts::value<int>())(
+      "cold", "evict the file from the page cache before each run")(
+      "z,inline-loc", "inline field in trace header, default is 189",
+      cxxopts::value<int>())("c,crossline-loc",
+                             "crossline field in trace header, default is 193",
+                             cxxopts::value<int>());
+
+  options.parse_positional("input");
+  options.add_example(
+      fmt::format("{} --cold f3.segy : full reads, cold cache", argv[0]));
+  options.add_example(fmt::format(
+      "{} -m time -n 32 -b pread,io_uring f3.segy : random time slices",
+      argv[0]));
+
+  auto args = options.parse(argc, argv);
+  if (argc == 1) {
+    fmt::print("{}", options.help());
+    exit(0);
+  }
+  if (!args.count("i")) {
+    throw std::runtime_error("Missing input segy file");
+  }
+
+  std::string segy_name = args["i"].as<std::string>();
+  std::vector<std::string> backends = {"mmap", "pread", "io_uring"};
+  if (args.count("b")) {
+    backends = args["b"].as<std::vector<std::string>>();
+  }
+  std::string mode = args.count("m") ? args["m"].as<std::string>() : "full";
+  int count = args.count("n") ? args["n"].as<int>() : 16;
+  int repeat = args.count("r") ? args["r"].as<int>() : 3;
+
+  for (const std::string &name : backends) {
+    segy::Backend backend;
+    if (name == "mmap") {
+      backend = segy::Backend::MMap;
+    } else if (name == "pread") {
+      backend = segy::Backend::PRead;
+    } else if (name == "io_uring") {
+      backend = segy::Backend::IOUring;
+    } else {
+      throw std::runtime_error(fmt::format("Unknown backend: {}", name));
+    }
+
+    segy::SegyIO segyio(segy_name, backend);
+    segyio.setVerbose(false);
+    if (args.count("z")) {
+      segyio.setInlineLocation(args["z"].as<int>());
+    }
+    if (args.count("c")) {
+      segyio.setCrosslineLocation(args["c"].as<int>());
+    }
+    segyio.scan();
+    if (segyio.backend() != backend) {
+      // it fell back to another backend, which is benchmarked by its name
+      fmt::print("{:>8}: unavailable, skipped\n", name);
+      continue;
+    }
+
+    std::mt19937 rng(0);
+    for (int r = 0; r < repeat; r++) {
+      if (args.count("cold")) {
+        drop_cache(segy_name);
+      }
+      auto start = std::chrono::high_resolution_clock::now();
+      uint64_t bytes = run(segyio, mode, count, rng);
+      auto end = std::chrono::high_resolution_clock::now();
+      double seconds =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+              .count() *
+          1e-9;
+      fmt::print("{:>8} run {}: {:.3f}s, {:.1f} MB/s\n", name, r, seconds,
+                 bytes / seconds / 1024 / 1024);
+    }
+    segyio.close_file();
+  }
+}
@@ -9,8 +9,10 @@
 ** @Description :
 *********************************************************************/
 
+#include "compress.h"
 #include "cxxopts.hpp"
 #include "segy.h"
+#include "stream.h"
 #include <cmath>
 #include <fmt/format.h>
 #include <stdexcept>
@@ -32,6 +34,21 @@ int main(int argc, char *argv[]) {
       "p,print_textual_header",
       "print 3200 bytes textual header")("m,meta_info", "print meta info")(
       "ignore-header", "reading segy by ignoring header and specify shape")(
+      "s,stream",
+      "read the input sequentially (pipes, tapes), '-' as input is stdin")(
+      "j,threads", "decode threads of the conversion, default is one per core",
+      cxxopts::value<int>())("memory",
+                             "memory (MB) of the blocks in flight of the "
+                             "conversion, default is 512",
+                             cxxopts::value<int>())(
+      "direct", "write the output with O_DIRECT, bypassing the page cache")(
+      "sparse", "leave the zero pages (e.g., missing traces filled with 0) "
+                "as holes of a sparse output file")(
+      "dead", "find the dead traces (dead code or all zero), they are "
+              "filled without decoding")(
+      "resample", "resample the traces to this sample interval (us) while "
+                  "decoding them",
+      cxxopts::value<int>())(
       "d,dimensions",
       "the dimensions (x, y, z) or (nt, ncrossline, ninline), use as '-d "
       "128,128,256' (Required)",
@@ -50,6 +67,12 @@ int main(int argc, char *argv[]) {
       "{} -o f3.dat -z 5 f3.segy : convert by specify inline field", argv[0]));
   options.add_example(fmt::format(
       "{} -o f3.dat -f nan f3.segy : convert and fill with nan", argv[0]));
+  options.add_example(fmt::format(
+      "gunzip -c f3.segy.gz | {} -o f3.dat - : convert from stdin", argv[0]));
+  options.add_example(fmt::format(
+      "{} -o f3.dat f3.segy.zst  : convert a compressed file", argv[0]));
+  options.add_example(fmt::format(
+      "{} -o f3.dat --resample 4000 f3.segy : convert at 4 ms", argv[0]));
   options.add_example(fmt::format("{} -o f3.dat --ignore-header -d 236,789,890 "
                                   "f3.segy : ignore header and specify shape",
                                   argv[0]));
@@ -66,6 +89,44 @@ int main(int argc, char *argv[]) {
   std::string segy_name = args["i"].as<std::string>();
   fmt::print("Read segy file from: {}\n", segy_name);
 
+  // gzip can't be read randomly, zstd files with many frames can
+  if (args.count("s") || segy_name == "-" ||
+      segy::file_compression(segy_name) == segy::Compression::Gzip) {
+    if (args.count("ignore-header") || args.count("m")) {
+      throw std::runtime_error(
+          "'--ignore-header' and '-m' are unavailable when reading a stream");
+    }
+    segy::SegyStream stream(segy_name);
+    if (args.count("p")) {
+      fmt::print("textual header:\n{}\n", stream.textual_header());
+    }
+    if (args.count("z")) {
+      stream.setInlineLocation(args["z"].as<int>());
+    }
+    if (args.count("c")) {
+      stream.setCrosslineLocation(args["c"].as<int>());
+    }
+    if (args.count("f")) {
+      float fills = 0;
+      if (args["f"].as<std::string>() == "nan" ||
+          args["f"].as<std::string>() == "NAN") {
+        fills = NAN;
+      }
+      stream.setFillNoValue(fills);
+    }
+    if (args.count("o")) {
+      std::string out_name = args["o"].as<std::string>();
+      fmt::print("Write binary file to: {}\n", out_name);
+      stream.tofile(out_name);
+      segy::MetaInfo meta = stream.get_metaInfo();
+      fmt::print("shape: (n-time, n-crossline, n-inline) = ({}, {}, {}), "
+                 "inline start: {}, crossline start: {}\n",
+                 meta.sizeX, meta.sizeY, meta.sizeZ, meta.min_inline,
+                 meta.min_crossline);
+    }
+    return 0;
+  }
+
   segy::SegyIO segyio(segy_name);
 
   if (args.count("ignore-header")) {
@@ -99,11 +160,22 @@ int main(int argc, char *argv[]) {
     segyio.setFillNoValue(fills);
   }
 
+  if (args.count("dead")) {
+    segyio.setDetectDead(true);
+  }
+
+  if (args.count("resample")) {
+    segyio.setResample(args["resample"].as<int>());
+  }
+
   if (args.count("m")) {
     if (args.count("ignore-header")) {
       throw std::runtime_error("You have ignored header (--ignore-header).");
     }
     fmt::print("meta information: \n{}\n", segyio.metaInfo());
+    if (args.count("dead")) {
+      fmt::print("dead traces: {}\n", segyio.dead_count());
+    }
   }
 
   if (args.count("o")) {
@@ -118,6 +190,17 @@ int main(int argc, char *argv[]) {
       }
       segyio.set_size(dims[0], dims[1], dims[2]);
     }
+    // the reading, decoding and writing overlap
+    segyio.setWriteMode(segy::WriteMode::Pipeline);
+    if (args.count("j")) {
+      segyio.setThreads(args["j"].as<int>());
+    }
+    if (args.count("memory")) {
+      segyio.setMemoryBudget(static_cast<uint64_t>(args["memory"].as<int>()) *
+                             1024 * 1024);
+    }
+    segyio.setDirectIO(args.count("direct") > 0);
+    segyio.setSparse(args.count("sparse") > 0);
     segyio.tofile(out_name);
     segyio.close_file();
   }